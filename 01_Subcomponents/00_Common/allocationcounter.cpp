@@ -0,0 +1,40 @@
+/**
+ * @file allocationcounter.cpp
+ * @brief Replaces the global operator new so heap allocations can be counted.
+ *
+ * Allocations are only counted while statistics are enabled; otherwise the replacement
+ * costs one flag check on top of malloc.
+ */
+
+#include <cstdlib>
+#include <new>
+#include "stats.hpp"
+
+namespace {
+    void* allocate(const size_t size, const size_t alignment) {
+        if (stats::enabled()) {
+            stats::countAllocation(size);
+        }
+        const size_t bytes = size == 0 ? 1 : size;
+        void* memory = alignment <= alignof(std::max_align_t)
+            ? std::malloc(bytes)
+            : std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+        if (memory == nullptr) {
+            throw std::bad_alloc();
+        }
+        return memory;
+    }
+}
+
+void* operator new(const size_t size) { return allocate(size, 0); }
+void* operator new[](const size_t size) { return allocate(size, 0); }
+void* operator new(const size_t size, const std::align_val_t alignment) { return allocate(size, static_cast<size_t>(alignment)); }
+void* operator new[](const size_t size, const std::align_val_t alignment) { return allocate(size, static_cast<size_t>(alignment)); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { std::free(memory); }
@@ -0,0 +1,28 @@
+/**
+ * @file defaults.hpp
+ * @brief Defines the defaults and limits of command line options that belong to other components.
+ *
+ * ArgParser reads them from here instead of including the server, the result cache, the
+ * thread pool and the tiled format; those components define their constants from these.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace defaults {
+    static constexpr uint32_t tileSize = 256;                       /* --tile-size */
+    static constexpr uint32_t maxTileSize = 4096;                   /* Largest --tile-size; a raw tile stays below 2^32 bytes */
+    static constexpr size_t serveCacheBytes = 256 * 1024 * 1024;    /* --serve-cache */
+    static constexpr uint64_t cacheBytes = uint64_t{1} << 30;       /* --cache-size */
+
+    /**
+     * @brief Number of threads without --threads: one per hardware thread.
+     */
+    [[nodiscard]] inline size_t threadCount() {
+        return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+}
@@ -0,0 +1,81 @@
+/**
+ * @file framebuffer.cpp
+ * @brief Implements the Framebuffer class.
+ */
+
+#include <new>
+#include <utility>
+#include "framebuffer.hpp"
+
+/**
+ * @brief Constructs a framebuffer able to hold an image of the given size.
+ *
+ * @param width Image width in pixels.
+ * @param height Image height in pixels.
+ */
+Framebuffer::Framebuffer(const ImageWidth width, const ImageHeight height) {
+    resize(width, height);
+}
+
+/**
+ * @brief Takes over the pixels of another framebuffer, which is left empty.
+ */
+Framebuffer::Framebuffer(Framebuffer&& other) noexcept {
+    *this = std::move(other);
+}
+
+/**
+ * @brief Takes over the pixels of another framebuffer, which is left empty.
+ *
+ * The moved-from framebuffer has no allocation and no dimensions, so a later resize()
+ * allocates again instead of writing through the released pointer.
+ */
+Framebuffer& Framebuffer::operator=(Framebuffer&& other) noexcept {
+    if (this != &other) {
+        pixels = std::move(other.pixels);
+        capacity = std::exchange(other.capacity, 0);
+        imageWidth = std::exchange(other.imageWidth, 0);
+        imageHeight = std::exchange(other.imageHeight, 0);
+        rowStride = std::exchange(other.rowStride, 0);
+    }
+    return *this;
+}
+
+/**
+ * @brief Changes the dimensions of the framebuffer.
+ *
+ * The existing allocation is reused when it is large enough, so a framebuffer can be
+ * recycled between images without touching the heap. Pixel contents are unspecified afterwards.
+ *
+ * @param width New image width in pixels.
+ * @param height New image height in pixels.
+ */
+void Framebuffer::resize(const ImageWidth width, const ImageHeight height) {
+    const size_t stride = strideFor(width);
+    const size_t required = stride * height;
+
+    if (required > capacity) {
+        pixels.reset(static_cast<Pixel*>(::operator new[](required * sizeof(Pixel), std::align_val_t{alignment})));
+        capacity = required;
+    }
+
+    imageWidth = width;
+    imageHeight = height;
+    rowStride = stride;
+}
+
+/**
+ * @brief Computes the row stride used for an image of the given width.
+ *
+ * @param width Image width in pixels.
+ * @return Width rounded up so that every row starts on an aligned boundary.
+ */
+size_t Framebuffer::strideFor(const ImageWidth width) {
+    constexpr size_t pixelsPerLine = alignment / sizeof(Pixel);
+    return (static_cast<size_t>(width) + pixelsPerLine - 1) / pixelsPerLine * pixelsPerLine;
+}
+
+/** @brief Releases a buffer allocated with the framebuffer alignment. */
+void Framebuffer::AlignedDelete::operator()(Pixel* buffer) const {
+    ::operator delete[](buffer, std::align_val_t{alignment});
+}
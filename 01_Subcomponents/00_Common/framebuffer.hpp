@@ -0,0 +1,62 @@
+/**
+ * @file framebuffer.hpp
+ * @brief Defines the Framebuffer class, a flat, 64-byte aligned RGB565 pixel buffer.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include "types.hpp"
+
+/**
+ * @class Framebuffer
+ * @brief Single contiguous block of packed RGB565 pixels with width, height and stride.
+ *
+ * Rows are stored one after another, each starting on a 64-byte boundary. Row `y`
+ * holds the pixels of image row `y` (row 0 is the bottom of the gradient).
+ */
+class Framebuffer {
+public:
+    static constexpr size_t alignment = 64;   /* Alignment of the buffer and of every row in bytes */
+
+    Framebuffer() = default;
+    Framebuffer(ImageWidth width, ImageHeight height);
+    ~Framebuffer() = default;
+
+    Framebuffer(Framebuffer&& other) noexcept;
+    Framebuffer& operator=(Framebuffer&& other) noexcept;
+    Framebuffer(const Framebuffer&) = delete;
+    Framebuffer& operator=(const Framebuffer&) = delete;
+
+    void resize(ImageWidth width, ImageHeight height);
+
+    [[nodiscard]] ImageWidth width() const { return imageWidth; }
+    [[nodiscard]] ImageHeight height() const { return imageHeight; }
+    [[nodiscard]] size_t stride() const { return rowStride; }
+    [[nodiscard]] Pixel* data() { return pixels.get(); }
+    [[nodiscard]] const Pixel* data() const { return pixels.get(); }
+    [[nodiscard]] Pixel* row(const ImageHeight y) { return pixels.get() + y * rowStride; }
+    [[nodiscard]] const Pixel* row(const ImageHeight y) const { return pixels.get() + y * rowStride; }
+    [[nodiscard]] Pixel& at(const ImageWidth x, const ImageHeight y) { return row(y)[x]; }
+    [[nodiscard]] Pixel at(const ImageWidth x, const ImageHeight y) const { return row(y)[x]; }
+
+    [[nodiscard]] static size_t strideFor(ImageWidth width);
+
+private:
+    struct AlignedDelete {
+        void operator()(Pixel* buffer) const;
+    };
+
+    std::unique_ptr<Pixel[], AlignedDelete> pixels;
+    size_t capacity = 0;        /* Number of allocated pixels */
+    ImageWidth imageWidth = 0;
+    ImageHeight imageHeight = 0;
+    size_t rowStride = 0;       /* Distance between rows in pixels */
+};
+
+/**
+ * @typedef ResultGradient
+ * @brief Flat framebuffer of packed RGB565 pixels representing the final color gradient.
+ */
+using ResultGradient = Framebuffer;
@@ -0,0 +1,30 @@
+/**
+ * @file replicate.hpp
+ * @brief Fills memory with copies of its own beginning, used by the degenerate gradient shapes.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace replicate {
+    /**
+     * @brief Repeats the first pattern bytes of data until total bytes are filled.
+     *
+     * The filled part is doubled with every memcpy, so a row or band is written at memory
+     * bandwidth in log2(total / pattern) calls; total need not be a multiple of pattern.
+     *
+     * @param data Memory whose first pattern bytes are set.
+     * @param pattern Bytes to repeat, not 0.
+     * @param total Bytes of data to fill.
+     */
+    inline void repeat(char* data, const size_t pattern, const size_t total) {
+        for (size_t filled = pattern; filled < total;) {
+            const size_t chunk = std::min(filled, total - filled);
+            std::memcpy(data + filled, data, chunk);
+            filled += chunk;
+        }
+    }
+}
@@ -47,5 +47,21 @@ namespace rgb565 {
         static constexpr uint8_t max5Bit = 0x1F, max6Bit = 0x3F;
 
         void setColor(const uint8_t value, const Color selectedColor);
+
+        /**
+         * @brief Packs the channels into a single 16-bit RGB565 value.
+         */
+        [[nodiscard]] constexpr uint16_t pack() const {
+            return static_cast<uint16_t>(red << redShift | green << greenShift | blue << blueShift);
+        }
     };
+
+    /**
+     * @brief Splits a packed 16-bit RGB565 value into its channels.
+     */
+    [[nodiscard]] constexpr RGB565 unpack(const uint16_t color) {
+        return RGB565{static_cast<uint8_t>((color & redMask) >> redShift),
+                      static_cast<uint8_t>((color & greenMask) >> greenShift),
+                      static_cast<uint8_t>((color & blueMask) >> blueShift)};
+    }
 }
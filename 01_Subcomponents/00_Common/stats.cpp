@@ -0,0 +1,183 @@
+/**
+ * @file stats.cpp
+ * @brief Implements the per-stage statistics.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <ios>
+#include "stats.hpp"
+#include "display.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GRADIENT_HAS_RUSAGE 1
+#include <sys/resource.h>
+#endif
+
+namespace {
+    /* Accumulated time of one stage */
+    struct StageTotals {
+        std::atomic<uint64_t> wallNanoseconds{0};
+        std::atomic<uint64_t> cpuNanoseconds{0};
+    };
+
+    const char* const stageNames[stats::stageCount] = {"parse", "generate", "encode", "write", "decode"};
+
+    StageTotals stages[stats::stageCount];
+    std::atomic<uint64_t> pixels{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> allocationCount{0};
+    std::atomic<uint64_t> allocationBytes{0};
+    stats::Sample origin;
+
+    uint64_t wallClock() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    uint64_t threadCpuClock() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+        timespec now{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+#else
+        return 0;
+#endif
+    }
+
+    double seconds(const uint64_t nanoseconds) {
+        return static_cast<double>(nanoseconds) / 1e9;
+    }
+}
+
+/**
+ * @brief Starts collecting statistics.
+ *
+ * @param start Clock readings taken when the run started; the total wall time is measured from it.
+ */
+void stats::enable(const Sample& start) {
+    origin = start;
+    detail::active.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Reads the clocks.
+ *
+ * @param wall Read the monotonic wall clock.
+ * @param cpu Read the CPU time of the calling thread.
+ */
+stats::Sample stats::sample(const bool wall, const bool cpu) {
+    return Sample{wall ? wallClock() : 0, cpu ? threadCpuClock() : 0};
+}
+
+/**
+ * @brief Adds the time elapsed since start to a stage.
+ */
+void stats::record(const Stage stage, const Sample& start, const bool wall, const bool cpu) {
+    StageTotals& totals = stages[static_cast<size_t>(stage)];
+    if (wall) {
+        totals.wallNanoseconds.fetch_add(wallClock() - start.wallNanoseconds, std::memory_order_relaxed);
+    }
+    if (cpu) {
+        totals.cpuNanoseconds.fetch_add(threadCpuClock() - start.cpuNanoseconds, std::memory_order_relaxed);
+    }
+}
+
+void stats::detail::addPixels(const uint64_t count) {
+    pixels.fetch_add(count, std::memory_order_relaxed);
+}
+
+void stats::detail::addBytes(const uint64_t count) {
+    bytes.fetch_add(count, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Counts a heap allocation; called by the replaced global operator new while enabled.
+ */
+void stats::countAllocation(const size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+/** @brief Number of heap allocations since statistics were enabled. */
+uint64_t stats::allocations() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+/** @brief Bytes requested from the heap since statistics were enabled. */
+uint64_t stats::allocatedBytes() {
+    return allocationBytes.load(std::memory_order_relaxed);
+}
+
+/** @brief Peak resident set size of the process in bytes, 0 where unknown. */
+uint64_t stats::peakResidentBytes() {
+#ifdef GRADIENT_HAS_RUSAGE
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Prints the statistics to stderr.
+ *
+ * Stages running concurrently (e.g. with --stream) overlap, so their wall times may add
+ * up to more than the total.
+ */
+void stats::report() {
+    char line[160];
+    display::error("Stage          wall ms       cpu ms");
+    for (size_t i = 0; i < stageCount; i++) {
+        std::snprintf(line, sizeof(line), "%-10s %11.3f  %11.3f", stageNames[i],
+                      seconds(stages[i].wallNanoseconds.load()) * 1e3, seconds(stages[i].cpuNanoseconds.load()) * 1e3);
+        display::error(line);
+    }
+    std::snprintf(line, sizeof(line), "Total wall time: %.3f ms", seconds(wallClock() - origin.wallNanoseconds) * 1e3);
+    display::error(line);
+    std::snprintf(line, sizeof(line), "Pixels: %llu, bytes written: %llu, peak RSS: %llu KiB",
+                  static_cast<unsigned long long>(pixels.load()), static_cast<unsigned long long>(bytes.load()),
+                  static_cast<unsigned long long>(peakResidentBytes() / 1024));
+    display::error(line);
+    std::snprintf(line, sizeof(line), "Allocations: %llu (%llu bytes)",
+                  static_cast<unsigned long long>(allocations()), static_cast<unsigned long long>(allocatedBytes()));
+    display::error(line);
+}
+
+/**
+ * @brief Writes the statistics as a JSON object.
+ *
+ * @param path Destination file.
+ * @throws std::ios_base::failure If the file cannot be written.
+ */
+void stats::writeJson(const std::string& path) {
+    std::ofstream file(path);
+    char line[200];
+    file << "{\n  \"stages\": {\n";
+    for (size_t i = 0; i < stageCount; i++) {
+        std::snprintf(line, sizeof(line), "    \"%s\": {\"wall_seconds\": %.9f, \"cpu_seconds\": %.9f}%s\n", stageNames[i],
+                      seconds(stages[i].wallNanoseconds.load()), seconds(stages[i].cpuNanoseconds.load()),
+                      i + 1 < stageCount ? "," : "");
+        file << line;
+    }
+    std::snprintf(line, sizeof(line), "  },\n  \"wall_seconds\": %.9f,\n", seconds(wallClock() - origin.wallNanoseconds));
+    file << line
+         << "  \"pixels\": " << pixels.load() << ",\n"
+         << "  \"bytes_written\": " << bytes.load() << ",\n"
+         << "  \"peak_rss_bytes\": " << peakResidentBytes() << ",\n"
+         << "  \"allocations\": " << allocations() << ",\n"
+         << "  \"allocated_bytes\": " << allocatedBytes() << "\n}\n";
+    file.close();
+    if (!file) {
+        throw std::ios_base::failure("Could not write statistics to " + path);
+    }
+}
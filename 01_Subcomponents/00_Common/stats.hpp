@@ -0,0 +1,103 @@
+/**
+ * @file stats.hpp
+ * @brief Declares the per-stage timing and counters reported by --stats and --stats-json.
+ *
+ * Instrumentation stays compiled in. While it is disabled every probe is a single relaxed
+ * load of a flag, so no clock is read and no counter is touched.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace stats {
+    /**
+     * @enum Stage
+     * @brief Phases of a run that time is attributed to.
+     */
+    enum class Stage {
+        PARSE,      /* Command line parsing */
+        GENERATE,   /* Interpolation of the pixels */
+        ENCODE,     /* Formatting rows into the output encoding */
+        WRITE,      /* Handing encoded bytes to the operating system */
+        DECODE      /* Parsing the pixels of an existing file (--verify) */
+    };
+    static constexpr size_t stageCount = 5;
+
+    /* Clock readings; cpu is the CPU time of the calling thread */
+    struct Sample {
+        uint64_t wallNanoseconds = 0;
+        uint64_t cpuNanoseconds = 0;
+    };
+
+    namespace detail {
+        inline std::atomic<bool> active{false};
+        void addPixels(uint64_t pixels);
+        void addBytes(uint64_t bytes);
+    }
+
+    /** @brief Tells whether statistics are being collected. */
+    [[nodiscard]] inline bool enabled() {
+        return detail::active.load(std::memory_order_relaxed);
+    }
+
+    void enable(const Sample& origin);
+    [[nodiscard]] Sample sample(bool wall = true, bool cpu = true);
+    void record(Stage stage, const Sample& start, bool wall, bool cpu);
+
+    /** @brief Counts generated pixels. */
+    inline void addPixels(const uint64_t pixels) {
+        if (enabled()) {
+            detail::addPixels(pixels);
+        }
+    }
+
+    /** @brief Counts bytes handed to the output. */
+    inline void addBytes(const uint64_t bytes) {
+        if (enabled()) {
+            detail::addBytes(bytes);
+        }
+    }
+
+    void countAllocation(size_t bytes);
+    [[nodiscard]] uint64_t allocations();
+    [[nodiscard]] uint64_t allocatedBytes();
+    [[nodiscard]] uint64_t peakResidentBytes();
+
+    void report();
+    void writeJson(const std::string& path);
+
+    /**
+     * @class Scope
+     * @brief Attributes the time between construction and destruction to a stage.
+     *
+     * Stages running on several threads use a WALL scope on the coordinating thread and CPU
+     * scopes inside the work items, so each thread's CPU time is counted once. Stages running
+     * on a single thread use BOTH.
+     */
+    class Scope {
+    public:
+        enum Measure { WALL = 1, CPU = 2, BOTH = 3 };
+
+        explicit Scope(const Stage stage, const Measure measure = BOTH)
+            : stage(stage), measure(enabled() ? measure : 0) {
+            if (this->measure != 0) {
+                start = sample(this->measure & WALL, this->measure & CPU);
+            }
+        }
+        ~Scope() {
+            if (measure != 0) {
+                record(stage, start, measure & WALL, measure & CPU);
+            }
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        Stage stage;
+        int measure;
+        Sample start;
+    };
+}
@@ -1,26 +1,51 @@
 /**
  * @file types.hpp
  * @brief Defines common types used across the project, including image dimensions,
- * pixel representation, interpolation types, and result gradient structures.
+ * pixel representation and interpolation types.
  */
 
 #pragma once
 
 #include <cstdint>
-#include <vector>
 #include "rgb565.hpp"
 
 /**
  * @typedef ImageHeight
  * @brief Represents the height of an image in pixels.
  */
-using ImageHeight = uint16_t;
+using ImageHeight = uint64_t;
 
 /**
  * @typedef ImageWidth
  * @brief Represents the width of an image in pixels.
  */
-using ImageWidth = uint16_t;
+using ImageWidth = uint64_t;
+
+/**
+ * @brief Largest accepted width or height.
+ *
+ * Up to this size the Q8.24 steps of the bilinear kernel accumulate less than half a
+ * channel level of error along a row or column, so the corner colors stay exact.
+ */
+static constexpr uint64_t maxImageDimension = uint64_t{1} << 24;
+
+/**
+ * @brief Version of the generated output, part of every result cache key.
+ *
+ * Bump it whenever a change alters the bytes written for any set of parameters.
+ */
+static constexpr const char* generatorVersion = "1.1";
+
+/**
+ * @struct Region
+ * @brief Rectangle of the full image, x and y counted from its top-left corner (--region).
+ */
+struct Region {
+    ImageWidth x = 0;
+    ImageHeight y = 0;
+    ImageWidth width = 0;
+    ImageHeight height = 0;
+};
 
 /**
  * @typedef Pixel
@@ -35,13 +60,50 @@ using Pixel = uint16_t;
  * @brief Defines the available interpolation methods for image generation.
  */
 enum class InterpolationType {
-    BILINEAR
+    BILINEAR,   /* Four corner colors */
+    LINEAR,     /* Color stops along a direction */
+    RADIAL,     /* Color stops from the center to the corners */
+    CONIC       /* Color stops around the center */
 };
 
 /**
- * @typedef ResultGradient
- * @brief 2D vector of RGB565 pixels representing the final color gradient.
- *
- * Each element in the vector represents a row of pixels.
+ * @enum RowShape
+ * @brief Degenerate cases of the four-corner model, for which rows need not be interpolated.
+ */
+enum class RowShape {
+    GENERAL,        /* Rows differ and vary along x */
+    SOLID,          /* All corners equal: every pixel has the same color */
+    HORIZONTAL,     /* tl == bl and tr == br: every row is the same */
+    VERTICAL        /* tl == tr and bl == br: every row is a single color */
+};
+
+/** @brief Tells whether every row of an image of this shape equals every other row. */
+[[nodiscard]] constexpr bool rowsIdentical(const RowShape shape) {
+    return shape == RowShape::SOLID || shape == RowShape::HORIZONTAL;
+}
+
+/** @brief Tells whether every row of an image of this shape is a single color. */
+[[nodiscard]] constexpr bool rowsConstant(const RowShape shape) {
+    return shape == RowShape::SOLID || shape == RowShape::VERTICAL;
+}
+
+/**
+ * @enum OutputFormat
+ * @brief Defines the available encodings of the output file.
+ */
+enum class OutputFormat {
+    TEXT,   /* "0x%04x" hex values, space separated, one line per row */
+    RAW,    /* Packed little-endian RGB565 values, top row first, no header */
+    RLE,    /* Header and run-length / row-delta coded rows, see compactformat.hpp */
+    TILED   /* Header, tile index and independently coded tiles, see tiledformat.hpp */
+};
+
+/**
+ * @enum IoBackend
+ * @brief Defines how the buffered writer hands encoded bytes to the operating system.
  */
-using ResultGradient = std::vector<std::vector<rgb565::RGB565>>;
+enum class IoBackend {
+    WRITE,      /* write(2) from a writer thread, through the page cache */
+    DIRECT,     /* O_DIRECT writes of aligned buffers from a writer thread, bypassing the page cache */
+    URING       /* Writes queued on an io_uring, no writer thread */
+};
@@ -3,28 +3,264 @@
  * @brief Implements the Generator class to control color gradient generation and file output.
  */
 
+#include <chrono>
+#include <cstdio>
 #include "generator.hpp"
+#include "animation.hpp"
+#include "batchrunner.hpp"
+#include "server.hpp"
+#include "display.hpp"
+#include "gradienttype.hpp"
+#include "memoryplanner.hpp"
+#include "mmapwriter.hpp"
+#include "pipeline.hpp"
+#include "rowformat.hpp"
+#include "simdkernel.hpp"
+#include "stats.hpp"
+#include "tiledformat.hpp"
+#include "verifier.hpp"
 
 /**
  * @brief Generator constructor.
  *
- * Initializes the argument parser, file handler, and interpolation object based on the given parameters.
+ * Initializes the argument parser, the interpolation selected with --gradient and the thread pool.
+ * In batch and server mode the interpolation objects are created per job instead, and animations
+ * use their own kernel. Opens the result
+ * cache when --cache is given. Enables verbose output when requested on the command line.
  *
  * @param argc Number of command line arguments.
  * @param argv Command line arguments.
- * @param interpolationType Specifies the type of interpolation to use.
  */
-Generator::Generator(int argc, char *argv[], InterpolationType interpolationType)
-    : args(std::make_shared<ArgParser>(argc, argv)),
-    fileHandler(args->getOutputPath()),
-    interpolator(InterpolationFactory::get(args, interpolationType))
-{}
+Generator::Generator(int argc, char *argv[])
+    : args(parse(argc, argv)),
+    interpolator(args->getBatchManifest().empty() && args->getServeSocket().empty() && args->getFrameCount() == 0
+                 ? InterpolationFactory::get(args->getParameters()) : nullptr),
+    pool(args->getThreadCount())
+{
+    display::setVerbose(args->isVerbose());
+    if (!args->getCacheDirectory().empty()) {
+        cache = std::make_unique<ResultCache>(args->getCacheDirectory(), args->getCacheBytes(), args->isCacheLinking());
+    }
+}
+
+/**
+ * @brief Parses the command line, timing it when statistics were requested.
+ *
+ * The clocks are read before parsing because only the parsed arguments tell whether
+ * statistics are wanted.
+ */
+std::shared_ptr<ArgParser> Generator::parse(int argc, char *argv[]) {
+    const stats::Sample start = stats::sample();
+    auto parsed = std::make_shared<ArgParser>(argc, argv);
+    if (parsed->isStatsReport() || !parsed->getStatsJson().empty()) {
+        stats::enable(start);
+        stats::record(stats::Stage::PARSE, start, true, true);
+    }
+    return parsed;
+}
 
 /**
  * @brief Executes the generation process and saves the result to the file.
  *
- * Generates a color gradient using the chosen interpolation method and writes it to the output file.
+ * Generates a color gradient using the chosen interpolation method, with row bands spread
+ * over the thread pool, and writes it to the output file. With --mmap the rows are encoded
+ * straight into the mapped output file, falling back to the buffered writer for pipes and stdout.
+ * Images whose framebuffer would exceed planner::inMemoryLimit are streamed out of core in
+ * bounded blocks; the throughput of those runs is always reported. With --max-memory the
+ * writer and its buffers are chosen to fit the budget (memoryplanner.hpp). With --cache a cached result
+ * is served without generating anything, and fresh results are added to the cache.
+ * With --batch every job of the manifest is run on the shared thread pool instead, and
+ * with --serve requests are served over a Unix socket until a client sends "quit". With
+ * --frames a sequence of frames with moving corners is rendered instead of one image, and with
+ * --verify the existing output file is checked against the arguments instead of being written.
+ *
+ * With --stats or --stats-json the statistics of the run are reported at the end.
+ *
+ * @return False if a batch job or the verification failed.
+ */
+bool Generator::run() {
+    bool succeeded = true;
+    display::verbose(std::string("SIMD path: ") + kernel::toString(kernel::activeSimdPath()));
+    display::verbose("Threads: " + std::to_string(pool.size()));
+
+    if (!args->getBatchManifest().empty()) {
+        BatchRunner batch(args->getBatchManifest(), pool, cache.get());
+        succeeded = batch.run();
+    } else if (!args->getServeSocket().empty()) {
+        GradientServer server(args->getServeSocket(), pool, args->getServeCacheBytes());
+        server.run();
+    } else if (args->getFrameCount() > 0) {
+        AnimationRunner animation(args, pool);
+        animation.run();
+    } else if (args->isVerifying()) {
+        Verifier verifier(args, *interpolator, pool);
+        succeeded = verifier.run();
+    } else {
+        writeSingle();
+    }
+    reportStats();
+    return succeeded;
+}
+
+/**
+ * @brief Prints and/or saves the statistics if they were requested.
+ */
+void Generator::reportStats() const {
+    if (!stats::enabled()) {
+        return;
+    }
+    if (!args->getStatsJson().empty()) {
+        stats::writeJson(args->getStatsJson());
+    }
+    if (args->isStatsReport()) {
+        stats::report();
+    }
+}
+
+/**
+ * @brief Generates the single image described on the command line.
+ */
+void Generator::writeSingle() {
+    display::verbose(std::string("Gradient: ") + gradienttype::toString(args->getInterpolationType()));
+    display::verbose(std::string("Format: ") + rowformat::toString(args->getOutputFormat()));
+    display::verbose(std::string("Rows: ") + gradienttype::toString(interpolator->shape()));
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool cached = cache && args->getOutputPath() != FileHandler::standardOutput;
+    const std::string key = cached ? ResultCache::keyFor(*args) : std::string();
+    if (cached && cache->fetch(key, args->getOutputPath())) {
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        display::verbose("Cache hit " + key + ", served in " + std::to_string(static_cast<uint64_t>(elapsed.count())) + " us");
+        return;
+    }
+
+    const Region region = args->getRegion();
+    const uint64_t imageBytes = Framebuffer::strideFor(region.width) * region.height * sizeof(Pixel);
+    const bool outOfCore = imageBytes > planner::inMemoryLimit;
+    const planner::Plan plan = planWrite();
+
+    switch (plan.strategy) {
+    case planner::Strategy::TILED:
+        writeTiled();
+        break;
+    case planner::Strategy::MAPPED:
+        writeMapped();
+        break;
+    default:
+        writeBuffered(plan);
+        break;
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    reportThroughput(elapsed.count(), outOfCore);
+    if (args->getMaxMemoryBytes() != 0) {
+        const uint64_t peak = stats::peakResidentBytes();
+        display::error("Peak memory: " + (peak != 0 ? planner::mebibytes(peak) : std::string("unknown")) + " of "
+                       + planner::mebibytes(args->getMaxMemoryBytes()));
+    }
+
+    if (cached) {
+        cache->insert(key, args->getOutputPath());
+        display::verbose("Cache miss " + key + ", result stored");
+    }
+}
+
+/**
+ * @brief Chooses the writer of the image and its buffer sizes.
+ *
+ * The plan is printed when --max-memory was given, and with --verbose otherwise. The memory
+ * the process holds at this point counts against the budget.
+ *
+ * @throws std::runtime_error If the image cannot be written within --max-memory.
  */
-void Generator::run() {
-    fileHandler.writeResults(interpolator->generate(), args->getImageHeight(), args->getImageWidth());
+planner::Plan Generator::planWrite() const {
+    const Region region = args->getRegion();
+    const bool mappable = args->getOutputFormat() != OutputFormat::RLE && MmapWriter::isSupported(args->getOutputPath());
+    if (args->isMapped() && !mappable) {
+        display::verbose("Output cannot be memory-mapped, using the buffered writer");
+    }
+
+    planner::Request request;
+    request.width = region.width;
+    request.height = region.height;
+    request.format = args->getOutputFormat();
+    request.tileSize = args->getTileSize();
+    request.streaming = args->isStreaming();
+    request.mapped = args->isMapped() && mappable;
+    request.budget = args->getMaxMemoryBytes();
+    request.baseline = request.budget != 0 ? stats::peakResidentBytes() : 0;
+    const planner::Plan plan = planner::plan(request);
+
+    if (request.mapped && plan.strategy != planner::Strategy::MAPPED) {
+        display::verbose("The mapped output exceeds --max-memory, using the buffered writer");
+    }
+    if (request.budget != 0) {
+        display::error("Plan: " + planner::describe(plan) + " of " + planner::mebibytes(request.budget));
+    } else {
+        display::verbose("Plan: " + planner::describe(plan));
+    }
+    return plan;
+}
+
+/**
+ * @brief Prints the number of generated pixels and the pixel rate.
+ *
+ * @param seconds Wall time spent generating and writing.
+ * @param always Print even when verbose output is disabled.
+ */
+void Generator::reportThroughput(const double seconds, const bool always) const {
+    const Region region = args->getRegion();
+    const double pixels = static_cast<double>(region.width) * static_cast<double>(region.height);
+    char message[128];
+    std::snprintf(message, sizeof(message), "Generated %.0f pixels in %.3f s (%.2f Mpixel/s)",
+                  pixels, seconds, seconds > 0.0 ? pixels / seconds / 1e6 : 0.0);
+    if (always) {
+        display::error(message);
+    } else {
+        display::verbose(message);
+    }
+}
+
+/**
+ * @brief Writes the image through a memory mapping of the output file.
+ */
+void Generator::writeMapped() {
+    display::verbose("Writer: mmap");
+    const Region region = args->getRegion();
+    MmapWriter writer(args->getOutputPath(), args->getOutputFormat(), region.width, region.height);
+    writer.write(*interpolator, pool);
+    writer.finish();
+}
+
+/**
+ * @brief Writes the image in the tiled format, one row of tiles at a time.
+ */
+void Generator::writeTiled() {
+    display::verbose("Writer: tiled, " + std::to_string(args->getTileSize()) + " pixel tiles");
+    tiled::Writer writer(args->getOutputPath(), tiled::headerFor(args->getParameters(), args->getTileSize()));
+    writer.write(*interpolator, pool);
+    writer.finish();
+}
+
+/**
+ * @brief Writes the image through the buffered FileHandler.
+ *
+ * In streaming mode the image is never materialized: blocks of rows are generated
+ * and written concurrently.
+ *
+ * @param plan In-memory or streaming plan giving the block and output buffer sizes.
+ */
+void Generator::writeBuffered(const planner::Plan& plan) {
+    FileHandler fileHandler(args->getOutputPath(), args->getOutputFormat(), compact::headerFor(args->getParameters()),
+                            args->getIoBackend(), plan.bufferBytes);
+
+    if (plan.strategy == planner::Strategy::STREAMING) {
+        display::verbose("Writer: streaming");
+        const Region region = args->getRegion();
+        StreamingPipeline pipeline(*interpolator, fileHandler, pool, plan.blockRows, plan.ringSize);
+        pipeline.run(region.width, region.height);
+    } else {
+        display::verbose("Writer: buffered");
+        fileHandler.writeResults(interpolator->generate(pool), interpolator->shape());
+    }
 }
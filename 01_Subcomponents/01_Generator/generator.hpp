@@ -9,22 +9,35 @@
 #include "argparser.hpp"
 #include "filehandler.hpp"
 #include "interpolation.hpp"
+#include "memoryplanner.hpp"
+#include "resultcache.hpp"
+#include "threadpool.hpp"
 
 /**
  * @class Generator
  * @brief Main class to orchestrate the process of generating and saving a color gradient.
  *
- * Handles argument parsing, file handling, and color interpolation.
+ * Handles argument parsing, file handling, and color interpolation on a pool of worker threads.
  */
 class Generator {
 public:
-    Generator(int argc, char *argv[], InterpolationType interpolationType);
+    Generator(int argc, char *argv[]);
     ~Generator() = default;
-    void run();
+    [[nodiscard]] bool run();
 private:
     /* data */
+    [[nodiscard]] static std::shared_ptr<ArgParser> parse(int argc, char *argv[]);
+    void reportStats() const;
+    void writeSingle();
+    [[nodiscard]] planner::Plan planWrite() const;
+    void writeMapped();
+    void writeTiled();
+    void writeBuffered(const planner::Plan& plan);
+    void reportThroughput(double seconds, bool always) const;
+
     std::shared_ptr<ArgParser> args;
-    FileHandler fileHandler;
     std::shared_ptr<Interpolation> interpolator;
+    ThreadPool pool;
+    std::unique_ptr<ResultCache> cache;   /* Null unless --cache was given */
 };
 
@@ -4,66 +4,249 @@
  */
 
 #include "argparser.hpp"
+#include "defaults.hpp"
 #include "display.hpp"
+#include "gradienttype.hpp"
+#include "outputbackend.hpp"
+#include "rowformat.hpp"
+#include <algorithm>
 #include <cstdint>
-
-#include <complex>
+#include <stdexcept>
+#include <vector>
 
 /**
  * @brief Constructs an ArgParser object and processes the command-line
  * arguments.
  *
- * Validates argument count and extracts width, height, color values, and output
- * file path.
- *
  * @param argc Number of command-line arguments.
  * @param argv Array of argument strings.
- * @throws std::invalid_argument If argc does not match requiredArgCount or if
- * argv is null.
+ * @throws std::invalid_argument If the arguments are invalid or argv is null.
+ */
+ArgParser::ArgParser(const int argc, char *argv[]) : ArgParser(toTokens(argc, argv)) {}
+
+/**
+ * @brief Constructs an ArgParser object from already split arguments.
+ *
+ * Separates options (arguments starting with "--") from positional arguments,
+ * validates the positional count and extracts width, height, color values and
+ * output file path. Used for the command line, the lines of a batch manifest and
+ * server requests.
+ *
+ * @param tokens Arguments without the program name.
+ * @throws std::invalid_argument If the positional argument count does not match
+ * requiredPositionalCount or an option is unknown.
  */
-ArgParser::ArgParser(const int argc, char *argv[]) {
-    if (static_cast<uint8_t>(argc) != requiredArgCount) {
-        throw std::invalid_argument("Argument count is not equal to "  + std::to_string(requiredArgCount));
+ArgParser::ArgParser(const std::vector<std::string> &tokens)
+    : tileSize(defaults::tileSize), threadCount(defaults::threadCount()), serveCacheBytes(defaults::serveCacheBytes),
+      cacheBytes(defaults::cacheBytes) {
+    std::vector<std::string> positional;
+    for (size_t i = 0; i < tokens.size(); i++) {
+        if (tokens[i].starts_with("--")) {
+            parseOption(tokens, i);
+        } else {
+            positional.push_back(tokens[i]);
+        }
     }
-    if (argv == nullptr) {
-        display::error("Error: Argument vector is null.");
-        throw std::invalid_argument("argv is null");
+
+    if (!batchManifest.empty() && !serveSocket.empty()) {
+        throw std::invalid_argument("--batch cannot be combined with --serve");
+    }
+    if (!endCorners.empty() && frameCount == 0) {
+        throw std::invalid_argument("--to requires --frames");
+    }
+    if (verifying && frameCount != 0) {
+        throw std::invalid_argument("--verify checks single images and cannot be combined with --frames");
+    }
+    if (hasRegion && frameCount != 0) {
+        throw std::invalid_argument("--region cannot be combined with --frames");
+    }
+    if (maxMemoryBytes != 0 && (!batchManifest.empty() || !serveSocket.empty() || verifying)) {
+        throw std::invalid_argument("--max-memory plans the writing of an image or animation and cannot be combined with "
+                                    "--batch, --serve or --verify");
+    }
+    if (!batchManifest.empty() || !serveSocket.empty()) {
+        if (frameCount != 0) {
+            throw std::invalid_argument("--frames cannot be combined with --batch or --serve");
+        }
+        if (verifying) {
+            throw std::invalid_argument("--verify cannot be combined with --batch or --serve");
+        }
+        if (!positional.empty()) {
+            throw std::invalid_argument("Positional arguments cannot be combined with --batch or --serve");
+        }
+        return;
     }
 
-    outputPath = std::string(argv[7]);
+    if (positional.size() != requiredPositionalCount) {
+        throw std::invalid_argument("Positional argument count is not equal to " + std::to_string(requiredPositionalCount));
+    }
+
+    outputPath = positional[6];
     if (this->outputPath.empty()) {
         throw std::invalid_argument("Output path cannot be empty");
     }
 
-    imageWidth = parseUInt16(argv[1]);
-    imageHeight = parseUInt16(argv[2]);
-    tl = parsePixel(argv[3]);
-    tr = parsePixel(argv[4]);
-    bl = parsePixel(argv[5]);
-    br = parsePixel(argv[6]);
+    imageWidth = parseDimension(positional[0]);
+    imageHeight = parseDimension(positional[1]);
+    tl = parsePixel(positional[2]);
+    tr = parsePixel(positional[3]);
+    bl = parsePixel(positional[4]);
+    br = parsePixel(positional[5]);
+
+    if (hasRegion && (region.x > imageWidth || region.width > imageWidth - region.x
+                      || region.y > imageHeight || region.height > imageHeight - region.y)) {
+        throw std::invalid_argument("Region exceeds the " + std::to_string(imageWidth) + " x "
+                                    + std::to_string(imageHeight) + " image");
+    }
 }
 
 /**
- * @brief Parses a string to a positive uint16_t.
+ * @brief Converts argc/argv to a list of arguments without the program name.
  *
- * Ensures the value is non-negative and within the range of uint16_t.
+ * @throws std::invalid_argument If argv is null.
+ */
+std::vector<std::string> ArgParser::toTokens(const int argc, char *argv[]) {
+    if (argv == nullptr) {
+        display::error("Error: Argument vector is null.");
+        throw std::invalid_argument("argv is null");
+    }
+    return std::vector<std::string>(argv + std::min(argc, 1), argv + std::max(argc, 1));
+}
+
+/**
+ * @brief Applies a single "--" option.
+ *
+ * Options taking a value consume the following token.
+ *
+ * @param tokens All arguments following the program name.
+ * @param index Position of the option; advanced past its value.
+ * @throws std::invalid_argument If the option is unknown or its value is missing or invalid.
+ */
+void ArgParser::parseOption(const std::vector<std::string> &tokens, size_t &index) {
+    const std::string &option = tokens[index];
+    auto value = [&tokens, &index, &option]() -> const std::string& {
+        if (index + 1 >= tokens.size()) {
+            throw std::invalid_argument("Missing value for option " + option);
+        }
+        return tokens[++index];
+    };
+
+    if (option == "--verbose") {
+        verbose = true;
+    } else if (option == "--stream") {
+        streaming = true;
+    } else if (option == "--mmap") {
+        mapped = true;
+    } else if (option == "--verify") {
+        verifying = true;
+    } else if (option == "--stats") {
+        statsReport = true;
+    } else if (option == "--stats-json") {
+        statsJson = value();
+        if (statsJson.empty()) {
+            throw std::invalid_argument("Statistics path cannot be empty");
+        }
+    } else if (option == "--format") {
+        outputFormat = rowformat::parse(value());
+    } else if (option == "--io") {
+        ioBackend = output::parse(value());
+    } else if (option == "--tile-size") {
+        const uint64_t size = parseUInt64(value());
+        if (size == 0 || size > defaults::maxTileSize) {
+            throw std::invalid_argument("Tile size must be between 1 and " + std::to_string(defaults::maxTileSize) + ": " + tokens[index]);
+        }
+        tileSize = static_cast<uint32_t>(size);
+    } else if (option == "--batch") {
+        batchManifest = value();
+        if (batchManifest.empty()) {
+            throw std::invalid_argument("Manifest path cannot be empty");
+        }
+    } else if (option == "--serve") {
+        serveSocket = value();
+        if (serveSocket.empty()) {
+            throw std::invalid_argument("Socket path cannot be empty");
+        }
+    } else if (option == "--serve-cache") {
+        const uint64_t mebibytes = parseUInt64(value());
+        if (mebibytes > (SIZE_MAX >> 20)) {
+            throw std::invalid_argument("Server cache size out of range: " + tokens[index]);
+        }
+        serveCacheBytes = static_cast<size_t>(mebibytes) << 20;
+    } else if (option == "--cache") {
+        cacheDirectory = value();
+        if (cacheDirectory.empty()) {
+            throw std::invalid_argument("Cache directory cannot be empty");
+        }
+    } else if (option == "--cache-size") {
+        const uint64_t mebibytes = parseUInt64(value());
+        if (mebibytes > (UINT64_MAX >> 20)) {
+            throw std::invalid_argument("Cache size out of range: " + tokens[index]);
+        }
+        cacheBytes = mebibytes << 20;
+    } else if (option == "--cache-link") {
+        cacheLinking = true;
+    } else if (option == "--max-memory") {
+        const uint64_t mebibytes = parseUInt64(value());
+        if (mebibytes == 0 || mebibytes > (UINT64_MAX >> 20)) {
+            throw std::invalid_argument("Memory budget out of range: " + tokens[index]);
+        }
+        maxMemoryBytes = mebibytes << 20;
+    } else if (option == "--gradient") {
+        interpolationType = gradienttype::parse(value());
+    } else if (option == "--stops") {
+        stops = parseStops(value());
+    } else if (option == "--angle") {
+        angle = parseUInt16(value());
+        if (angle >= 360) {
+            throw std::invalid_argument("Angle must be below 360 degrees: " + tokens[index]);
+        }
+    } else if (option == "--frames") {
+        frameCount = parseUInt64(value());
+        if (frameCount == 0 || frameCount > maxFrameCount) {
+            throw std::invalid_argument("Frame count must be between 1 and " + std::to_string(maxFrameCount));
+        }
+    } else if (option == "--to") {
+        endCorners = parseStops(value());
+        if (endCorners.size() != 4) {
+            throw std::invalid_argument("--to takes the four corner colors tl,tr,bl,br: " + tokens[index]);
+        }
+    } else if (option == "--region") {
+        region = parseRegion(value());
+        hasRegion = true;
+    } else if (option == "--threads") {
+        threadCount = parseUInt16(value());
+        if (threadCount == 0) {
+            throw std::invalid_argument("Thread count must be at least 1");
+        }
+    } else {
+        throw std::invalid_argument("Unknown option: " + option);
+    }
+}
+
+/**
+ * @brief Parses a string to a non-negative uint64_t.
+ *
+ * Accepts decimal values and hex values prefixed with "0x".
  *
  * @param arg String to parse.
- * @return Parsed uint16_t value.
- * @throws std::invalid_argument If the value is negative or exceeds uint16_t.
+ * @return Parsed uint64_t value.
+ * @throws std::invalid_argument If the value is not a non-negative integer or exceeds uint64_t.
  */
-uint16_t ArgParser::parseUInt16(const std::string &arg) {
-    uint16_t outValue = 0;
+uint64_t ArgParser::parseUInt64(const std::string &arg) {
+    uint64_t outValue = 0;
     size_t idx = 0;
 
     if (arg.find('.') != std::string::npos) {
         throw std::invalid_argument("Floating-point values are not allowed: " + arg);
     }
+    if (arg.find('-') != std::string::npos) {
+        throw std::invalid_argument("Negative values are not allowed: " + arg);
+    }
 
     int base = (arg.starts_with("0x") || arg.starts_with("0X")) ? 16 : 10;
 
     try {
-        outValue = std::stoi(arg, &idx, base);
+        outValue = std::stoull(arg, &idx, base);
 
         /* Check if the whole string was parsed to avoid partial conversions */
         if (idx != arg.length()) {
@@ -72,12 +255,44 @@ uint16_t ArgParser::parseUInt16(const std::string &arg) {
     } catch ([[maybe_unused]] const std::invalid_argument& e) {
         throw std::invalid_argument("Incorrect argument value: " + arg + "\nIt should be a number");
     } catch ([[maybe_unused]] const std::out_of_range& e) {
-        throw std::invalid_argument("Argument out of range for int16_t: " + arg);
+        throw std::invalid_argument("Argument out of range for uint64_t: " + arg);
     }
 
     return outValue;
 }
 
+/**
+ * @brief Parses a string to a positive uint16_t.
+ *
+ * Ensures the value is non-negative and within the range of uint16_t.
+ *
+ * @param arg String to parse.
+ * @return Parsed uint16_t value.
+ * @throws std::invalid_argument If the value is negative or exceeds uint16_t.
+ */
+uint16_t ArgParser::parseUInt16(const std::string &arg) {
+    const uint64_t outValue = parseUInt64(arg);
+    if (outValue > UINT16_MAX) {
+        throw std::invalid_argument("Argument out of range for uint16_t: " + arg);
+    }
+    return static_cast<uint16_t>(outValue);
+}
+
+/**
+ * @brief Parses an image dimension.
+ *
+ * @param arg String to parse.
+ * @return Parsed dimension.
+ * @throws std::invalid_argument If the value exceeds maxImageDimension.
+ */
+uint64_t ArgParser::parseDimension(const std::string &arg) {
+    const uint64_t outValue = parseUInt64(arg);
+    if (outValue > maxImageDimension) {
+        throw std::invalid_argument("Image dimension exceeds " + std::to_string(maxImageDimension) + ": " + arg);
+    }
+    return outValue;
+}
+
 /**
  * @brief Parses a string to a Pixel value.
  *
@@ -91,6 +306,46 @@ Pixel ArgParser::parsePixel(const std::string &arg) {
     return parseUInt16(arg);
 }
 
+/**
+ * @brief Parses a comma separated list of at least two colors.
+ *
+ * @param arg String to parse, e.g. "0xF800,0x07E0,0x001F".
+ * @return Parsed colors in order.
+ * @throws std::invalid_argument If a color is invalid or fewer than two are given.
+ */
+std::vector<Pixel> ArgParser::parseStops(const std::string &arg) {
+    std::vector<Pixel> colors;
+    size_t begin = 0;
+    for (size_t end; (end = arg.find(',', begin)) != std::string::npos; begin = end + 1) {
+        colors.push_back(parsePixel(arg.substr(begin, end - begin)));
+    }
+    colors.push_back(parsePixel(arg.substr(begin)));
+    if (colors.size() < 2) {
+        throw std::invalid_argument("At least two color stops are required: " + arg);
+    }
+    return colors;
+}
+
+/**
+ * @brief Parses the rectangle of a --region option.
+ *
+ * @param arg String to parse, "x,y,width,height" with x and y counted from the top-left corner.
+ * @return Parsed rectangle, not yet checked against the image size.
+ * @throws std::invalid_argument If there are not exactly four valid values.
+ */
+Region ArgParser::parseRegion(const std::string &arg) {
+    std::vector<uint64_t> values;
+    size_t begin = 0;
+    for (size_t end; (end = arg.find(',', begin)) != std::string::npos; begin = end + 1) {
+        values.push_back(parseDimension(arg.substr(begin, end - begin)));
+    }
+    values.push_back(parseDimension(arg.substr(begin)));
+    if (values.size() != 4) {
+        throw std::invalid_argument("--region takes x,y,width,height: " + arg);
+    }
+    return Region{values[0], values[1], values[2], values[3]};
+}
+
 /**
  * @brief Parses a string to an ImageWidth value.
  *
@@ -101,7 +356,7 @@ Pixel ArgParser::parsePixel(const std::string &arg) {
  * @throws std::invalid_argument If the parsed width is zero.
  */
 ImageWidth ArgParser::parseImageWidth(const std::string &arg) {
-    auto outValue = static_cast<ImageWidth>(parseUInt16(arg));
+    auto outValue = static_cast<ImageWidth>(parseDimension(arg));
     if (outValue == 0) {
         throw std::invalid_argument("Invalid image width: " + arg);
     }
@@ -118,7 +373,7 @@ ImageWidth ArgParser::parseImageWidth(const std::string &arg) {
  * @throws std::invalid_argument If the parsed height is zero.
  */
 ImageHeight ArgParser::parseImageHeight(const std::string &arg) {
-    auto outValue = static_cast<ImageHeight>(parseUInt16(arg));
+    auto outValue = static_cast<ImageHeight>(parseDimension(arg));
     if (outValue == 0) {
         throw std::invalid_argument("Invalid image height: " + arg);
     }
@@ -140,6 +395,162 @@ ImageHeight ArgParser::getImageHeight() const {
     return this->imageHeight;
 }
 
+/** @brief Tells whether verbose output was requested. */
+bool ArgParser::isVerbose() const {
+    return this->verbose;
+}
+
+/** @brief Tells whether the image should be streamed block by block. */
+bool ArgParser::isStreaming() const {
+    return this->streaming;
+}
+
+/** @brief Tells whether the output file should be written through a memory mapping. */
+bool ArgParser::isMapped() const {
+    return this->mapped;
+}
+
+/** @brief Tells whether the output file should be checked instead of written (--verify). */
+bool ArgParser::isVerifying() const {
+    return this->verifying;
+}
+
+/** @brief Retrieves the encoding of the output file. */
+OutputFormat ArgParser::getOutputFormat() const {
+    return this->outputFormat;
+}
+
+/** @brief Retrieves the output backend of the buffered writer. */
+IoBackend ArgParser::getIoBackend() const {
+    return this->ioBackend;
+}
+
+/** @brief Retrieves the tile width and height of the tiled format. */
+uint32_t ArgParser::getTileSize() const {
+    return this->tileSize;
+}
+
+/** @brief Retrieves the batch manifest path; empty unless --batch was given. */
+std::string ArgParser::getBatchManifest() const {
+    return this->batchManifest;
+}
+
+/** @brief Tells whether statistics should be printed at the end of the run. */
+bool ArgParser::isStatsReport() const {
+    return this->statsReport;
+}
+
+/** @brief Retrieves the path of the JSON statistics; empty unless --stats-json was given. */
+std::string ArgParser::getStatsJson() const {
+    return this->statsJson;
+}
+
+/** @brief Retrieves the server socket path; empty unless --serve was given. */
+std::string ArgParser::getServeSocket() const {
+    return this->serveSocket;
+}
+
+/** @brief Retrieves the size of the in-memory result cache of the server in bytes. */
+size_t ArgParser::getServeCacheBytes() const {
+    return this->serveCacheBytes;
+}
+
+/** @brief Retrieves the number of threads used for generation. */
+size_t ArgParser::getThreadCount() const {
+    return this->threadCount;
+}
+
+/** @brief Retrieves the result cache directory; empty unless --cache was given. */
+std::string ArgParser::getCacheDirectory() const {
+    return this->cacheDirectory;
+}
+
+/** @brief Retrieves the size limit of the result cache in bytes. */
+uint64_t ArgParser::getCacheBytes() const {
+    return this->cacheBytes;
+}
+
+/** @brief Tells whether cache hits may be served as hardlinks to the cache entries. */
+bool ArgParser::isCacheLinking() const {
+    return this->cacheLinking;
+}
+
+/** @brief Retrieves the memory budget of an image or animation in bytes; 0 unless --max-memory was given. */
+uint64_t ArgParser::getMaxMemoryBytes() const {
+    return this->maxMemoryBytes;
+}
+
+/** @brief Retrieves the gradient shape selected with --gradient. */
+InterpolationType ArgParser::getInterpolationType() const {
+    return this->interpolationType;
+}
+
+/**
+ * @brief Retrieves the color stops of the linear, radial and conic gradients.
+ *
+ * Without --stops the four positional colors are used in the order tl, tr, bl, br.
+ */
+std::vector<Pixel> ArgParser::getStops() const {
+    if (this->stops.empty()) {
+        return {this->tl, this->tr, this->bl, this->br};
+    }
+    return this->stops;
+}
+
+/** @brief Retrieves the gradient direction or start angle in degrees. */
+uint16_t ArgParser::getAngle() const {
+    return this->angle;
+}
+
+/** @brief Retrieves the number of animation frames; 0 unless --frames was given. */
+uint64_t ArgParser::getFrameCount() const {
+    return this->frameCount;
+}
+
+/**
+ * @brief Retrieves the corner colors of the last animation frame in the order tl, tr, bl, br.
+ *
+ * Without --to the corners do not move.
+ */
+std::vector<Pixel> ArgParser::getEndCorners() const {
+    if (this->endCorners.empty()) {
+        return {this->tl, this->tr, this->bl, this->br};
+    }
+    return this->endCorners;
+}
+
+/**
+ * @brief Retrieves the rectangle of the image that is rendered and written.
+ *
+ * Without --region this is the whole image.
+ */
+Region ArgParser::getRegion() const {
+    if (!this->hasRegion) {
+        return Region{0, 0, this->imageWidth, this->imageHeight};
+    }
+    return this->region;
+}
+
+/**
+ * @brief Collects the image parameters, as handed to InterpolationFactory and the gradient_core library.
+ */
+gradient::Parameters ArgParser::getParameters() const {
+    gradient::Parameters parameters;
+    parameters.width = this->imageWidth;
+    parameters.height = this->imageHeight;
+    parameters.tl = this->tl;
+    parameters.tr = this->tr;
+    parameters.bl = this->bl;
+    parameters.br = this->br;
+    parameters.type = this->interpolationType;
+    parameters.stops = this->stops;
+    parameters.angle = this->angle;
+    if (this->hasRegion) {
+        parameters.region = this->region;
+    }
+    return parameters;
+}
+
 /** @brief Retrieves the top-left color value. */
 uint16_t ArgParser::getTopLeft() const {
     return this->tl;
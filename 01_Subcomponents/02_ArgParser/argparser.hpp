@@ -7,6 +7,8 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
+#include "parameters.hpp"
 #include "types.hpp"
 
 /**
@@ -16,6 +18,7 @@
 class ArgParser {
 public:
     ArgParser(int argc, char *argv[]);
+    explicit ArgParser(const std::vector<std::string> &tokens);
     ~ArgParser() = default;
 
     [[nodiscard]] std::string getOutputPath();
@@ -25,18 +28,74 @@ public:
     [[nodiscard]] Pixel getTopRight() const;
     [[nodiscard]] Pixel getBottomLeft() const;
     [[nodiscard]] Pixel getBottomRight() const;
+    [[nodiscard]] bool isVerbose() const;
+    [[nodiscard]] bool isStreaming() const;
+    [[nodiscard]] bool isMapped() const;
+    [[nodiscard]] bool isVerifying() const;
+    [[nodiscard]] OutputFormat getOutputFormat() const;
+    [[nodiscard]] IoBackend getIoBackend() const;
+    [[nodiscard]] uint32_t getTileSize() const;
+    [[nodiscard]] std::string getBatchManifest() const;
+    [[nodiscard]] std::string getServeSocket() const;
+    [[nodiscard]] size_t getServeCacheBytes() const;
+    [[nodiscard]] size_t getThreadCount() const;
+    [[nodiscard]] bool isStatsReport() const;
+    [[nodiscard]] std::string getStatsJson() const;
+    [[nodiscard]] std::string getCacheDirectory() const;
+    [[nodiscard]] uint64_t getCacheBytes() const;
+    [[nodiscard]] bool isCacheLinking() const;
+    [[nodiscard]] uint64_t getMaxMemoryBytes() const;
+    [[nodiscard]] InterpolationType getInterpolationType() const;
+    [[nodiscard]] std::vector<Pixel> getStops() const;
+    [[nodiscard]] uint16_t getAngle() const;
+    [[nodiscard]] uint64_t getFrameCount() const;
+    [[nodiscard]] std::vector<Pixel> getEndCorners() const;
+    [[nodiscard]] Region getRegion() const;
+    [[nodiscard]] gradient::Parameters getParameters() const;
 private:
-    ImageHeight imageWidth;    /* Image width (32-bit unsigned integer) */
-    ImageWidth imageHeight;    /* Image height (32-bit unsigned integer) */
-    Pixel tl;               /* Top-left pixel color value */
-    Pixel tr;               /* Top-right pixel color value */
-    Pixel bl;               /* Bottom-left pixel color value  */
-    Pixel br;               /* Bottom-right pixel color value  */
+    ImageWidth imageWidth = 0;     /* Image width (64-bit unsigned integer) */
+    ImageHeight imageHeight = 0;   /* Image height (64-bit unsigned integer) */
+    Pixel tl = 0;           /* Top-left pixel color value */
+    Pixel tr = 0;           /* Top-right pixel color value */
+    Pixel bl = 0;           /* Bottom-left pixel color value  */
+    Pixel br = 0;           /* Bottom-right pixel color value  */
     std::string outputPath;    /* Output file path */
+    bool verbose = false;      /* Print diagnostic information (--verbose) */
+    bool streaming = false;    /* Generate and write block by block (--stream) */
+    bool mapped = false;       /* Fill a memory-mapped output file (--mmap) */
+    bool verifying = false;    /* Check the output file instead of writing it (--verify) */
+    OutputFormat outputFormat = OutputFormat::TEXT;   /* Encoding of the output file (--format) */
+    IoBackend ioBackend = IoBackend::WRITE;           /* How the buffered writer writes the file (--io) */
+    uint32_t tileSize;                                /* Tile width and height of the tiled format (--tile-size) */
+    size_t threadCount;        /* Threads generating the image (--threads) */
+    bool statsReport = false;  /* Print per-stage statistics (--stats) */
+    std::string statsJson;     /* File receiving the statistics as JSON (--stats-json) */
+    std::string batchManifest; /* Manifest of jobs to run in this process (--batch) */
+    std::string serveSocket;   /* Unix socket to serve requests on (--serve) */
+    size_t serveCacheBytes;    /* Memory cache size of the server (--serve-cache) */
+    std::string cacheDirectory;   /* Result cache directory (--cache) */
+    uint64_t cacheBytes;          /* Result cache size limit (--cache-size) */
+    bool cacheLinking = false;    /* Serve cache hits by hardlink (--cache-link) */
+    uint64_t maxMemoryBytes = 0;  /* Memory budget of an image or animation, 0 for none (--max-memory) */
+    InterpolationType interpolationType = InterpolationType::BILINEAR;   /* Gradient shape (--gradient) */
+    std::vector<Pixel> stops;     /* Color stops of the linear, radial and conic gradients (--stops) */
+    uint16_t angle = 0;           /* Direction or start angle in degrees (--angle) */
+    uint64_t frameCount = 0;      /* Frames of an animation, 0 for a single image (--frames) */
+    std::vector<Pixel> endCorners;   /* Corner colors of the last frame: tl, tr, bl, br (--to) */
+    Region region;                /* Rendered rectangle of the image (--region) */
+    bool hasRegion = false;       /* False renders the whole image */
 
+    [[nodiscard]] static std::vector<std::string> toTokens(int argc, char *argv[]);
+    void parseOption(const std::vector<std::string> &tokens, size_t &index);
+
+    [[nodiscard]] static uint64_t parseUInt64(const std::string &arg);
     [[nodiscard]] static uint16_t parseUInt16(const std::string &arg);
+    [[nodiscard]] static uint64_t parseDimension(const std::string &arg);
     [[nodiscard]] static Pixel parsePixel(const std::string &arg);
+    [[nodiscard]] static std::vector<Pixel> parseStops(const std::string &arg);
+    [[nodiscard]] static Region parseRegion(const std::string &arg);
     [[nodiscard]] static ImageWidth parseImageWidth(const std::string &arg);
     [[nodiscard]] static ImageHeight parseImageHeight(const std::string &arg);
-    static constexpr uint8_t requiredArgCount = 8U;
+    static constexpr uint8_t requiredPositionalCount = 7U;
+    static constexpr uint64_t maxFrameCount = 1000000U;
 };
@@ -0,0 +1,29 @@
+/**
+ * @file bilinearkernel.cpp
+ * @brief Implements the runtime-dispatched part of the fixed-point bilinear kernel.
+ */
+
+#include "bilinearkernel.hpp"
+#include "simdkernel.hpp"
+
+/**
+ * @brief Renders count pixels of row y starting at column first into out.
+ *
+ * The row setup is moved to the first column, so the pixels equal those of the full row.
+ * Spans whose runs of equal pixels are long on average, such as those of wide images, are
+ * filled run by run (renderRowRuns); the others use the vectorized renderer selected for this
+ * CPU, see simdkernel.hpp. Both produce the same pixels.
+ *
+ * @param y Row index, 0 being the bottom row.
+ * @param first Column of the first pixel.
+ * @param count Number of pixels, first + count <= width().
+ * @param out Destination for count packed pixels.
+ */
+void kernel::BilinearKernel::renderSpan(const ImageHeight y, const ImageWidth first, const ImageWidth count, Pixel* out) const {
+    const RowSetup setup = advance(setupRow(y), first);
+    if (estimateRuns(setup, count) * minimumRunPixels <= count && detail::accumulatorsInRange(setup, count)) {
+        renderRowRuns(setup, out, count);
+    } else {
+        renderRowSimd(setup, out, count);
+    }
+}
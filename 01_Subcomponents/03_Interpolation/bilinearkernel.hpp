@@ -0,0 +1,314 @@
+/**
+ * @file bilinearkernel.hpp
+ * @brief Defines the incremental fixed-point bilinear kernel used to generate gradient rows.
+ *
+ * Rounding rule, applied to every channel c with maximum M (31 for red/blue, 63 for green):
+ *
+ *     F    = 2^24,  W1 = max(width - 1, 1),  H1 = max(height - 1, 1)
+ *     L(y) = c_bl * F + rdiv((c_tl - c_bl) * F * y, H1)      left edge of row y
+ *     R(y) = c_br * F + rdiv((c_tr - c_br) * F * y, H1)      right edge of row y
+ *     D(y) = rdiv(R(y) - L(y), W1)                           step between neighbouring pixels
+ *     c(x, y) = clamp(floor((L(y) + x * D(y) + F / 2) / F), 0, M)
+ *
+ * where rdiv(n, d) = floor((2n + d) / 2d) divides rounding halves up. Row 0 is the bottom
+ * row (bl to br) and row height - 1 the top row (tl to tr), so every corner is reproduced exactly.
+ * Because x * D(y) is plain integer arithmetic, stepping a pixel at a time gives the same
+ * result as evaluating any pixel directly.
+ *
+ * Everything except the vectorized renderRow() is constexpr, so gradients can also be
+ * generated at compile time, see constexprgradient.hpp.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include "rgb565.hpp"
+#include "types.hpp"
+
+namespace kernel {
+    /**
+     * @brief Number of fractional bits of the fixed-point channel accumulators.
+     */
+    static constexpr int fractionBits = 24;
+
+    namespace detail {
+        /**
+         * @brief Divides n by a positive d, rounding halves up (rdiv in the kernel rounding rule).
+         */
+        [[nodiscard]] constexpr int64_t roundedDivide(const int64_t numerator, const int64_t denominator) {
+            const int64_t twiceNumerator = 2 * numerator + denominator;
+            const int64_t twiceDenominator = 2 * denominator;
+            int64_t quotient = twiceNumerator / twiceDenominator;
+            if (twiceNumerator % twiceDenominator != 0 && twiceNumerator < 0) {
+                quotient--; /* Turn truncation into floor for negative numerators */
+            }
+            return quotient;
+        }
+
+        /**
+         * @brief Converts a fixed-point accumulator to a channel value using the kernel rounding rule.
+         */
+        [[nodiscard]] constexpr uint32_t quantize(const int32_t accumulator, const int32_t maximum) {
+            const int32_t value = (accumulator + (1 << (fractionBits - 1))) >> fractionBits;
+            return static_cast<uint32_t>(std::clamp(value, 0, maximum));
+        }
+    }
+
+    /**
+     * @struct ChannelRow
+     * @brief Fixed-point value of one channel at the first pixel of a row and its per-pixel step.
+     */
+    struct ChannelRow {
+        int32_t start;
+        int32_t step;
+    };
+
+    /**
+     * @struct RowSetup
+     * @brief Everything needed to produce one row: the fixed-point start and step of each channel.
+     */
+    struct RowSetup {
+        ChannelRow red;
+        ChannelRow green;
+        ChannelRow blue;
+    };
+
+    /**
+     * @class BilinearKernel
+     * @brief Produces rows of a bilinear gradient with integer fixed-point arithmetic only.
+     *
+     * The four corners are unpacked once on construction; afterwards each row costs one
+     * setup and a handful of integer additions per pixel.
+     */
+    class BilinearKernel {
+    public:
+        /**
+         * @brief Constructs the kernel and unpacks the four corner colors.
+         */
+        constexpr BilinearKernel(const ImageWidth width, const ImageHeight height,
+                                 const Pixel tl, const Pixel tr, const Pixel bl, const Pixel br)
+            : imageWidth(width), imageHeight(height) {
+            const auto topLeft = rgb565::unpack(tl), topRight = rgb565::unpack(tr);
+            const auto bottomLeft = rgb565::unpack(bl), bottomRight = rgb565::unpack(br);
+
+            red = {bottomLeft.red, bottomRight.red, topLeft.red - bottomLeft.red, topRight.red - bottomRight.red};
+            green = {bottomLeft.green, bottomRight.green, topLeft.green - bottomLeft.green, topRight.green - bottomRight.green};
+            blue = {bottomLeft.blue, bottomRight.blue, topLeft.blue - bottomLeft.blue, topRight.blue - bottomRight.blue};
+        }
+
+        /**
+         * @brief Computes the per-channel start values and steps of row y (0 being the bottom row).
+         */
+        [[nodiscard]] constexpr RowSetup setupRow(const ImageHeight y) const {
+            return RowSetup{setupChannel(red, y), setupChannel(green, y), setupChannel(blue, y)};
+        }
+
+        void renderSpan(ImageHeight y, ImageWidth first, ImageWidth count, Pixel* out) const;
+
+        /**
+         * @brief Renders the full row y into out.
+         */
+        void renderRow(const ImageHeight y, Pixel* out) const {
+            renderSpan(y, 0, imageWidth, out);
+        }
+
+        [[nodiscard]] constexpr ImageWidth width() const { return imageWidth; }
+        [[nodiscard]] constexpr ImageHeight height() const { return imageHeight; }
+
+        /**
+         * @brief Classifies the corners: equal left and right edges make every row identical,
+         * equal top and bottom edges make every row a single color (every step is 0).
+         */
+        [[nodiscard]] constexpr RowShape shape() const {
+            auto flat = [](const Channel& channel) { return channel.leftRise == 0 && channel.rightRise == 0; };
+            auto level = [](const Channel& channel) {
+                return channel.bottomLeft == channel.bottomRight && channel.leftRise == channel.rightRise;
+            };
+            const bool identical = flat(red) && flat(green) && flat(blue);
+            const bool constant = level(red) && level(green) && level(blue);
+            if (identical && constant) {
+                return RowShape::SOLID;
+            }
+            return identical ? RowShape::HORIZONTAL : constant ? RowShape::VERTICAL : RowShape::GENERAL;
+        }
+    private:
+        static constexpr uint64_t minimumRunPixels = 64;   /* Average run length from which rows are filled run by run */
+
+        /* Corner values of one channel, in channel units */
+        struct Channel {
+            int64_t bottomLeft;
+            int64_t bottomRight;
+            int64_t leftRise;   /* top-left minus bottom-left */
+            int64_t rightRise;  /* top-right minus bottom-right */
+        };
+
+        /**
+         * @brief Computes the fixed-point start and step of one channel for row y.
+         */
+        [[nodiscard]] constexpr ChannelRow setupChannel(const Channel& channel, const ImageHeight y) const {
+            const int64_t one = int64_t{1} << fractionBits;
+            const int64_t rows = std::max<int64_t>(static_cast<int64_t>(imageHeight) - 1, 1);
+            const int64_t columns = std::max<int64_t>(static_cast<int64_t>(imageWidth) - 1, 1);
+
+            const auto row = static_cast<int64_t>(y);   /* y <= 2^24, so the products stay below 2^55 */
+            const int64_t left = channel.bottomLeft * one + detail::roundedDivide(channel.leftRise * one * row, rows);
+            const int64_t right = channel.bottomRight * one + detail::roundedDivide(channel.rightRise * one * row, rows);
+
+            return ChannelRow{static_cast<int32_t>(left), static_cast<int32_t>(detail::roundedDivide(right - left, columns))};
+        }
+
+        ImageWidth imageWidth;
+        ImageHeight imageHeight;
+        Channel red{};
+        Channel green{};
+        Channel blue{};
+    };
+
+    /**
+     * @brief Moves a row setup forward by offset pixels, with the same wrapping as the accumulators.
+     *
+     * The setup of pixel offset onwards renders exactly the pixels a full row has from there.
+     */
+    [[nodiscard]] constexpr RowSetup advance(const RowSetup& setup, const ImageWidth offset) {
+        auto shift = [offset](const ChannelRow& channel) {
+            const uint32_t start = static_cast<uint32_t>(channel.start)
+                                 + static_cast<uint32_t>(offset) * static_cast<uint32_t>(channel.step);
+            return ChannelRow{static_cast<int32_t>(start), channel.step};
+        };
+        return RowSetup{shift(setup.red), shift(setup.green), shift(setup.blue)};
+    }
+
+    /**
+     * @brief Steps the three channel accumulators along a row and stores packed pixels.
+     *
+     * @param setup Start values and steps of the row.
+     * @param out Destination for count packed pixels.
+     * @param count Number of pixels to produce.
+     */
+    constexpr void renderRowScalar(const RowSetup& setup, Pixel* out, const ImageWidth count) {
+        /* Unsigned accumulators wrap instead of overflowing past the end of the row */
+        auto red = static_cast<uint32_t>(setup.red.start);
+        auto green = static_cast<uint32_t>(setup.green.start);
+        auto blue = static_cast<uint32_t>(setup.blue.start);
+
+        for (ImageWidth x = 0; x < count; x++) {
+            out[x] = static_cast<Pixel>(
+                detail::quantize(static_cast<int32_t>(red), rgb565::RGB565::max5Bit) << rgb565::redShift
+                | detail::quantize(static_cast<int32_t>(green), rgb565::RGB565::max6Bit) << rgb565::greenShift
+                | detail::quantize(static_cast<int32_t>(blue), rgb565::RGB565::max5Bit) << rgb565::blueShift);
+            red += static_cast<uint32_t>(setup.red.step);
+            green += static_cast<uint32_t>(setup.green.step);
+            blue += static_cast<uint32_t>(setup.blue.step);
+        }
+    }
+
+    namespace detail {
+        /**
+         * @brief Divides n by a positive d, rounding towards positive infinity.
+         */
+        [[nodiscard]] constexpr int64_t ceilDivide(const int64_t numerator, const int64_t denominator) {
+            return numerator >= 0 ? (numerator + denominator - 1) / denominator : -(-numerator / denominator);
+        }
+
+        /**
+         * @brief First column after x at which a channel leaves the quantized value it has at x.
+         *
+         * The accumulator start + x * step is linear, so the column follows from solving
+         * start + x * step + F / 2 against the next multiple of F in the direction of the
+         * step. A channel clamped at the end its step moves towards never changes again.
+         *
+         * @param channel Start and step of the channel.
+         * @param value Quantized value of the channel at column x.
+         * @param maximum Largest value of the channel.
+         * @param x Current column.
+         * @param end Column returned when the value does not change before it.
+         * @return Column in (x, end].
+         */
+        [[nodiscard]] constexpr int64_t nextChange(const ChannelRow& channel, const uint32_t value, const int32_t maximum,
+                                                   const int64_t x, const int64_t end) {
+            const int64_t one = int64_t{1} << fractionBits, half = one / 2;
+            int64_t column = end;
+            if (channel.step > 0 && value < static_cast<uint32_t>(maximum)) {
+                column = ceilDivide((value + 1) * one - half - channel.start, channel.step);
+            } else if (channel.step < 0 && value > 0) {
+                column = ceilDivide(channel.start + half + 1 - value * one, -int64_t{channel.step});
+            }
+            return std::clamp(column, x + 1, end);
+        }
+
+        /**
+         * @brief Tells whether the first count pixels are monotonic in every channel.
+         *
+         * Holds when no accumulator wraps and none is so large that adding F / 2 in quantize()
+         * wraps. Always true for rows of setupRow(), whose accumulators run from one edge value
+         * to the other; renderRowRuns() relies on it.
+         */
+        [[nodiscard]] constexpr bool accumulatorsInRange(const RowSetup& setup, const ImageWidth count) {
+            auto inRange = [count](const ChannelRow& channel) {
+                const int64_t last = channel.start + static_cast<int64_t>(count > 0 ? count - 1 : 0) * channel.step;
+                const int64_t limit = INT32_MAX - (int64_t{1} << (fractionBits - 1));
+                return std::min<int64_t>(channel.start, last) >= INT32_MIN && std::max<int64_t>(channel.start, last) <= limit;
+            };
+            return inRange(setup.red) && inRange(setup.green) && inRange(setup.blue);
+        }
+    }
+
+    /**
+     * @brief Estimates the number of runs of equal pixels in the first count pixels of a row.
+     *
+     * Each channel changes value about |step| * count / F times, so the sum bounds the number
+     * of runs up to rounding; no pixel is evaluated.
+     */
+    [[nodiscard]] constexpr uint64_t estimateRuns(const RowSetup& setup, const ImageWidth count) {
+        auto changes = [count](const ChannelRow& channel) {
+            const uint64_t magnitude = channel.step < 0 ? -static_cast<int64_t>(channel.step) : channel.step;
+            return (magnitude * count >> fractionBits) + 1;
+        };
+        return changes(setup.red) + changes(setup.green) + changes(setup.blue) - 2;
+    }
+
+    /**
+     * @brief Fills a row run by run, computing where each channel changes instead of stepping every pixel.
+     *
+     * A channel only takes its 32 or 64 levels once each, so a wide row consists of a few
+     * hundred runs of one color at most. The column ending each channel's run is solved from
+     * the rounding rule (detail::nextChange), and every run of the three channels combined is
+     * written with one fill. The cost grows with the number of runs rather than with count,
+     * and the pixels equal those of renderRowScalar().
+     *
+     * @param setup Start values and steps of the row; detail::accumulatorsInRange() must hold.
+     * @param out Destination for count packed pixels.
+     * @param count Number of pixels to produce.
+     */
+    constexpr void renderRowRuns(const RowSetup& setup, Pixel* out, const ImageWidth count) {
+        struct Run {
+            const ChannelRow& channel;
+            int32_t maximum;
+            uint8_t shift;
+            uint32_t value = 0;
+            int64_t next = 0;   /* Column at which value has to be recomputed */
+        };
+        Run runs[] = {{setup.red, rgb565::RGB565::max5Bit, rgb565::redShift},
+                      {setup.green, rgb565::RGB565::max6Bit, rgb565::greenShift},
+                      {setup.blue, rgb565::RGB565::max5Bit, rgb565::blueShift}};
+
+        const auto end = static_cast<int64_t>(count);
+        for (int64_t x = 0; x < end;) {
+            int64_t runEnd = end;
+            uint32_t pixel = 0;
+            for (Run& run : runs) {
+                if (run.next == x) {
+                    const int64_t accumulator = run.channel.start + x * run.channel.step;
+                    run.value = detail::quantize(static_cast<int32_t>(accumulator), run.maximum);
+                    run.next = detail::nextChange(run.channel, run.value, run.maximum, x, end);
+                }
+                runEnd = std::min(runEnd, run.next);
+                pixel |= run.value << run.shift;
+            }
+            std::fill(out + x, out + runEnd, static_cast<Pixel>(pixel));
+            x = runEnd;
+        }
+    }
+}
@@ -0,0 +1,59 @@
+/**
+ * @file colorramp.cpp
+ * @brief Implements the ColorRamp class.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "colorramp.hpp"
+#include "rgb565.hpp"
+
+namespace {
+    uint32_t mix(const uint32_t from, const uint32_t to, const double fraction) {
+        const double value = from + (static_cast<double>(to) - static_cast<double>(from)) * fraction;
+        return static_cast<uint32_t>(std::floor(value + 0.5));
+    }
+}
+
+/**
+ * @brief Creates a ramp; the first stop is at position 0 and the last at position 1.
+ *
+ * @param stops At least two colors.
+ * @throws std::invalid_argument If fewer than two stops are given.
+ */
+kernel::ColorRamp::ColorRamp(std::vector<Pixel> stops) : stops(std::move(stops)) {
+    if (this->stops.size() < 2) {
+        throw std::invalid_argument("A color ramp needs at least two stops");
+    }
+}
+
+/**
+ * @brief Interpolates the color at a position, clamped to [0, 1].
+ *
+ * Each channel is interpolated between the two surrounding stops and rounded to nearest.
+ */
+Pixel kernel::ColorRamp::colorAt(const double position) const {
+    const double scaled = std::clamp(position, 0.0, 1.0) * static_cast<double>(stops.size() - 1);
+    const size_t segment = std::min(static_cast<size_t>(scaled), stops.size() - 2);
+    const double fraction = scaled - static_cast<double>(segment);
+
+    const auto from = rgb565::unpack(stops[segment]);
+    const auto to = rgb565::unpack(stops[segment + 1]);
+    rgb565::RGB565 color{};
+    color.red = mix(from.red, to.red, fraction);
+    color.green = mix(from.green, to.green, fraction);
+    color.blue = mix(from.blue, to.blue, fraction);
+    return color.pack();
+}
+
+/**
+ * @brief Samples the ramp at size evenly spaced positions, entry i being position i / (size - 1).
+ */
+std::vector<Pixel> kernel::ColorRamp::table(const size_t size) const {
+    std::vector<Pixel> entries(size);
+    for (size_t i = 0; i < size; i++) {
+        entries[i] = colorAt(size > 1 ? static_cast<double>(i) / static_cast<double>(size - 1) : 0.0);
+    }
+    return entries;
+}
@@ -0,0 +1,29 @@
+/**
+ * @file colorramp.hpp
+ * @brief Defines the ColorRamp class, which maps a position in [0, 1] to a color through N stops.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "types.hpp"
+
+namespace kernel {
+    /**
+     * @class ColorRamp
+     * @brief Evenly spaced color stops, linearly interpolated per channel.
+     *
+     * The radial, conic and linear kernels never evaluate the ramp per pixel; they sample it
+     * once into a lookup table indexed by their own fixed-point position.
+     */
+    class ColorRamp {
+    public:
+        explicit ColorRamp(std::vector<Pixel> stops);
+
+        [[nodiscard]] Pixel colorAt(double position) const;
+        [[nodiscard]] std::vector<Pixel> table(size_t size) const;
+    private:
+        std::vector<Pixel> stops;
+    };
+}
@@ -0,0 +1,103 @@
+/**
+ * @file conickernel.cpp
+ * @brief Implements the conic gradient kernel.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include "conickernel.hpp"
+#include "simdkernel.hpp"
+
+namespace {
+    /* Minimax coefficients of atan(r) / r on [0, 1] in powers of r^2, pre-divided by 2 pi to yield turns */
+    constexpr double turnsPerRadian = 0.5 / std::numbers::pi;
+    constexpr float c1 = 0.99997726 * turnsPerRadian, c3 = -0.33262347 * turnsPerRadian;
+    constexpr float c5 = 0.19354346 * turnsPerRadian, c7 = -0.11643287 * turnsPerRadian;
+    constexpr float c9 = 0.05265332 * turnsPerRadian, c11 = -0.01172120 * turnsPerRadian;
+    constexpr float seamTurns = 2e-6f;  /* Error bound of atanTurns, the width of the seam at the start angle */
+
+    /**
+     * @brief atan(r) in turns for r in [0, 1].
+     */
+    inline float atanTurns(const float ratio) {
+        const float square = ratio * ratio;
+        return ratio * (c1 + square * (c3 + square * (c5 + square * (c7 + square * (c9 + square * c11)))));
+    }
+
+    /**
+     * @brief Computes the table indices of count pixels of one row.
+     *
+     * @param firstX Doubled x coordinate of the first pixel.
+     * @param rowY Doubled y coordinate of the row.
+     * @param start Start angle in turns.
+     * @param last Index of the last table entry.
+     * @param count Number of pixels.
+     * @param indices Destination for count indices, not yet clamped.
+     */
+    GRADIENT_VECTOR_CLONES
+    void conicIndices(const int32_t firstX, const int32_t rowY, const float start, const float last,
+                      const int32_t count, int32_t* indices) {
+        const int32_t absoluteY = rowY < 0 ? -rowY : rowY;
+        const float lowerOffset = rowY < 0 ? 1.0f : 0.0f, lowerSign = rowY < 0 ? -1.0f : 1.0f;
+        for (int32_t i = 0; i < count; i++) {
+            const int32_t columnX = firstX + 2 * i;
+            const int32_t absoluteX = columnX < 0 ? -columnX : columnX;
+            const bool steep = absoluteY > absoluteX, left = columnX < 0;
+            const int32_t smaller = steep ? absoluteX : absoluteY;
+            const int32_t larger = steep ? absoluteY : absoluteX;
+            const int32_t denominator = larger + (larger == 0 ? 1 : 0);   /* The center gives 0 / 1 */
+
+            /* Octant mirrors as offset + sign * turns; selecting constants keeps the loop free of branches */
+            float turns = atanTurns(static_cast<float>(smaller) / static_cast<float>(denominator));
+            turns = (steep ? 0.25f : 0.0f) + (steep ? -1.0f : 1.0f) * turns;
+            turns = (left ? 0.5f : 0.0f) + (left ? -1.0f : 1.0f) * turns;
+            turns = lowerOffset + lowerSign * turns - start;
+            /* Wrap (-1, 1) to [0, 1); angles just below the start are on it, so they round to index 0 */
+            turns += (turns < -seamTurns ? 1.0f : 0.0f) - (turns >= 1.0f ? 1.0f : 0.0f);
+            indices[i] = static_cast<int32_t>(turns * last + 0.5f);
+        }
+    }
+}
+
+/**
+ * @brief Samples the ramp over one turn.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param ramp Color stops, the first one at the start angle.
+ * @param angleDegrees Start angle, counterclockwise from the positive x axis.
+ */
+kernel::ConicKernel::ConicKernel(const ImageWidth width, const ImageHeight height, const ColorRamp& ramp,
+                                 const uint16_t angleDegrees)
+    : imageWidth(width), imageHeight(height), startTurns(static_cast<double>(angleDegrees % 360) / 360.0),
+      table(ramp.table(tableSize)) {}
+
+/**
+ * @brief Renders count pixels of row y starting at column first into out.
+ *
+ * Table indices are computed a chunk at a time in a branch-free single precision loop that
+ * compilers vectorize (one division per pixel, no transcendental calls), then looked up in a
+ * second pass. Octants are decided on the exact integer coordinates; single precision only
+ * limits the angle to about 1e-7 turns, far below a table entry.
+ *
+ * @param y Row index, 0 being the bottom row.
+ * @param first Column of the first pixel.
+ * @param count Number of pixels, first + count <= width().
+ * @param out Destination for count packed pixels.
+ */
+void kernel::ConicKernel::renderSpan(const ImageHeight y, const ImageWidth first, const ImageWidth count, Pixel* out) const {
+    const auto rowY = static_cast<int32_t>(2 * static_cast<int64_t>(y) + 1 - static_cast<int64_t>(imageHeight));
+    const auto firstX = static_cast<int32_t>(2 * static_cast<int64_t>(first) + 1 - static_cast<int64_t>(imageWidth));
+    const Pixel* entries = table.data();
+
+    int32_t indices[chunkPixels];
+    for (ImageWidth begin = 0; begin < count; begin += chunkPixels) {
+        const auto chunk = static_cast<int32_t>(std::min<ImageWidth>(chunkPixels, count - begin));
+        conicIndices(firstX + 2 * static_cast<int32_t>(begin), rowY, static_cast<float>(startTurns),
+                     static_cast<float>(tableSize - 1), chunk, indices);
+        for (int32_t i = 0; i < chunk; i++) {
+            out[begin + i] = entries[std::clamp(indices[i], 0, static_cast<int32_t>(tableSize - 1))];
+        }
+    }
+}
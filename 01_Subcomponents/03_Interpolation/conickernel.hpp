@@ -0,0 +1,56 @@
+/**
+ * @file conickernel.hpp
+ * @brief Defines the conic (angular) gradient kernel.
+ *
+ * The gradient sweeps counterclockwise around the image center, starting at a given angle
+ * with the first stop and ending a full turn later with the last one. Instead of atan2 the
+ * angle of every pixel is reduced to the first octant, where r = min(|X|, |Y|) / max(|X|, |Y|)
+ * lies in [0, 1] and atan(r) is a short odd polynomial (error below 2e-6 turns, a fraction of
+ * a table entry). The octant is restored with selects, so the loop has no branches:
+ *
+ *     t = octant(X, Y, atan(r)) - start, wrapped to [0, 1)
+ *     c(x, y) = table[floor(t * (tableSize - 1) + 1/2)]
+ *
+ * Pixels on the start angle may land up to that error below it; they are not wrapped, so the
+ * seam takes the first stop.
+ *
+ * X and Y are the doubled coordinates of radialkernel.hpp, so the center is exact.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "colorramp.hpp"
+#include "types.hpp"
+
+namespace kernel {
+    /**
+     * @class ConicKernel
+     * @brief Produces rows of a conic gradient through N color stops.
+     */
+    class ConicKernel {
+    public:
+        ConicKernel(ImageWidth width, ImageHeight height, const ColorRamp& ramp, uint16_t angleDegrees);
+
+        void renderSpan(ImageHeight y, ImageWidth first, ImageWidth count, Pixel* out) const;
+
+        /**
+         * @brief Renders the full row y into out.
+         */
+        void renderRow(const ImageHeight y, Pixel* out) const {
+            renderSpan(y, 0, imageWidth, out);
+        }
+
+        [[nodiscard]] ImageWidth width() const { return imageWidth; }
+        [[nodiscard]] ImageHeight height() const { return imageHeight; }
+    private:
+        static constexpr size_t tableSize = 4096;
+        static constexpr size_t chunkPixels = 512;   /* Pixels whose table indices are computed in one pass */
+
+        ImageWidth imageWidth;
+        ImageHeight imageHeight;
+        double startTurns;   /* Start angle as a fraction of a turn */
+        std::vector<Pixel> table;
+    };
+}
@@ -0,0 +1,48 @@
+/**
+ * @file constexprgradient.hpp
+ * @brief Generates small fixed-size gradients at compile time, e.g. for icons or color LUTs.
+ *
+ * The results are bit-identical to the files written by the program: the same fixed-point
+ * kernel (bilinearkernel.hpp) is evaluated by the compiler. Compile-time evaluation is
+ * bounded by the compiler's constexpr step limit, so keep the images to a few thousand pixels.
+ *
+ *     constexpr auto icon = gradient::make<16, 16>(0xf800, 0x07e0, 0x001f, 0xffff);
+ *     constexpr auto ramp = gradient::makeLut<64>(0x0000, 0xffff);
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "bilinearkernel.hpp"
+#include "types.hpp"
+
+namespace gradient {
+    /**
+     * @brief Generates a Width x Height bilinear gradient.
+     *
+     * @return Packed pixels, top row first like the output files.
+     */
+    template <ImageWidth Width, ImageHeight Height>
+    [[nodiscard]] constexpr std::array<Pixel, Width * Height> make(const Pixel tl, const Pixel tr,
+                                                                   const Pixel bl, const Pixel br) {
+        static_assert(Width > 0 && Height > 0, "A gradient needs at least one pixel");
+        std::array<Pixel, Width * Height> pixels{};
+        const kernel::BilinearKernel bilinear(Width, Height, tl, tr, bl, br);
+        for (ImageHeight row = 0; row < Height; row++) {
+            kernel::renderRowScalar(bilinear.setupRow(Height - 1 - row), pixels.data() + row * Width, Width);
+        }
+        return pixels;
+    }
+
+    /**
+     * @brief Generates a Size-entry lookup table ramping from first to last.
+     */
+    template <size_t Size>
+    [[nodiscard]] constexpr std::array<Pixel, Size> makeLut(const Pixel first, const Pixel last) {
+        return make<Size, 1>(first, last, first, last);
+    }
+
+    static_assert(make<2, 2>(0xf800, 0x07e0, 0x001f, 0xffff) == std::array<Pixel, 4>{0xf800, 0x07e0, 0x001f, 0xffff});
+    static_assert(makeLut<3>(0x0000, 0xffff)[1] == 0x8410);
+}
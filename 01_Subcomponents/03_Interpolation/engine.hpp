@@ -0,0 +1,257 @@
+/**
+ * @file engine.hpp
+ * @brief Defines the compile-time specialized engine that renders and encodes whole images.
+ *
+ * An engine combines a row kernel policy (how pixels are interpolated) with a row encoding
+ * policy (how a row of pixels becomes output bytes). Both are template parameters, so the
+ * loop rendering and encoding a band of rows is instantiated for every combination and the
+ * kernel, with its corner values, is held by value. The only runtime choice left is a single
+ * switch on the output format per image, see withEncoding().
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "hexencoder.hpp"
+#include "rawencoder.hpp"
+#include "replicate.hpp"
+#include "stats.hpp"
+#include "threadpool.hpp"
+#include "types.hpp"
+
+namespace engine {
+    /**
+     * @concept RowKernel
+     * @brief Produces any row of an image independently of the others.
+     */
+    template <typename T>
+    concept RowKernel = requires(const T& kernel, ImageHeight y, Pixel* out) {
+        kernel.renderRow(y, out);
+        { kernel.width() } -> std::convertible_to<ImageWidth>;
+        { kernel.height() } -> std::convertible_to<ImageHeight>;
+    };
+
+    /**
+     * @concept SpanKernel
+     * @brief Row kernel that also renders part of a row from absolute coordinates.
+     */
+    template <typename T>
+    concept SpanKernel = RowKernel<T> && requires(const T& kernel, ImageHeight y, ImageWidth first, ImageWidth count, Pixel* out) {
+        kernel.renderSpan(y, first, count, out);
+    };
+
+    /**
+     * @concept ShapedKernel
+     * @brief Row kernel that knows whether its rows are identical or single colored, see RowShape.
+     */
+    template <typename T>
+    concept ShapedKernel = RowKernel<T> && requires(const T& kernel) {
+        { kernel.shape() } -> std::same_as<RowShape>;
+    };
+
+    /**
+     * @class RegionKernel
+     * @brief Row kernel of a rectangle of a larger image (--region).
+     *
+     * Rows and columns are translated to the full image, whose dimensions the wrapped kernel
+     * keeps, and rendered with renderSpan(), so every pixel equals the same pixel of the full
+     * render. A region covering the whole image renders the full rows.
+     */
+    template <SpanKernel Kernel>
+    class RegionKernel {
+    public:
+        RegionKernel(Kernel kernel, const Region& region) : full(std::move(kernel)), region(region) {}
+
+        /**
+         * @brief Renders row y of the region, 0 being its bottom row.
+         */
+        void renderRow(const ImageHeight y, Pixel* out) const {
+            full.renderSpan(full.height() - region.y - region.height + y, region.x, region.width, out);
+        }
+
+        [[nodiscard]] ImageWidth width() const { return region.width; }
+        [[nodiscard]] ImageHeight height() const { return region.height; }
+
+        /**
+         * @brief Shape of the full image, which every rectangle of it shares.
+         */
+        [[nodiscard]] RowShape shape() const requires ShapedKernel<Kernel> { return full.shape(); }
+    private:
+        Kernel full;
+        Region region;
+    };
+
+    /**
+     * @concept RowEncoding
+     * @brief Encodes a row of pixels into a fixed number of output bytes.
+     *
+     * rendersInPlace tells whether the encoded row is the pixel row itself, so rows can be
+     * rendered straight into the output. encodeConstantRow() encodes a row of one color
+     * without looking at the pixels.
+     */
+    template <typename T>
+    concept RowEncoding = requires(const Pixel* row, Pixel pixel, ImageWidth width, char* out) {
+        { T::rowBytes(width) } -> std::convertible_to<size_t>;
+        { T::encodeRow(row, width, out) } -> std::same_as<char*>;
+        { T::encodeConstantRow(pixel, width, out) } -> std::same_as<char*>;
+        { T::rendersInPlace } -> std::convertible_to<bool>;
+    };
+
+    /**
+     * @struct TextEncoding
+     * @brief The hex text format, see hexencoder.hpp.
+     */
+    struct TextEncoding {
+        static constexpr bool rendersInPlace = false;
+
+        [[nodiscard]] static constexpr size_t rowBytes(const ImageWidth width) {
+            return hexencoder::rowBytes(width);
+        }
+        static char* encodeRow(const Pixel* row, const ImageWidth width, char* out) {
+            return hexencoder::encodeRow(row, width, out);
+        }
+        static char* encodeConstantRow(const Pixel pixel, const ImageWidth width, char* out) {
+            return hexencoder::encodeConstantRow(pixel, width, out);
+        }
+    };
+
+    /**
+     * @struct RawEncoding
+     * @brief Packed little-endian RGB565 values, see rawencoder.hpp.
+     */
+    struct RawEncoding {
+        static constexpr bool rendersInPlace = rawencoder::rendersInPlace;
+
+        [[nodiscard]] static constexpr size_t rowBytes(const ImageWidth width) {
+            return rawencoder::rowBytes(width);
+        }
+        static char* encodeRow(const Pixel* row, const ImageWidth width, char* out) {
+            return rawencoder::encodeRow(row, width, out);
+        }
+        static char* encodeConstantRow(const Pixel pixel, const ImageWidth width, char* out) {
+            return rawencoder::encodeConstantRow(pixel, width, out);
+        }
+    };
+
+    /**
+     * @class Engine
+     * @brief Renders and encodes images of one kernel in one encoding.
+     */
+    template <RowKernel Kernel, RowEncoding Encoding>
+    class Engine {
+    public:
+        constexpr explicit Engine(const Kernel& kernel) : kernel(kernel) {}
+
+        [[nodiscard]] constexpr size_t rowBytes() const { return Encoding::rowBytes(kernel.width()); }
+        [[nodiscard]] constexpr size_t imageBytes() const { return rowBytes() * kernel.height(); }
+
+        /**
+         * @brief Renders and encodes count output rows starting at output row first.
+         *
+         * Output row 0 is the top row of the image (kernel row height - 1). Kernels that
+         * report their shape skip the work a degenerate image does not need: identical rows
+         * are encoded once and copied, single colored rows are encoded from their one color.
+         *
+         * @param first First output row.
+         * @param count Number of rows.
+         * @param out Destination of count * rowBytes() bytes.
+         * @param scratch Row of width() pixels; unused when the encoding renders in place.
+         */
+        void encodeRows(const ImageHeight first, const ImageHeight count, char* out, Pixel* scratch) const {
+            const RowShape shape = rowShape();
+            const size_t bytes = rowBytes();
+            if (rowsIdentical(shape) && count > 1) {
+                encodeRow(first, out, scratch, shape);
+                const stats::Scope encoding(stats::Stage::ENCODE, stats::Scope::CPU);
+                replicate::repeat(out, bytes, bytes * count);
+                return;
+            }
+            for (ImageHeight index = first; index < first + count; index++, out += bytes) {
+                encodeRow(index, out, scratch, shape);
+            }
+        }
+
+        /**
+         * @brief Renders and encodes the whole image, with bands of rows spread over the pool.
+         *
+         * Rendering and encoding interleave row by row, so their wall time is reported as
+         * generation while CPU time is split between the two stages. Encodings that do not
+         * render in place render into a row buffer each pool thread keeps between images.
+         *
+         * @param pool Thread pool encoding the bands.
+         * @param destination Buffer of imageBytes() bytes; the top row of the image comes first.
+         */
+        void encodeImage(ThreadPool& pool, char* destination) const {
+            const size_t rowsPerBand = std::max<size_t>(bandBytes / (rowBytes() + 1), 1);
+            stats::addPixels(kernel.width() * kernel.height());
+            const stats::Scope timing(stats::Stage::GENERATE, stats::Scope::WALL);
+            pool.parallelFor(kernel.height(), rowsPerBand, [this, destination](const size_t begin, const size_t end) {
+                thread_local std::vector<Pixel> scratch;
+                if (!Encoding::rendersInPlace && scratch.size() < kernel.width()) {
+                    scratch.resize(kernel.width());
+                }
+                encodeRows(begin, end - begin, destination + begin * rowBytes(), scratch.data());
+            });
+        }
+    private:
+        static constexpr size_t bandBytes = 256 * 1024;   /* Approximate output bytes handed to one thread */
+
+        [[nodiscard]] RowShape rowShape() const {
+            if constexpr (ShapedKernel<Kernel>) {
+                return kernel.shape();
+            } else {
+                return RowShape::GENERAL;
+            }
+        }
+
+        /* Renders and encodes output row index */
+        void encodeRow(const ImageHeight index, char* out, Pixel* scratch, const RowShape shape) const {
+            const ImageHeight y = kernel.height() - 1 - index;
+            if constexpr (Encoding::rendersInPlace) {
+                const stats::Scope generating(stats::Stage::GENERATE, stats::Scope::CPU);
+                kernel.renderRow(y, reinterpret_cast<Pixel*>(out));
+            } else {
+                {
+                    const stats::Scope generating(stats::Stage::GENERATE, stats::Scope::CPU);
+                    kernel.renderRow(y, scratch);
+                }
+                const stats::Scope encoding(stats::Stage::ENCODE, stats::Scope::CPU);
+                if (rowsConstant(shape) && kernel.width() > 0) {
+                    Encoding::encodeConstantRow(scratch[0], kernel.width(), out);
+                } else {
+                    Encoding::encodeRow(scratch, kernel.width(), out);
+                }
+            }
+        }
+
+        Kernel kernel;
+    };
+
+    /**
+     * @brief Calls body with the engine of the kernel for the given output format.
+     *
+     * This is the only place the output format is looked at; everything body does with the
+     * engine is resolved at compile time. The compact format has no fixed row size and is only
+     * written through FileHandler; the tiled format is written by tiled::Writer.
+     *
+     * @throws std::invalid_argument For the compact and tiled formats.
+     */
+    template <RowKernel Kernel, typename Body>
+    decltype(auto) withEncoding(const Kernel& kernel, const OutputFormat format, Body&& body) {
+        if (format == OutputFormat::RLE) {
+            throw std::invalid_argument("The rle format can only be written row by row");
+        }
+        if (format == OutputFormat::TILED) {
+            throw std::invalid_argument("The tiled format can only be written tile by tile");
+        }
+        if (format == OutputFormat::RAW) {
+            return body(Engine<Kernel, RawEncoding>(kernel));
+        }
+        return body(Engine<Kernel, TextEncoding>(kernel));
+    }
+}
@@ -0,0 +1,60 @@
+/**
+ * @file gradienttype.cpp
+ * @brief Implements the conversion between --gradient names and interpolation types.
+ */
+
+#include <iterator>
+#include <stdexcept>
+#include "gradienttype.hpp"
+
+namespace {
+    struct Name {
+        InterpolationType type;
+        const char* name;
+    };
+
+    constexpr Name names[] = {
+        {InterpolationType::BILINEAR, "bilinear"},
+        {InterpolationType::LINEAR, "linear"},
+        {InterpolationType::RADIAL, "radial"},
+        {InterpolationType::CONIC, "conic"},
+    };
+}
+
+/**
+ * @brief Converts a --gradient value to an InterpolationType.
+ *
+ * @throws std::invalid_argument If the name is unknown.
+ */
+InterpolationType gradienttype::parse(const std::string& name) {
+    for (const Name& entry : names) {
+        if (name == entry.name) {
+            return entry.type;
+        }
+    }
+    throw std::invalid_argument("Unknown gradient type: " + name);
+}
+
+/** @brief Returns the --gradient name of a type. */
+const char* gradienttype::toString(const InterpolationType type) {
+    for (const Name& entry : names) {
+        if (type == entry.type) {
+            return entry.name;
+        }
+    }
+    return "unknown";
+}
+
+/** @brief Returns the name of a row shape, as shown in the verbose output. */
+const char* gradienttype::toString(const RowShape shape) {
+    switch (shape) {
+    case RowShape::SOLID:
+        return "solid";
+    case RowShape::HORIZONTAL:
+        return "horizontal";
+    case RowShape::VERTICAL:
+        return "vertical";
+    default:
+        return "general";
+    }
+}
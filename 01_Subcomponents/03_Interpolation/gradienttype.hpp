@@ -0,0 +1,15 @@
+/**
+ * @file gradienttype.hpp
+ * @brief Declares the conversion between --gradient names and interpolation types.
+ */
+
+#pragma once
+
+#include <string>
+#include "types.hpp"
+
+namespace gradienttype {
+    [[nodiscard]] InterpolationType parse(const std::string& name);
+    [[nodiscard]] const char* toString(InterpolationType type);
+    [[nodiscard]] const char* toString(RowShape shape);
+}
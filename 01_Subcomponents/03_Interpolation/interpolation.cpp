@@ -3,23 +3,49 @@
  * @brief Contains implementations for the InterpolationFactory, Interpolation, and BilinearInterpolation classes.
  */
 
+#include <algorithm>
+#include <cstring>
 #include "interpolation.hpp"
-#include "rgb565.hpp"
+#include "engine.hpp"
+#include "stats.hpp"
+
+namespace {
+    /* Kernel policy forwarding to the virtual renderRow(), for interpolations without their own engine */
+    struct VirtualRows {
+        const Interpolation& interpolation;
+        ImageWidth columns;
+        ImageHeight rows;
+
+        void renderRow(const ImageHeight y, Pixel* out) const { interpolation.renderRow(y, out); }
+        [[nodiscard]] ImageWidth width() const { return columns; }
+        [[nodiscard]] ImageHeight height() const { return rows; }
+        [[nodiscard]] RowShape shape() const { return interpolation.shape(); }
+    };
+}
 
 /**
  * @brief Creates an instance of an Interpolation object based on the specified type.
  *
- * @param parser A shared pointer to an ArgParser object containing image parameters.
- * @param type The type of interpolation to create (e.g., BILINEAR).
+ * @param parameters Image size, colors, gradient type and region.
  * @return A shared pointer to the created Interpolation object.
- * @throws std::invalid_argument if an invalid InterpolationType is provided.
+ * @throws std::invalid_argument if an invalid InterpolationType is provided or the parameters are out of range.
  */
-std::shared_ptr<Interpolation> InterpolationFactory::get(const std::shared_ptr<ArgParser>& parser, InterpolationType type)
+std::shared_ptr<Interpolation> InterpolationFactory::get(const gradient::Parameters& parameters)
 {
-    switch (type)
+    const gradient::Parameters& p = parameters;
+    switch (p.type)
     {
     case InterpolationType::BILINEAR:
-        return std::make_shared<BilinearInterpolation>(parser);
+        return std::make_shared<BilinearInterpolation>(p);
+    case InterpolationType::LINEAR:
+        return std::make_shared<LinearInterpolation>(p, kernel::LinearKernel(
+            p.width, p.height, kernel::ColorRamp(p.colorStops()), p.angle));
+    case InterpolationType::RADIAL:
+        return std::make_shared<RadialInterpolation>(p, kernel::RadialKernel(
+            p.width, p.height, kernel::ColorRamp(p.colorStops())));
+    case InterpolationType::CONIC:
+        return std::make_shared<ConicInterpolation>(p, kernel::ConicKernel(
+            p.width, p.height, kernel::ColorRamp(p.colorStops()), p.angle));
     default:
         throw std::invalid_argument("Invalid Interpolation Type");
     }
@@ -28,69 +54,132 @@ std::shared_ptr<Interpolation> InterpolationFactory::get(const std::shared_ptr<A
 /**
  * @brief Constructs an Interpolation object.
  *
- * Initializes the Interpolation object with the provided argument parser.
- * Ensures that the image dimensions are positive.
+ * Checks the parameters and keeps the rendered rectangle.
  *
- * @param argParser A shared pointer to an ArgParser object.
- * @throws std::invalid_argument if width or height are non-positive.
+ * @param parameters Image parameters.
+ * @throws std::invalid_argument if the parameters are out of range (gradient::Parameters::validate).
  */
-Interpolation::Interpolation(const std::shared_ptr<ArgParser>& argParser) {
-    if (argParser->getImageWidth() < 0 || argParser->getImageHeight() < 0) {
-        throw std::invalid_argument("Width and height must be positive");
-    }
-    args = argParser;
+Interpolation::Interpolation(const gradient::Parameters& parameters) : output(parameters.output()) {
+    parameters.validate();
 }
 
 /**
- * @brief Constructs a BilinearInterpolation object.
+ * @brief Generates the color gradient matrix on the calling thread.
  *
- * Initializes the BilinearInterpolation object with the provided argument parser.
- *
- * @param argParser A shared pointer to an ArgParser object.
+ * @return A ResultGradient containing the interpolated RGB565 colors.
  */
-BilinearInterpolation::BilinearInterpolation(const std::shared_ptr<ArgParser>& argParser) :
-                                            Interpolation(argParser) {}
+ResultGradient Interpolation::generate() {
+    const stats::Scope timing(stats::Stage::GENERATE);
+    ResultGradient gradient(output.width, output.height);
+    stats::addPixels(gradient.width() * gradient.height());
+
+    renderRows(0, gradient.height(), gradient.row(0), gradient.stride());
+
+    return gradient;
+}
 
 /**
- * @brief Generates a bilinear-interpolated color gradient matrix.
+ * @brief Generates the color gradient matrix with row bands spread over a thread pool.
  *
- * Computes a bilinear interpolation over the specified image dimensions and returns a 2D matrix of RGB565 colors.
- * The interpolation is performed independently for each color channel (red, green, blue).
+ * Rows are independent, so the result is identical to the single-threaded generate().
  *
- * @return A ResultGradient containing the interpolated RGB565 color matrix.
- * @throws std::invalid_argument if an invalid color is specified in getColor.
+ * @param pool Thread pool rendering the bands.
+ * @return A ResultGradient containing the interpolated RGB565 colors.
  */
-ResultGradient BilinearInterpolation::generate() {
-    ResultGradient gradient(args->getImageHeight(), std::vector<rgb565::RGB565>(args->getImageWidth()));
-    auto getRed =   [this](auto color) { return (color & rgb565::redMask)   >> rgb565::redShift; };
-    auto getGreen = [this](auto color) { return (color & rgb565::greenMask) >> rgb565::greenShift; };
-    auto getBlue =  [this](auto color) { return (color & rgb565::blueMask)  >> rgb565::blueShift; };
-
-    auto getColor = [this, getRed, getBlue, getGreen](const auto color, const rgb565::Color selectedColor) {
-        if (rgb565::Color::RED == selectedColor) return getRed(color);
-        if (rgb565::Color::GREEN == selectedColor) return getGreen(color);
-        if (rgb565::Color::BLUE == selectedColor) return getBlue(color);
-        throw std::invalid_argument("Invalid color\n");
-    };
+ResultGradient Interpolation::generate(ThreadPool& pool) {
+    const stats::Scope timing(stats::Stage::GENERATE, stats::Scope::WALL);
+    ResultGradient gradient(output.width, output.height);
+    stats::addPixels(gradient.width() * gradient.height());
+    const size_t rowsPerBand = std::max<size_t>(bandBytes / (gradient.stride() * sizeof(Pixel) + 1), 1);
 
-    for (ImageHeight y = 0; y < args->getImageHeight(); y++) {
-        const float positionBottomToTop = static_cast<float>(y) / static_cast<float>(args->getImageHeight()); /* Vertical position (0 to 1) */
-        const float positionTopToBottom = 1.0F - positionBottomToTop;
-        for (ImageWidth x = 0; x < args->getImageWidth(); x++) {
-            const float positionLeftToRight = static_cast<float>(x) / static_cast<float>(args->getImageHeight()); /* Horizontal position (0 to 1) */
-            const float positionRightToLeft = 1.0F - positionLeftToRight;
-            /* Interpolating each color (R, G, B) independently */
-            for (const auto selectedColor : rgb565::allColors) {
-                /* Bilinear interpolation formula */
-                const auto newColor = static_cast<uint8_t>(positionTopToBottom * positionRightToLeft * static_cast<float>(getColor(args->getBottomLeft(), selectedColor))
-                                                         + positionTopToBottom * positionLeftToRight * static_cast<float>(getColor(args->getBottomRight(), selectedColor))
-                                                         + positionBottomToTop * positionRightToLeft * static_cast<float>(getColor(args->getTopLeft(), selectedColor))
-                                                         + positionBottomToTop * positionLeftToRight * static_cast<float>(getColor(args->getTopRight(), selectedColor)));
-
-                gradient[y][x].setColor(newColor, selectedColor);
-            }
+    pool.parallelFor(gradient.height(), rowsPerBand, [this, &gradient](const size_t begin, const size_t end) {
+        const stats::Scope bandTiming(stats::Stage::GENERATE, stats::Scope::CPU);
+        renderRows(static_cast<ImageHeight>(begin), static_cast<ImageHeight>(end - begin),
+                   gradient.row(static_cast<ImageHeight>(begin)), gradient.stride());
+    });
+
+    return gradient;
+}
+
+/**
+ * @brief Renders count consecutive rows starting at row first.
+ *
+ * When every row of the image is the same (shape()), the first row is rendered and copied to
+ * the others, so a horizontal or solid gradient is produced at memory bandwidth.
+ *
+ * @param first Row index of the first row, 0 being the bottom row.
+ * @param count Number of rows.
+ * @param out Destination of row first; row first + i starts i * stride pixels later.
+ * @param stride Pixels between the starts of two rows, at least output.width.
+ */
+void Interpolation::renderRows(const ImageHeight first, const ImageHeight count, Pixel* out, const size_t stride) const {
+    if (count == 0) {
+        return;
+    }
+    renderRow(first, out);
+    const bool identical = rowsIdentical(shape());
+    for (ImageHeight row = 1; row < count; row++) {
+        if (identical) {
+            std::memcpy(out + row * stride, out, static_cast<size_t>(output.width) * sizeof(Pixel));
+        } else {
+            renderRow(first + row, out + row * stride);
         }
     }
+}
 
-    return gradient;
-}
\ No newline at end of file
+/**
+ * @brief Renders and encodes the whole image into destination.
+ *
+ * This generic version calls renderRow() once per row.
+ *
+ * @param pool Thread pool encoding the bands.
+ * @param format Encoding of the rows.
+ * @param destination Buffer for the whole encoded image, top row first.
+ */
+void Interpolation::encodeImage(ThreadPool& pool, const OutputFormat format, char* destination) const {
+    const VirtualRows rows{*this, output.width, output.height};
+    engine::withEncoding(rows, format, [&pool, destination](const auto& compiled) {
+        compiled.encodeImage(pool, destination);
+    });
+}
+
+/**
+ * @brief Constructs a BilinearInterpolation object.
+ *
+ * Unpacks the corner colors into the fixed-point kernel.
+ *
+ * @param parameters Image parameters.
+ */
+BilinearInterpolation::BilinearInterpolation(const gradient::Parameters& parameters) :
+                                            Interpolation(parameters),
+                                            bilinear(kernel::BilinearKernel(parameters.width, parameters.height,
+                                                                            parameters.tl, parameters.tr,
+                                                                            parameters.bl, parameters.br),
+                                                     output) {}
+
+/**
+ * @brief Renders one row of the bilinear gradient.
+ *
+ * The fixed-point kernel steps every channel along the row, so no floating point math or
+ * per-channel dispatch happens per pixel. The exact rounding rule is documented in
+ * bilinearkernel.hpp.
+ *
+ * @param y Row index, 0 being the bottom row.
+ * @param out Destination for one row of packed pixels.
+ */
+void BilinearInterpolation::renderRow(const ImageHeight y, Pixel* out) const {
+    bilinear.renderRow(y, out);
+}
+
+/**
+ * @brief Renders and encodes the whole image with the engine compiled for the bilinear kernel.
+ *
+ * @param pool Thread pool encoding the bands.
+ * @param format Encoding of the rows.
+ * @param destination Buffer for the whole encoded image, top row first.
+ */
+void BilinearInterpolation::encodeImage(ThreadPool& pool, const OutputFormat format, char* destination) const {
+    engine::withEncoding(bilinear, format, [&pool, destination](const auto& compiled) {
+        compiled.encodeImage(pool, destination);
+    });
+}
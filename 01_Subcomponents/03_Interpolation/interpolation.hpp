@@ -1,28 +1,49 @@
 /**
  * @file interpolation.hpp
- * @brief Defines the Interpolation base class, BilinearInterpolation derived class, and InterpolationFactory.
+ * @brief Defines the Interpolation base class, its derived classes, and InterpolationFactory.
  */
 
 #pragma once
 
-#include <argparser.hpp>
+#include <bilinearkernel.hpp>
+#include <conickernel.hpp>
+#include <engine.hpp>
+#include <linearkernel.hpp>
+#include <radialkernel.hpp>
+#include <framebuffer.hpp>
 #include <memory>
+#include <parameters.hpp>
+#include <threadpool.hpp>
 #include <types.hpp>
-#include <vector>
 
 /**
  * @class Interpolation
  * @brief Abstract base class for various interpolation methods.
  *
- * Provides an interface for generating interpolated color gradients.
+ * Provides an interface for generating interpolated color gradients. Every row only depends
+ * on its index, so derived classes implement renderRow() and generate() splits the image
+ * into row bands that may be rendered in parallel. encodeImage() renders and encodes a whole
+ * image; derived classes override it with the engine compiled for their kernel (engine.hpp),
+ * so the only virtual call is the one per image. Kernels are built for the full image and
+ * wrapped in an engine::RegionKernel, so the rows are those of the requested region.
+ * Interpolations only see gradient::Parameters, never the command line, so they are shared by
+ * the CLI and the gradient_core library (gradientcore.hpp). shape() tells the writers which
+ * degenerate case, if any, the image is, so identical rows are rendered and encoded once.
  */
 class Interpolation {
 public:
     virtual ~Interpolation() = default;
-    virtual ResultGradient generate() = 0;
+    [[nodiscard]] ResultGradient generate();
+    [[nodiscard]] ResultGradient generate(ThreadPool& pool);
+    virtual void renderRow(ImageHeight y, Pixel* out) const = 0;
+    virtual void encodeImage(ThreadPool& pool, OutputFormat format, char* destination) const;
+    [[nodiscard]] virtual RowShape shape() const { return RowShape::GENERAL; }
+    void renderRows(ImageHeight first, ImageHeight count, Pixel* out, size_t stride) const;
 protected:
-    std::shared_ptr<ArgParser> args;
-    explicit Interpolation(const std::shared_ptr<ArgParser>& argParser);
+    Region output;  /* Rendered rectangle of the image */
+    explicit Interpolation(const gradient::Parameters& parameters);
+
+    static constexpr size_t bandBytes = 128 * 1024;  /* Approximate size of a row band handed to one thread */
 };
 
 /**
@@ -33,10 +54,43 @@ protected:
  */
 class BilinearInterpolation : public Interpolation {
 public:
-    explicit BilinearInterpolation(const std::shared_ptr<ArgParser>& argParser);
-    [[nodiscard]] ResultGradient generate() override;
+    explicit BilinearInterpolation(const gradient::Parameters& parameters);
+    void renderRow(ImageHeight y, Pixel* out) const override;
+    void encodeImage(ThreadPool& pool, OutputFormat format, char* destination) const override;
+    [[nodiscard]] RowShape shape() const override { return bilinear.shape(); }
+private:
+    engine::RegionKernel<kernel::BilinearKernel> bilinear;
+};
+
+/**
+ * @class KernelInterpolation
+ * @brief Derived class wrapping a row kernel, used by the gradients built from color stops.
+ *
+ * The kernel samples its color stops into a lookup table once, on construction.
+ */
+template <engine::SpanKernel Kernel>
+class KernelInterpolation : public Interpolation {
+public:
+    KernelInterpolation(const gradient::Parameters& parameters, Kernel kernel)
+        : Interpolation(parameters), kernel(std::move(kernel), output) {}
+
+    void renderRow(const ImageHeight y, Pixel* out) const override {
+        kernel.renderRow(y, out);
+    }
+
+    void encodeImage(ThreadPool& pool, const OutputFormat format, char* destination) const override {
+        engine::withEncoding(kernel, format, [&pool, destination](const auto& compiled) {
+            compiled.encodeImage(pool, destination);
+        });
+    }
+private:
+    engine::RegionKernel<Kernel> kernel;
 };
 
+using LinearInterpolation = KernelInterpolation<kernel::LinearKernel>;   /* N-stop linear gradient */
+using RadialInterpolation = KernelInterpolation<kernel::RadialKernel>;   /* N-stop radial gradient */
+using ConicInterpolation = KernelInterpolation<kernel::ConicKernel>;     /* N-stop conic gradient */
+
 /**
 * @class InterpolationFactory
 * @brief Factory class for creating instances of various Interpolation types.
@@ -45,5 +99,5 @@ public:
 */
 class InterpolationFactory {
 public:
-    static std::shared_ptr<Interpolation> get(const std::shared_ptr<ArgParser>& parser, InterpolationType type);
+    static std::shared_ptr<Interpolation> get(const gradient::Parameters& parameters);
 };
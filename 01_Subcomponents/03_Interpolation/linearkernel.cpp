@@ -0,0 +1,89 @@
+/**
+ * @file linearkernel.cpp
+ * @brief Implements the multi-stop linear gradient kernel.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include "linearkernel.hpp"
+#include "simdkernel.hpp"
+
+namespace {
+    constexpr int positionBits = 32;   /* Fractional bits of the table positions */
+
+    /**
+     * @brief Computes the table indices of count pixels of one row.
+     *
+     * @param position Q32.32 position of the first pixel; advanced past the last one.
+     * @param step Added per pixel.
+     * @param count Number of pixels.
+     * @param indices Destination for count indices, not yet clamped.
+     */
+    GRADIENT_VECTOR_CLONES
+    void linearIndices(int64_t& position, const int64_t step, const int32_t count, int32_t* indices) {
+        int64_t current = position;
+        for (int32_t i = 0; i < count; i++) {
+            indices[i] = static_cast<int32_t>(current >> positionBits);   /* Stays within int32 for any image size */
+            current += step;
+        }
+        position = current;
+    }
+}
+
+/**
+ * @brief Samples the ramp and derives the fixed-point steps from the angle.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param ramp Color stops, the first one at the start of the gradient.
+ * @param angleDegrees Direction of the gradient, counterclockwise: 0 runs from left to right,
+ * 90 from the bottom to the top.
+ */
+kernel::LinearKernel::LinearKernel(const ImageWidth width, const ImageHeight height, const ColorRamp& ramp,
+                                   const uint16_t angleDegrees)
+    : imageWidth(width), imageHeight(height), table(ramp.table(tableSize)) {
+    const double radians = static_cast<double>(angleDegrees % 360) * std::numbers::pi / 180.0;
+    const double dx = std::cos(radians), dy = std::sin(radians);
+    const double right = static_cast<double>(width > 0 ? width - 1 : 0);
+    const double top = static_cast<double>(height > 0 ? height - 1 : 0);
+
+    /* Projections of the four corners on the direction bound the gradient */
+    const double corners[] = {0.0, right * dx, top * dy, right * dx + top * dy};
+    const double lowest = *std::min_element(std::begin(corners), std::end(corners));
+    const double highest = *std::max_element(std::begin(corners), std::end(corners));
+    const double span = highest - lowest;
+    if (span < 1e-9) {
+        return; /* A single pixel or a direction across a single row or column: the first stop only */
+    }
+
+    const double scale = static_cast<double>(tableSize - 1) / span * std::ldexp(1.0, positionBits);
+    start = std::llround(-lowest * scale + std::ldexp(0.5, positionBits));
+    rowStep = std::llround(dy * scale);
+    columnStep = std::llround(dx * scale);
+}
+
+/**
+ * @brief Renders count pixels of row y starting at column first into out.
+ *
+ * Table indices are computed a chunk at a time in a loop whose only dependency is the
+ * position induction, which compilers vectorize, then looked up in a second pass.
+ *
+ * @param y Row index, 0 being the bottom row.
+ * @param first Column of the first pixel.
+ * @param count Number of pixels, first + count <= width().
+ * @param out Destination for count packed pixels.
+ */
+void kernel::LinearKernel::renderSpan(const ImageHeight y, const ImageWidth first, const ImageWidth count, Pixel* out) const {
+    int64_t position = start + static_cast<int64_t>(y) * rowStep + static_cast<int64_t>(first) * columnStep;
+    const Pixel* entries = table.data();
+
+    int32_t indices[chunkPixels];
+    for (ImageWidth begin = 0; begin < count; begin += chunkPixels) {
+        const auto chunk = static_cast<int32_t>(std::min<ImageWidth>(chunkPixels, count - begin));
+        linearIndices(position, columnStep, chunk, indices);
+        for (int32_t i = 0; i < chunk; i++) {
+            out[begin + i] = entries[std::clamp(indices[i], 0, static_cast<int32_t>(tableSize - 1))];
+        }
+    }
+}
@@ -0,0 +1,55 @@
+/**
+ * @file linearkernel.hpp
+ * @brief Defines the incremental multi-stop linear gradient kernel.
+ *
+ * The position of a pixel along the gradient direction is an affine function of x and y,
+ * so it is kept as a Q32.32 index into the color ramp table and stepped with one integer
+ * addition per pixel:
+ *
+ *     p(x, y) = start + y * rowStep + x * columnStep
+ *     c(x, y) = table[clamp(p(x, y) >> 32, 0, tableSize - 1)]
+ *
+ * start, rowStep and columnStep are rounded once from the angle and the image size; the
+ * rounding half is folded into start. The position is 0 at the corner furthest against the
+ * direction and tableSize - 1 at the opposite corner.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "colorramp.hpp"
+#include "types.hpp"
+
+namespace kernel {
+    /**
+     * @class LinearKernel
+     * @brief Produces rows of a linear gradient through N color stops.
+     */
+    class LinearKernel {
+    public:
+        LinearKernel(ImageWidth width, ImageHeight height, const ColorRamp& ramp, uint16_t angleDegrees);
+
+        void renderSpan(ImageHeight y, ImageWidth first, ImageWidth count, Pixel* out) const;
+
+        /**
+         * @brief Renders the full row y into out.
+         */
+        void renderRow(const ImageHeight y, Pixel* out) const {
+            renderSpan(y, 0, imageWidth, out);
+        }
+
+        [[nodiscard]] ImageWidth width() const { return imageWidth; }
+        [[nodiscard]] ImageHeight height() const { return imageHeight; }
+    private:
+        static constexpr size_t tableSize = 4096;
+        static constexpr size_t chunkPixels = 512;   /* Pixels whose table indices are computed in one pass */
+
+        ImageWidth imageWidth;
+        ImageHeight imageHeight;
+        int64_t start = 0;        /* Q32.32 table position of pixel (0, 0), rounding half included */
+        int64_t rowStep = 0;      /* Added per row */
+        int64_t columnStep = 0;   /* Added per pixel */
+        std::vector<Pixel> table;
+    };
+}
@@ -0,0 +1,47 @@
+/**
+ * @file parameters.cpp
+ * @brief Implements the checks and defaults of gradient::Parameters.
+ */
+
+#include <stdexcept>
+#include <string>
+#include "parameters.hpp"
+
+/**
+ * @brief Rectangle of the image that is rendered: the region, or the whole image.
+ */
+Region gradient::Parameters::output() const {
+    return region.value_or(Region{0, 0, width, height});
+}
+
+/**
+ * @brief Color stops of the linear, radial and conic gradients.
+ */
+std::vector<Pixel> gradient::Parameters::colorStops() const {
+    if (stops.empty()) {
+        return {tl, tr, bl, br};
+    }
+    return stops;
+}
+
+/**
+ * @brief Checks the parameters against the limits of the kernels.
+ *
+ * @throws std::invalid_argument If a dimension exceeds maxImageDimension, fewer than two stops
+ * are given, the angle is not below 360 degrees or the region leaves the image.
+ */
+void gradient::Parameters::validate() const {
+    if (width > maxImageDimension || height > maxImageDimension) {
+        throw std::invalid_argument("Image dimension exceeds " + std::to_string(maxImageDimension));
+    }
+    if (stops.size() == 1) {
+        throw std::invalid_argument("At least two color stops are required");
+    }
+    if (angle >= 360) {
+        throw std::invalid_argument("Angle must be below 360 degrees");
+    }
+    if (region && (region->x > width || region->width > width - region->x
+                   || region->y > height || region->height > height - region->y)) {
+        throw std::invalid_argument("Region exceeds the " + std::to_string(width) + " x " + std::to_string(height) + " image");
+    }
+}
@@ -0,0 +1,37 @@
+/**
+ * @file parameters.hpp
+ * @brief Defines the plain description of a gradient image, independent of the command line.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "types.hpp"
+
+namespace gradient {
+    /**
+     * @struct Parameters
+     * @brief Everything that determines the pixels of an image.
+     *
+     * The command line fills it through ArgParser::getParameters(); embedding code fills it
+     * directly.
+     */
+    struct Parameters {
+        ImageWidth width = 0;
+        ImageHeight height = 0;
+        Pixel tl = 0;
+        Pixel tr = 0;
+        Pixel bl = 0;
+        Pixel br = 0;
+        InterpolationType type = InterpolationType::BILINEAR;
+        std::vector<Pixel> stops;       /* Color stops of linear, radial and conic; empty uses tl, tr, bl, br */
+        uint16_t angle = 0;             /* Direction of linear, start angle of conic, in degrees */
+        std::optional<Region> region;   /* Rectangle to render; the whole image when empty */
+
+        [[nodiscard]] Region output() const;
+        [[nodiscard]] std::vector<Pixel> colorStops() const;
+        void validate() const;
+    };
+}
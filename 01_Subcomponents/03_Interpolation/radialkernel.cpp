@@ -0,0 +1,75 @@
+/**
+ * @file radialkernel.cpp
+ * @brief Implements the radial gradient kernel.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "radialkernel.hpp"
+#include "simdkernel.hpp"
+
+namespace {
+    /**
+     * @brief Computes the table indices of count pixels of one row.
+     *
+     * @param firstX Doubled x coordinate of the first pixel.
+     * @param rowDistance Squared doubled y coordinate of the row.
+     * @param scale Table entries per unit of squared distance.
+     * @param count Number of pixels.
+     * @param indices Destination for count indices, not yet clamped.
+     */
+    GRADIENT_VECTOR_CLONES
+    void radialIndices(const int32_t firstX, const double rowDistance, const double scale, const int32_t count,
+                       int32_t* indices) {
+        for (int32_t i = 0; i < count; i++) {
+            const auto columnX = static_cast<double>(firstX + 2 * i);
+            indices[i] = static_cast<int32_t>((columnX * columnX + rowDistance) * scale + 0.5);
+        }
+    }
+}
+
+/**
+ * @brief Samples the ramp by squared distance.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param ramp Color stops, the first one at the center.
+ */
+kernel::RadialKernel::RadialKernel(const ImageWidth width, const ImageHeight height, const ColorRamp& ramp)
+    : imageWidth(width), imageHeight(height), table(tableSize) {
+    const double right = static_cast<double>(width > 0 ? width - 1 : 0);
+    const double top = static_cast<double>(height > 0 ? height - 1 : 0);
+    scale = static_cast<double>(tableSize - 1) / std::max(right * right + top * top, 1.0);
+
+    for (size_t i = 0; i < tableSize; i++) {
+        table[i] = ramp.colorAt(std::sqrt(static_cast<double>(i) / static_cast<double>(tableSize - 1)));
+    }
+}
+
+/**
+ * @brief Renders count pixels of row y starting at column first into out.
+ *
+ * Table indices are computed a chunk at a time in a branch-free loop over int32 coordinates
+ * that compilers vectorize, then looked up in a second pass. Doubled coordinates stay below
+ * 2^25 and their squares below 2^51, so the distances are exact in double precision.
+ *
+ * @param y Row index, 0 being the bottom row.
+ * @param first Column of the first pixel.
+ * @param count Number of pixels, first + count <= width().
+ * @param out Destination for count packed pixels.
+ */
+void kernel::RadialKernel::renderSpan(const ImageHeight y, const ImageWidth first, const ImageWidth count, Pixel* out) const {
+    const double rowY = 2.0 * static_cast<double>(y) - static_cast<double>(imageHeight - 1);
+    const double rowDistance = rowY * rowY;
+    const auto firstX = static_cast<int32_t>(2 * static_cast<int64_t>(first) + 1 - static_cast<int64_t>(imageWidth));
+    const Pixel* entries = table.data();
+
+    int32_t indices[chunkPixels];
+    for (ImageWidth begin = 0; begin < count; begin += chunkPixels) {
+        const auto chunk = static_cast<int32_t>(std::min<ImageWidth>(chunkPixels, count - begin));
+        radialIndices(firstX + 2 * static_cast<int32_t>(begin), rowDistance, scale, chunk, indices);
+        for (int32_t i = 0; i < chunk; i++) {
+            out[begin + i] = entries[std::min(indices[i], static_cast<int32_t>(tableSize - 1))];
+        }
+    }
+}
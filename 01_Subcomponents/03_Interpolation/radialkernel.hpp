@@ -0,0 +1,52 @@
+/**
+ * @file radialkernel.hpp
+ * @brief Defines the radial gradient kernel, which looks colors up by squared distance.
+ *
+ * The gradient is centered on the image and reaches the last stop at the corners. Working
+ * in doubled coordinates X = 2x - (width - 1), Y = 2y - (height - 1) keeps the center on
+ * the integer grid, and every squared distance D = X^2 + Y^2 is an exact integer:
+ *
+ *     c(x, y) = table[floor(D * (tableSize - 1) / Dmax + 1/2)]
+ *
+ * The table holds the ramp sampled at sqrt(i / (tableSize - 1)), so the square root is taken
+ * once per table entry instead of once per pixel. Its 2^16 entries resolve the steep start of
+ * the square root finer than a channel level.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "colorramp.hpp"
+#include "types.hpp"
+
+namespace kernel {
+    /**
+     * @class RadialKernel
+     * @brief Produces rows of a radial gradient through N color stops.
+     */
+    class RadialKernel {
+    public:
+        RadialKernel(ImageWidth width, ImageHeight height, const ColorRamp& ramp);
+
+        void renderSpan(ImageHeight y, ImageWidth first, ImageWidth count, Pixel* out) const;
+
+        /**
+         * @brief Renders the full row y into out.
+         */
+        void renderRow(const ImageHeight y, Pixel* out) const {
+            renderSpan(y, 0, imageWidth, out);
+        }
+
+        [[nodiscard]] ImageWidth width() const { return imageWidth; }
+        [[nodiscard]] ImageHeight height() const { return imageHeight; }
+    private:
+        static constexpr size_t tableSize = 65536;
+        static constexpr size_t chunkPixels = 512;   /* Pixels whose table indices are computed in one pass */
+
+        ImageWidth imageWidth;
+        ImageHeight imageHeight;
+        double scale;   /* (tableSize - 1) / Dmax */
+        std::vector<Pixel> table;
+    };
+}
@@ -0,0 +1,286 @@
+/**
+ * @file simdkernel.cpp
+ * @brief Implements the SSE2, AVX2 and AVX-512 row renderers and selects one from CPUID at startup.
+ */
+
+#include <cstdlib>
+#include <stdexcept>
+#include "simdkernel.hpp"
+#include "rgb565.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GRADIENT_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    /**
+     * @brief Value of a channel accumulator at the given lane, with the same wrapping as the scalar path.
+     */
+    int32_t laneValue(const kernel::ChannelRow& channel, const uint32_t lane) {
+        return static_cast<int32_t>(static_cast<uint32_t>(channel.start) + lane * static_cast<uint32_t>(channel.step));
+    }
+
+#ifdef GRADIENT_X86_SIMD
+    /* ---------------------------------------------------------------- SSE2 */
+
+    __attribute__((target("sse2")))
+    inline __m128i sse2Lanes(const kernel::ChannelRow& channel, const uint32_t first) {
+        return _mm_setr_epi32(laneValue(channel, first), laneValue(channel, first + 1),
+                              laneValue(channel, first + 2), laneValue(channel, first + 3));
+    }
+
+    /* Quantizes 8 accumulators to 16-bit channel values clamped to [0, maximum] */
+    __attribute__((target("sse2")))
+    inline __m128i sse2Quantize(const __m128i low, const __m128i high, const __m128i maximum) {
+        const __m128i half = _mm_set1_epi32(1 << (kernel::fractionBits - 1));
+        const __m128i packed = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(low, half), kernel::fractionBits),
+                                               _mm_srai_epi32(_mm_add_epi32(high, half), kernel::fractionBits));
+        return _mm_min_epi16(_mm_max_epi16(packed, _mm_setzero_si128()), maximum);
+    }
+
+    __attribute__((target("sse2")))
+    void renderRowSse2(const kernel::RowSetup& setup, Pixel* out, const ImageWidth count) {
+        constexpr ImageWidth pixelsPerIteration = 8;
+        const __m128i max5 = _mm_set1_epi16(rgb565::RGB565::max5Bit);
+        const __m128i max6 = _mm_set1_epi16(rgb565::RGB565::max6Bit);
+
+        __m128i redLow = sse2Lanes(setup.red, 0), redHigh = sse2Lanes(setup.red, 4);
+        __m128i greenLow = sse2Lanes(setup.green, 0), greenHigh = sse2Lanes(setup.green, 4);
+        __m128i blueLow = sse2Lanes(setup.blue, 0), blueHigh = sse2Lanes(setup.blue, 4);
+        const __m128i redStep = _mm_set1_epi32(static_cast<int32_t>(pixelsPerIteration * static_cast<uint32_t>(setup.red.step)));
+        const __m128i greenStep = _mm_set1_epi32(static_cast<int32_t>(pixelsPerIteration * static_cast<uint32_t>(setup.green.step)));
+        const __m128i blueStep = _mm_set1_epi32(static_cast<int32_t>(pixelsPerIteration * static_cast<uint32_t>(setup.blue.step)));
+
+        ImageWidth x = 0;
+        for (; x + pixelsPerIteration <= count; x += pixelsPerIteration) {
+            const __m128i pixels = _mm_or_si128(_mm_or_si128(
+                _mm_slli_epi16(sse2Quantize(redLow, redHigh, max5), rgb565::redShift),
+                _mm_slli_epi16(sse2Quantize(greenLow, greenHigh, max6), rgb565::greenShift)),
+                sse2Quantize(blueLow, blueHigh, max5));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), pixels);
+
+            redLow = _mm_add_epi32(redLow, redStep);       redHigh = _mm_add_epi32(redHigh, redStep);
+            greenLow = _mm_add_epi32(greenLow, greenStep); greenHigh = _mm_add_epi32(greenHigh, greenStep);
+            blueLow = _mm_add_epi32(blueLow, blueStep);    blueHigh = _mm_add_epi32(blueHigh, blueStep);
+        }
+        kernel::renderRowScalar(kernel::advance(setup, x), out + x, count - x);
+    }
+
+    /* ---------------------------------------------------------------- AVX2 */
+
+    __attribute__((target("avx2")))
+    inline __m256i avx2Lanes(const kernel::ChannelRow& channel, const uint32_t first) {
+        return _mm256_setr_epi32(laneValue(channel, first), laneValue(channel, first + 1),
+                                 laneValue(channel, first + 2), laneValue(channel, first + 3),
+                                 laneValue(channel, first + 4), laneValue(channel, first + 5),
+                                 laneValue(channel, first + 6), laneValue(channel, first + 7));
+    }
+
+    /* Quantizes 8 accumulators to 32-bit channel values clamped to [0, maximum] */
+    __attribute__((target("avx2")))
+    inline __m256i avx2Quantize(const __m256i accumulator, const __m256i maximum) {
+        const __m256i half = _mm256_set1_epi32(1 << (kernel::fractionBits - 1));
+        const __m256i value = _mm256_srai_epi32(_mm256_add_epi32(accumulator, half), kernel::fractionBits);
+        return _mm256_min_epi32(_mm256_max_epi32(value, _mm256_setzero_si256()), maximum);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i avx2Pixels(const __m256i red, const __m256i green, const __m256i blue,
+                              const __m256i max5, const __m256i max6) {
+        return _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(avx2Quantize(red, max5), rgb565::redShift),
+                                               _mm256_slli_epi32(avx2Quantize(green, max6), rgb565::greenShift)),
+                               avx2Quantize(blue, max5));
+    }
+
+    __attribute__((target("avx2")))
+    void renderRowAvx2(const kernel::RowSetup& setup, Pixel* out, const ImageWidth count) {
+        constexpr ImageWidth pixelsPerIteration = 16;
+        const __m256i max5 = _mm256_set1_epi32(rgb565::RGB565::max5Bit);
+        const __m256i max6 = _mm256_set1_epi32(rgb565::RGB565::max6Bit);
+
+        __m256i redLow = avx2Lanes(setup.red, 0), redHigh = avx2Lanes(setup.red, 8);
+        __m256i greenLow = avx2Lanes(setup.green, 0), greenHigh = avx2Lanes(setup.green, 8);
+        __m256i blueLow = avx2Lanes(setup.blue, 0), blueHigh = avx2Lanes(setup.blue, 8);
+        const __m256i redStep = _mm256_set1_epi32(static_cast<int32_t>(pixelsPerIteration * static_cast<uint32_t>(setup.red.step)));
+        const __m256i greenStep = _mm256_set1_epi32(static_cast<int32_t>(pixelsPerIteration * static_cast<uint32_t>(setup.green.step)));
+        const __m256i blueStep = _mm256_set1_epi32(static_cast<int32_t>(pixelsPerIteration * static_cast<uint32_t>(setup.blue.step)));
+
+        ImageWidth x = 0;
+        for (; x + pixelsPerIteration <= count; x += pixelsPerIteration) {
+            const __m256i low = avx2Pixels(redLow, greenLow, blueLow, max5, max6);
+            const __m256i high = avx2Pixels(redHigh, greenHigh, blueHigh, max5, max6);
+            /* packus interleaves the 128-bit halves, the permute restores pixel order */
+            const __m256i pixels = _mm256_permute4x64_epi64(_mm256_packus_epi32(low, high), 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), pixels);
+
+            redLow = _mm256_add_epi32(redLow, redStep);       redHigh = _mm256_add_epi32(redHigh, redStep);
+            greenLow = _mm256_add_epi32(greenLow, greenStep); greenHigh = _mm256_add_epi32(greenHigh, greenStep);
+            blueLow = _mm256_add_epi32(blueLow, blueStep);    blueHigh = _mm256_add_epi32(blueHigh, blueStep);
+        }
+        kernel::renderRowScalar(kernel::advance(setup, x), out + x, count - x);
+    }
+
+    /* ------------------------------------------------------------- AVX-512 */
+
+    __attribute__((target("avx512f")))
+    inline __m512i avx512Lanes(const kernel::ChannelRow& channel, const uint32_t first) {
+        const __m512i offsets = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        return _mm512_add_epi32(_mm512_set1_epi32(laneValue(channel, first)),
+                                _mm512_mullo_epi32(offsets, _mm512_set1_epi32(channel.step)));
+    }
+
+    __attribute__((target("avx512f")))
+    inline __m512i avx512Quantize(const __m512i accumulator, const __m512i maximum) {
+        const __m512i half = _mm512_set1_epi32(1 << (kernel::fractionBits - 1));
+        const __m512i value = _mm512_srai_epi32(_mm512_add_epi32(accumulator, half), kernel::fractionBits);
+        return _mm512_min_epi32(_mm512_max_epi32(value, _mm512_setzero_si512()), maximum);
+    }
+
+    __attribute__((target("avx512f")))
+    inline __m256i avx512Pixels(const __m512i red, const __m512i green, const __m512i blue,
+                                const __m512i max5, const __m512i max6) {
+        const __m512i pixels = _mm512_or_si512(_mm512_or_si512(_mm512_slli_epi32(avx512Quantize(red, max5), rgb565::redShift),
+                                                               _mm512_slli_epi32(avx512Quantize(green, max6), rgb565::greenShift)),
+                                               avx512Quantize(blue, max5));
+        return _mm512_cvtepi32_epi16(pixels);
+    }
+
+    __attribute__((target("avx512f")))
+    void renderRowAvx512(const kernel::RowSetup& setup, Pixel* out, const ImageWidth count) {
+        constexpr ImageWidth pixelsPerIteration = 32;
+        const __m512i max5 = _mm512_set1_epi32(rgb565::RGB565::max5Bit);
+        const __m512i max6 = _mm512_set1_epi32(rgb565::RGB565::max6Bit);
+
+        __m512i redLow = avx512Lanes(setup.red, 0), redHigh = avx512Lanes(setup.red, 16);
+        __m512i greenLow = avx512Lanes(setup.green, 0), greenHigh = avx512Lanes(setup.green, 16);
+        __m512i blueLow = avx512Lanes(setup.blue, 0), blueHigh = avx512Lanes(setup.blue, 16);
+        const __m512i redStep = _mm512_set1_epi32(static_cast<int32_t>(pixelsPerIteration * static_cast<uint32_t>(setup.red.step)));
+        const __m512i greenStep = _mm512_set1_epi32(static_cast<int32_t>(pixelsPerIteration * static_cast<uint32_t>(setup.green.step)));
+        const __m512i blueStep = _mm512_set1_epi32(static_cast<int32_t>(pixelsPerIteration * static_cast<uint32_t>(setup.blue.step)));
+
+        ImageWidth x = 0;
+        for (; x + pixelsPerIteration <= count; x += pixelsPerIteration) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), avx512Pixels(redLow, greenLow, blueLow, max5, max6));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x + 16), avx512Pixels(redHigh, greenHigh, blueHigh, max5, max6));
+
+            redLow = _mm512_add_epi32(redLow, redStep);       redHigh = _mm512_add_epi32(redHigh, redStep);
+            greenLow = _mm512_add_epi32(greenLow, greenStep); greenHigh = _mm512_add_epi32(greenHigh, greenStep);
+            blueLow = _mm512_add_epi32(blueLow, blueStep);    blueHigh = _mm512_add_epi32(blueHigh, blueStep);
+        }
+        kernel::renderRowScalar(kernel::advance(setup, x), out + x, count - x);
+    }
+#endif
+}
+
+/**
+ * @brief Picks the widest instruction set supported by the CPU this process runs on.
+ *
+ * @return The detected path, SCALAR on non-x86 targets or compilers without intrinsics.
+ */
+kernel::SimdPath kernel::detectSimdPath() {
+#ifdef GRADIENT_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SimdPath::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdPath::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SimdPath::SSE2;
+    }
+#endif
+    return SimdPath::SCALAR;
+}
+
+/**
+ * @brief Returns the path chosen for this process; detection runs once on first use.
+ *
+ * GRADIENT_SIMD names a path to use instead of the detected one. Paths the CPU does not
+ * support, and names that are not paths, leave the detected path in place.
+ */
+kernel::SimdPath kernel::activeSimdPath() {
+    static const SimdPath path = [] {
+        const char* forced = std::getenv("GRADIENT_SIMD");
+        if (forced != nullptr) {
+            try {
+                const SimdPath requested = parseSimdPath(forced);
+                if (isSupported(requested)) {
+                    return requested;
+                }
+            } catch (const std::invalid_argument&) {
+            }
+        }
+        return detectSimdPath();
+    }();
+    return path;
+}
+
+/**
+ * @brief Tells whether the running CPU can execute a path; each path includes the narrower ones.
+ */
+bool kernel::isSupported(const SimdPath path) {
+    return static_cast<int>(path) <= static_cast<int>(detectSimdPath());
+}
+
+/**
+ * @brief Parses a path name as printed by toString().
+ *
+ * @throws std::invalid_argument If the name is not a path.
+ */
+kernel::SimdPath kernel::parseSimdPath(const std::string& name) {
+    for (const SimdPath path : {SimdPath::SCALAR, SimdPath::SSE2, SimdPath::AVX2, SimdPath::AVX512}) {
+        if (name == toString(path)) {
+            return path;
+        }
+    }
+    throw std::invalid_argument("Unknown SIMD path: " + name);
+}
+
+/**
+ * @brief Returns the row renderer implementing the given path.
+ *
+ * @param path Instruction set to use; it must be supported by the running CPU.
+ * @return Pointer to the renderer, the scalar one for paths that were not compiled in.
+ */
+kernel::RowRenderer kernel::rowRenderer(const SimdPath path) {
+    switch (path) {
+#ifdef GRADIENT_X86_SIMD
+    case SimdPath::SSE2:
+        return renderRowSse2;
+    case SimdPath::AVX2:
+        return renderRowAvx2;
+    case SimdPath::AVX512:
+        return renderRowAvx512;
+#endif
+    default:
+        return renderRowScalar;
+    }
+}
+
+/** @brief Returns the name of a path, as shown in the verbose output. */
+const char* kernel::toString(const SimdPath path) {
+    switch (path) {
+    case SimdPath::SSE2:
+        return "sse2";
+    case SimdPath::AVX2:
+        return "avx2";
+    case SimdPath::AVX512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+/**
+ * @brief Renders a row with the renderer selected for this process.
+ *
+ * @param setup Start values and steps of the row.
+ * @param out Destination for count packed pixels.
+ * @param count Number of pixels to produce.
+ */
+void kernel::renderRowSimd(const RowSetup& setup, Pixel* out, const ImageWidth count) {
+    static const RowRenderer renderer = rowRenderer(activeSimdPath());
+    renderer(setup, out, count);
+}
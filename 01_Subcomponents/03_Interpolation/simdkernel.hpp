@@ -0,0 +1,55 @@
+/**
+ * @file simdkernel.hpp
+ * @brief Declares the vectorized row renderers of the bilinear kernel and their runtime dispatch.
+ *
+ * Every path evaluates start + x * step with the same 32-bit integer arithmetic as
+ * kernel::renderRowScalar, so all of them produce bit-identical rows (checked by
+ * 03_Tests/simdkernel_test.cpp). The environment variable GRADIENT_SIMD=scalar|sse2|avx2|avx512
+ * forces a narrower path than the CPU supports, e.g. to compare the output of two paths.
+ */
+
+#pragma once
+
+#include <string>
+#include "bilinearkernel.hpp"
+
+/**
+ * @def GRADIENT_VECTOR_CLONES
+ * @brief Compiles a plain C++ loop once more for AVX2, picked at load time on CPUs supporting it.
+ *
+ * Used by the kernels that rely on the compiler's vectorizer instead of intrinsics. AVX2 does
+ * not include FMA, so both clones round every operation the same way and produce identical rows.
+ */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define GRADIENT_VECTOR_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define GRADIENT_VECTOR_CLONES
+#endif
+
+namespace kernel {
+    /**
+     * @enum SimdPath
+     * @brief Instruction set used to render gradient rows.
+     */
+    enum class SimdPath {
+        SCALAR,     /* Portable C++, one pixel per iteration */
+        SSE2,       /* 8 pixels per iteration */
+        AVX2,       /* 16 pixels per iteration */
+        AVX512      /* 32 pixels per iteration */
+    };
+
+    /**
+     * @typedef RowRenderer
+     * @brief Function producing count packed pixels of a row from its setup.
+     */
+    using RowRenderer = void (*)(const RowSetup& setup, Pixel* out, ImageWidth count);
+
+    [[nodiscard]] SimdPath detectSimdPath();
+    [[nodiscard]] SimdPath activeSimdPath();
+    [[nodiscard]] bool isSupported(SimdPath path);
+    [[nodiscard]] SimdPath parseSimdPath(const std::string& name);
+    [[nodiscard]] RowRenderer rowRenderer(SimdPath path);
+    [[nodiscard]] const char* toString(SimdPath path);
+
+    void renderRowSimd(const RowSetup& setup, Pixel* out, ImageWidth count);
+}
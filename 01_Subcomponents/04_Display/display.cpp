@@ -1,21 +1,68 @@
 #include <iostream>
 #include "display.hpp"
 
+namespace {
+    bool verboseEnabled = false;
+}
 
 void display::help() {
     std::cout <<"The program should be invoked by the following command line:\n" <<
-                "program.exe <image_width> <image_height> <tl> <tr> <bl> <br> <output_path>\n" <<
+                "program.exe <image_width> <image_height> <tl> <tr> <bl> <br> <output_path> [options]\n" <<
                 "where:\n" <<
                 "<tl> is the top left pixel color value\n" <<
                 "<tr> is the top right pixel color value\n" <<
                 "<bl> is the bottom left pixel color value\n" <<
                 "<br> is the bottom right pixel color value\n" <<
                 "Values can be provided both as hex or decimal;\n" <<
+                "Options:\n" <<
+                "--verbose    print diagnostic information, e.g. the selected SIMD path\n" <<
+                "--threads N  number of threads generating the image (default: all cores)\n" <<
+                "--stream     generate and write the image block by block with constant memory\n" <<
+                "--mmap       encode rows in parallel straight into the memory-mapped output file\n" <<
+                "--verify     check the existing <output_path> against the arguments instead of writing it\n" <<
+                "--io B       output backend: write (default), direct (O_DIRECT) or uring (io_uring)\n" <<
+                "--format F   output format: text (default), raw (little-endian RGB565), rle (compact, see program_decode)\n" <<
+                "             or tiled (indexed tiles readable one at a time, see program_decode --region)\n" <<
+                "--tile-size N  tile width and height of the tiled format (default: 256)\n" <<
+                "--gradient G gradient type: bilinear (default), linear, radial or conic\n" <<
+                "--stops C,C,...  evenly spaced color stops of linear, radial and conic (default: tl,tr,bl,br)\n" <<
+                "--angle D    direction of linear, start angle of conic, counterclockwise degrees (default: 0)\n" <<
+                "--region X,Y,W,H  render only the W x H rectangle at column X, row Y (from the top-left) of the image\n" <<
+                "--frames N   render N frames whose corners move from <tl> <tr> <bl> <br> to the --to colors\n" <<
+                "--to C,C,C,C corner colors tl,tr,bl,br of the last frame (default: no motion)\n" <<
+                "             frames go to numbered files if <output_path> contains %d or %0Nd, else are concatenated\n" <<
+                "--stats      print time per stage, pixels, bytes, peak memory and allocations\n" <<
+                "--stats-json F  write the same statistics as JSON to file F\n" <<
+                "--batch M    run every job listed in manifest M instead of a single image\n" <<
+                "--serve S    serve requests over the Unix socket S until a client sends quit\n" <<
+                "--serve-cache N  keep up to N MiB of encoded images in server memory (default: 256)\n" <<
+                "--cache D    serve repeated requests from the result cache in directory D\n" <<
+                "--cache-size N  evict least recently used cache entries above N MiB (default: 1024)\n" <<
+                "--cache-link    serve cache hits as read-only hardlinks when a reflink is not possible\n" <<
+                "--max-memory N  write the image or frames within N MiB, streaming them in smaller blocks if needed\n" <<
+                "Use - as <output_path> to write to the standard output.\n" <<
                 "Example of program calls:\n" <<
                 "program.exe 16 16 0x0 0xf 0x0 0xf ./file.txt\n" <<
-                "program.exe 32 32 3000 6000 9000 12000 ./file.txt\n";
+                "program.exe 32 32 3000 6000 9000 12000 ./file.txt\n" <<
+                "program.exe 256 256 0 0 0 0 ./file.txt --gradient radial --stops 0xffff,0xf800,0x0000\n" <<
+                "program.exe 64 32 0xf800 0x07e0 0x001f 0xffff ./frame_%03d.raw --frames 60 --to 0,0xffff,0x7bef,0x1234 --format raw\n" <<
+                "program.exe --batch ./jobs.txt --threads 8\n";
 }
 
 void display::error(const std::string& message) {
         std::cerr << message << std::endl;
+}
+
+void display::info(const std::string& message) {
+        std::cout << message << std::endl;
+}
+
+void display::setVerbose(const bool enabled) {
+        verboseEnabled = enabled;
+}
+
+void display::verbose(const std::string& message) {
+        if (verboseEnabled) {
+                std::cerr << message << std::endl;
+        }
 }
\ No newline at end of file
@@ -5,4 +5,7 @@
 namespace display {
     void help();
     void error(const std::string& message);
+    void info(const std::string& message);
+    void setVerbose(bool enabled);
+    void verbose(const std::string& message);
 }
\ No newline at end of file
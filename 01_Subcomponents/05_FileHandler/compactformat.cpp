@@ -0,0 +1,268 @@
+/**
+ * @file compactformat.cpp
+ * @brief Implements the compact run-length / row-delta output format.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "compactformat.hpp"
+
+namespace {
+    enum Tag : uint8_t {
+        REPEAT = 0,
+        RUNS = 1,
+        DELTA = 2,
+        LITERAL = 3
+    };
+
+    char* putU16(const uint16_t value, char* out) {
+        out[0] = static_cast<char>(value & 0xFF);
+        out[1] = static_cast<char>(value >> 8);
+        return out + 2;
+    }
+
+    char* putU64(const uint64_t value, char* out) {
+        for (int i = 0; i < 8; i++) {
+            out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+        }
+        return out + 8;
+    }
+
+    char* putVarint(uint64_t value, char* out) {
+        while (value >= 0x80) {
+            *out++ = static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        *out++ = static_cast<char>(value);
+        return out;
+    }
+
+    size_t varintBytes(uint64_t value) {
+        size_t bytes = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            bytes++;
+        }
+        return bytes;
+    }
+
+    /**
+     * @brief Calls visit(color, length) for every run of pixel(x), x in [0, width).
+     */
+    template <typename PixelAt, typename Visit>
+    void forEachRun(const ImageWidth width, PixelAt&& pixel, Visit&& visit) {
+        for (ImageWidth x = 0; x < width;) {
+            const Pixel color = pixel(x);
+            ImageWidth end = x + 1;
+            while (end < width && pixel(end) == color) {
+                end++;
+            }
+            visit(color, end - x);
+            x = end;
+        }
+    }
+
+    template <typename PixelAt>
+    size_t runBytes(const ImageWidth width, PixelAt&& pixel) {
+        size_t bytes = 0;
+        forEachRun(width, pixel, [&bytes](Pixel, const uint64_t length) { bytes += 2 + varintBytes(length); });
+        return bytes;
+    }
+
+    template <typename PixelAt>
+    char* putRuns(const ImageWidth width, PixelAt&& pixel, char* out) {
+        forEachRun(width, pixel, [&out](const Pixel color, const uint64_t length) {
+            out = putVarint(length, putU16(color, out));
+        });
+        return out;
+    }
+}
+
+/**
+ * @brief Describes the image of a single run.
+ */
+compact::Header compact::headerFor(const gradient::Parameters& parameters) {
+    const Region region = parameters.output();
+    return Header{region.width, region.height, parameters.tl, parameters.tr, parameters.bl, parameters.br};
+}
+
+/**
+ * @brief Stores the header.
+ *
+ * @param header Image description.
+ * @param out Destination of headerBytes bytes.
+ * @return Pointer past the header.
+ */
+char* compact::writeHeader(const Header& header, char* out) {
+    std::memcpy(out, magic, sizeof(magic));
+    out = putU16(version, out + sizeof(magic));
+    out = putU16(0, out);
+    out = putU64(header.width, out);
+    out = putU64(header.height, out);
+    for (const Pixel corner : {header.tl, header.tr, header.bl, header.br}) {
+        out = putU16(corner, out);
+    }
+    return out;
+}
+
+/**
+ * @brief Encodes a row with the smallest of the four tags.
+ *
+ * @param row Pixels of the row.
+ * @param previous Pixels of the row written before it, or null for the first row, which
+ * disables REPEAT and DELTA.
+ * @param width Number of pixels in the row.
+ * @param out Destination with room for maxRowBytes(width) bytes.
+ * @return Pointer past the last byte written.
+ */
+char* compact::encodeRow(const Pixel* row, const Pixel* previous, const ImageWidth width, char* out) {
+    if (previous != nullptr && std::memcmp(row, previous, width * sizeof(Pixel)) == 0) {
+        *out++ = static_cast<char>(REPEAT);
+        return out;
+    }
+
+    auto direct = [row](const ImageWidth x) { return row[x]; };
+    auto delta = [row, previous](const ImageWidth x) { return static_cast<Pixel>(row[x] ^ previous[x]); };
+    const size_t literalBytes = width * sizeof(Pixel);
+    const size_t directBytes = runBytes(width, direct);
+    const size_t deltaBytes = previous != nullptr ? runBytes(width, delta) : SIZE_MAX;
+
+    if (literalBytes <= std::min(directBytes, deltaBytes)) {
+        *out++ = static_cast<char>(LITERAL);
+        for (ImageWidth x = 0; x < width; x++) {
+            out = putU16(row[x], out);
+        }
+        return out;
+    }
+    if (deltaBytes < directBytes) {
+        *out++ = static_cast<char>(DELTA);
+        return putRuns(width, delta, out);
+    }
+    *out++ = static_cast<char>(RUNS);
+    return putRuns(width, direct, out);
+}
+
+/**
+ * @brief Reads and validates the header.
+ *
+ * @param input Stream positioned at the start of a compact file.
+ * @throws std::runtime_error If the stream is not a compact file of a supported version.
+ */
+compact::Decoder::Decoder(std::istream& input) : input(input), chunk(chunkBytes) {
+    char start[sizeof(magic)];
+    for (char& c : start) {
+        c = static_cast<char>(byte());
+    }
+    if (std::memcmp(start, magic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a compact gradient file");
+    }
+    const uint16_t fileVersion = color();
+    if (fileVersion != version) {
+        throw std::runtime_error("Unsupported compact format version " + std::to_string(fileVersion));
+    }
+    static_cast<void>(color());   /* Reserved */
+
+    uint64_t fields[2] = {};
+    for (uint64_t& field : fields) {
+        for (int i = 0; i < 8; i++) {
+            field |= static_cast<uint64_t>(byte()) << (8 * i);
+        }
+    }
+    imageHeader.width = fields[0];
+    imageHeader.height = fields[1];
+    if (imageHeader.width > maxImageDimension || imageHeader.height > maxImageDimension) {
+        throw std::runtime_error("Compact file dimensions are out of range");
+    }
+    imageHeader.tl = color();
+    imageHeader.tr = color();
+    imageHeader.bl = color();
+    imageHeader.br = color();
+    previous.resize(imageHeader.width);
+}
+
+/**
+ * @brief Decodes the next row, top row first.
+ *
+ * @param out Destination for header().width pixels.
+ * @return False once all rows have been read.
+ * @throws std::runtime_error If the stream is truncated or malformed.
+ */
+bool compact::Decoder::readRow(Pixel* out) {
+    if (rowsRead == imageHeader.height) {
+        return false;
+    }
+    const ImageWidth width = imageHeader.width;
+    const uint8_t tag = byte();
+    if (tag == REPEAT && rowsRead > 0) {
+        std::copy(previous.begin(), previous.end(), out);
+    } else if (tag == RUNS) {
+        readRuns(out);
+    } else if (tag == DELTA && rowsRead > 0) {
+        readRuns(out);
+        for (ImageWidth x = 0; x < width; x++) {
+            out[x] ^= previous[x];
+        }
+    } else if (tag == LITERAL) {
+        for (ImageWidth x = 0; x < width; x++) {
+            out[x] = color();
+        }
+    } else {
+        throw std::runtime_error("Malformed compact row " + std::to_string(rowsRead));
+    }
+    std::copy(out, out + width, previous.begin());
+    rowsRead++;
+    return true;
+}
+
+/**
+ * @brief Decodes (color, length) pairs until the row is covered.
+ */
+void compact::Decoder::readRuns(Pixel* out) {
+    const ImageWidth width = imageHeader.width;
+    for (ImageWidth x = 0; x < width;) {
+        const Pixel value = color();
+        const uint64_t length = varint();
+        if (length == 0 || length > width - x) {
+            throw std::runtime_error("Malformed run in compact row " + std::to_string(rowsRead));
+        }
+        std::fill(out + x, out + x + length, value);
+        x += length;
+    }
+}
+
+/**
+ * @brief Tells whether the stream ends right after the rows read so far.
+ */
+bool compact::Decoder::atEnd() {
+    return position == available && input.peek() == std::char_traits<char>::eof();
+}
+
+uint8_t compact::Decoder::byte() {
+    if (position == available) {
+        input.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        available = static_cast<size_t>(input.gcount());
+        position = 0;
+        if (available == 0) {
+            throw std::runtime_error("Compact file is truncated");
+        }
+    }
+    return static_cast<uint8_t>(chunk[position++]);
+}
+
+uint16_t compact::Decoder::color() {
+    const uint16_t low = byte();
+    return static_cast<uint16_t>(low | byte() << 8);
+}
+
+uint64_t compact::Decoder::varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const uint8_t next = byte();
+        value |= static_cast<uint64_t>(next & 0x7F) << shift;
+        if ((next & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Malformed length in compact row " + std::to_string(rowsRead));
+}
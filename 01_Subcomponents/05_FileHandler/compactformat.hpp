@@ -0,0 +1,82 @@
+/**
+ * @file compactformat.hpp
+ * @brief Declares the compact run-length / row-delta output format and its streaming decoder.
+ *
+ * Layout, all integers little-endian:
+ *
+ *     header   "G565" | u16 version | u16 reserved (0) | u64 width | u64 height | u16 tl, tr, bl, br
+ *     rows     height rows, top row first, each a tag byte followed by its payload:
+ *              0 REPEAT   none, the row equals the previous row
+ *              1 RUNS     (u16 color, varint length) pairs covering the row
+ *              2 DELTA    the same pairs over the XOR of the row with the previous row
+ *              3 LITERAL  width u16 colors
+ *
+ * Lengths are unsigned LEB128 varints. The encoder picks the smallest tag for every row, so
+ * a row never takes more than 1 + 2 * width bytes. RGB565 gradients change a channel level
+ * only every few pixels, so most rows are a handful of runs, and rows matching the one
+ * above cost a single byte.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <vector>
+#include "parameters.hpp"
+#include "types.hpp"
+
+namespace compact {
+    static constexpr char magic[4] = {'G', '5', '6', '5'};
+    static constexpr uint16_t version = 1;
+    static constexpr size_t headerBytes = 32;
+
+    /**
+     * @struct Header
+     * @brief Image described by a compact file.
+     */
+    struct Header {
+        ImageWidth width = 0;
+        ImageHeight height = 0;
+        Pixel tl = 0;
+        Pixel tr = 0;
+        Pixel bl = 0;
+        Pixel br = 0;
+    };
+
+    [[nodiscard]] Header headerFor(const gradient::Parameters& parameters);
+    char* writeHeader(const Header& header, char* out);
+
+    [[nodiscard]] constexpr size_t maxRowBytes(const ImageWidth width) {
+        return 1 + static_cast<size_t>(width) * sizeof(Pixel);
+    }
+    char* encodeRow(const Pixel* row, const Pixel* previous, ImageWidth width, char* out);
+
+    /**
+     * @class Decoder
+     * @brief Reads a compact stream one row at a time with constant memory.
+     */
+    class Decoder {
+    public:
+        explicit Decoder(std::istream& input);
+
+        [[nodiscard]] const Header& header() const { return imageHeader; }
+        [[nodiscard]] bool readRow(Pixel* out);
+        [[nodiscard]] bool atEnd();
+    private:
+        [[nodiscard]] uint8_t byte();
+        [[nodiscard]] uint16_t color();
+        [[nodiscard]] uint64_t varint();
+        void readRuns(Pixel* out);
+
+        static constexpr size_t chunkBytes = 64 * 1024;   /* Bytes read from the stream at once */
+
+        std::istream& input;
+        Header imageHeader;
+        std::vector<char> chunk;
+        size_t position = 0;      /* Next unread byte of chunk */
+        size_t available = 0;     /* Valid bytes of chunk */
+        std::vector<Pixel> previous;
+        ImageHeight rowsRead = 0;
+    };
+}
@@ -3,57 +3,221 @@
  * @brief Implements the FileHandler class for managing file output operations.
  */
 
-#include <iomanip>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 #include "filehandler.hpp"
-#include "rgb565.hpp"
+#include "replicate.hpp"
+#include "rowformat.hpp"
+#include "stats.hpp"
 
 /**
  * @brief Constructs a FileHandler and opens the specified file.
  *
- * Opens the file at the provided path for writing. Throws an exception if the file cannot be opened.
+ * @param filepath Path to the file to open.
+ * @param format Encoding of the rows.
+ * @param header Image written at the start of a compact file; unused by the other formats.
+ * @param io Output backend (--io).
+ * @param bufferBytes Size of each output buffer, see output::Backend::setBufferBytes().
+ * @throws std::ios_base::failure If the file cannot be opened.
+ */
+FileHandler::FileHandler(const std::string& filepath, const OutputFormat format, const compact::Header& header,
+                         const IoBackend io, const size_t bufferBytes) {
+    open(filepath, format, header, io, bufferBytes);
+}
+
+/**
+ * @brief Drops a file that was not finished, like abandon().
+ */
+FileHandler::~FileHandler() {
+    abandon();
+}
+
+/**
+ * @brief Opens a file for writing, reusing the backend and its buffers of a previous file.
+ *
+ * Opens the file at the provided path for writing. The path "-" selects the standard output.
+ * A file that is still open is finished first. Throws an exception if the file cannot be
+ * opened. Compact files start with the header describing the image.
  *
  * @param filepath Path to the file to open.
+ * @param format Encoding of the rows.
+ * @param header Image written at the start of a compact file; unused by the other formats.
+ * @param io Output backend; paths it cannot serve use IoBackend::WRITE (output::Backend::select()).
+ * @param bufferBytes Size of each output buffer, see output::Backend::setBufferBytes().
+ * @throws std::invalid_argument For the tiled format, see tiled::Writer.
  * @throws std::ios_base::failure If the file cannot be opened.
  */
-FileHandler::FileHandler(const std::string& filepath) {
-    file.open(filepath);
-    if (!file.is_open()) {
-        throw std::ios_base::failure("Could not open file with following path: " + filepath);
+void FileHandler::open(const std::string& filepath, const OutputFormat format, const compact::Header& header,
+                       const IoBackend io, const size_t bufferBytes) {
+    finish();
+    if (format == OutputFormat::TILED) {
+        throw std::invalid_argument("The tiled format is not written row by row");
+    }
+    this->format = format;
+    buffered = 0;
+    hasPreviousRow = false;
+    const IoBackend kind = output::Backend::select(io, filepath);
+    if (!backend || backend->kind() != kind) {
+        backend.reset();
+        backend = output::Backend::create(kind);
+    }
+    backend->setBufferBytes(bufferBytes);
+    backend->open(filepath);
+    opened = true;
+    buffer = backend->acquire(compact::headerBytes);
+    if (format == OutputFormat::RLE) {
+        buffered = static_cast<size_t>(compact::writeHeader(header, buffer.data()) - buffer.data());
     }
 }
 
+/**
+ * @brief Drops the current file without reporting errors, e.g. after a failed write.
+ */
+void FileHandler::abandon() {
+    if (opened) {
+        backend->abandon();
+    }
+    opened = false;
+    buffer = {};
+    buffered = 0;
+}
+
 /**
  * @brief Writes a color gradient result to the file.
  *
- * Outputs the color gradient in a hex format, each color representing an RGB565 value.
+ * Outputs the color gradient in the selected format, each color representing an RGB565 value,
+ * and closes the file.
+ *
+ * @param result A framebuffer of packed RGB565 color values representing the gradient.
+ * @param shape Shape of the rows, see writeRows().
+ * @throws std::runtime_error If the file is not open.
+ */
+void FileHandler::writeResults(const ResultGradient& result, const RowShape shape) {
+    writeRows(result, result.height(), shape);
+    finish();
+}
+
+/**
+ * @brief Appends a block of rows to the file.
+ *
+ * Rows are stored bottom-up like in a full gradient, so they are written from
+ * rows - 1 down to 0. Used to stream an image one block at a time. Rows are encoded
+ * into a large buffer which is written out whenever it fills up. Compact rows may refer
+ * to the row written before them, also across blocks.
+ *
+ * A degenerate shape saves encoding the text and raw formats: identical rows are encoded
+ * once per buffer fill and copied, single colored rows are encoded from their one color.
+ * Compact rows already collapse both cases into runs and repeated rows.
  *
- * @param result A matrix of RGB565 color values representing the gradient.
- * @param height Height of the gradient matrix.
- * @param width Width of the gradient matrix.
+ * @param block Framebuffer holding the rows.
+ * @param rows Number of valid rows in the block.
+ * @param shape Shape of the image the rows belong to, GENERAL when unknown.
  * @throws std::runtime_error If the file is not open.
  */
-void FileHandler::writeResults(const ResultGradient& result, const ImageHeight height, const ImageWidth width) {
-    if (!file.is_open()) {
+void FileHandler::writeRows(const ResultGradient& block, const ImageHeight rows, const RowShape shape) {
+    if (!opened) {
         throw std::runtime_error("File is not open.");
     }
 
-    /* Write the gradient data to the file */
-    for (auto y = height - 1; y >= 0; y--) {
-        for (uint16_t x = 0; x < width; x++) {
-            const rgb565::RGB565& pixel = result[y][x];
+    const ImageWidth width = block.width();
+    const size_t rowBytes = rowformat::rowBytes(format, width);   /* An upper bound for compact rows */
+    if (rowBytes == 0) {
+        return;   /* Raw rows of an empty width */
+    }
 
-            /* Format each pixel as a hex value and write it */
-            file << "0x" << std::hex << std::setw(4) << std::setfill('0')
-                 << (pixel.red << rgb565::redShift | pixel.green << rgb565::greenShift | pixel.blue << rgb565::blueShift);
+    /* Write the gradient data to the file, top row first, one buffer fill at a time */
+    for (ImageHeight y = rows; y > 0;) {
+        if (buffer.size() - buffered < rowBytes) {
+            flush(rowBytes);
+        }
+        const ImageHeight fill = std::min<ImageHeight>(y, (buffer.size() - buffered) / rowBytes);
+        const stats::Scope timing(stats::Stage::ENCODE);
+        if (format != OutputFormat::RLE && rowsIdentical(shape) && fill > 1) {
+            const Pixel* pixels = block.row(y - 1);
+            char* out = buffer.data() + buffered;
+            encodeShapedRow(pixels, width, out, shape);
+            replicate::repeat(out, rowBytes, rowBytes * fill);
+            buffered += rowBytes * fill;
+            y -= fill;
+            continue;
+        }
+        for (ImageHeight row = 0; row < fill; row++) {
+            const Pixel* pixels = block.row(--y);
+            char* end = format == OutputFormat::RLE ? encodeCompactRow(pixels, width, buffer.data() + buffered)
+                                                    : encodeShapedRow(pixels, width, buffer.data() + buffered, shape);
+            buffered = static_cast<size_t>(end - buffer.data());
+        }
+    }
+}
 
-            /* If it's not the last pixel in the row, add a space */
-            if (x < width - 1) {
-                file << " ";
-            }
+/**
+ * @brief Appends bytes that are already encoded in the format of the file, e.g. a cached image.
+ *
+ * Not for compact files, whose rows depend on the previous row written.
+ *
+ * @param bytes Encoded rows.
+ * @throws std::runtime_error If the file is not open.
+ */
+void FileHandler::writeEncoded(const std::span<const char> bytes) {
+    if (!opened) {
+        throw std::runtime_error("File is not open.");
+    }
+    for (size_t done = 0; done < bytes.size();) {
+        if (buffered == buffer.size()) {
+            flush(1);
         }
-        /* New line after each row */
-        file << "\n";
+        const size_t count = std::min(bytes.size() - done, buffer.size() - buffered);
+        std::memcpy(buffer.data() + buffered, bytes.data() + done, count);
+        buffered += count;
+        done += count;
     }
+}
 
-    file.close();
+/**
+ * @brief Encodes a text or raw row, from its first pixel when every pixel of it is the same.
+ */
+char* FileHandler::encodeShapedRow(const Pixel* row, const ImageWidth width, char* out, const RowShape shape) const {
+    if (rowsConstant(shape) && width > 0) {
+        return rowformat::encodeConstantRow(format, row[0], width, out);
+    }
+    return rowformat::encodeRow(format, row, width, out);
+}
+
+/**
+ * @brief Encodes a compact row against the previously written row and remembers it.
+ */
+char* FileHandler::encodeCompactRow(const Pixel* row, const ImageWidth width, char* out) {
+    char* end = compact::encodeRow(row, hasPreviousRow ? previousRow.data() : nullptr, width, out);
+    previousRow.assign(row, row + width);
+    hasPreviousRow = true;
+    return end;
+}
+
+/**
+ * @brief Hands the encoded bytes collected so far to the backend and continues in a new buffer.
+ *
+ * @param minimum Bytes the new buffer has to hold.
+ */
+void FileHandler::flush(const size_t minimum) {
+    backend->submit(buffered);
+    buffered = 0;
+    buffer = {};
+    buffer = backend->acquire(minimum);
+}
+
+/**
+ * @brief Writes the remaining bytes, waits for the backend and closes the file.
+ *
+ * @throws std::ios_base::failure If writing to the file failed.
+ */
+void FileHandler::finish() {
+    if (!opened) {
+        return;
+    }
+    opened = false;
+    const size_t bytes = buffered;
+    buffer = {};
+    buffered = 0;
+    backend->finish(bytes);
 }
@@ -5,19 +5,47 @@
 
 #pragma once
 
+#include <memory>
+#include <span>
 #include <string>
-#include <fstream>
-#include <types.hpp>
+#include <vector>
+#include <compactformat.hpp>
+#include <framebuffer.hpp>
+#include <outputbackend.hpp>
 
 /**
  * @class FileHandler
  * @brief Responsible for managing file operations, including writing color gradient data to a file.
+ *
+ * Rows are encoded straight into the buffers of an output backend (outputbackend.hpp), which
+ * writes them while the following rows are being encoded.
  */
 class FileHandler {
 public:
-    explicit FileHandler(const std::string& filepath);
-    ~FileHandler() = default;
-    void writeResults(const ResultGradient& result, uint16_t height, uint16_t width);
+    FileHandler() = default;
+    explicit FileHandler(const std::string& filepath, OutputFormat format = OutputFormat::TEXT,
+                         const compact::Header& header = {}, IoBackend io = IoBackend::WRITE,
+                         size_t bufferBytes = output::Backend::defaultBufferBytes);
+    ~FileHandler();
+    void open(const std::string& filepath, OutputFormat format = OutputFormat::TEXT, const compact::Header& header = {},
+              IoBackend io = IoBackend::WRITE, size_t bufferBytes = output::Backend::defaultBufferBytes);
+    void abandon();
+    void writeResults(const ResultGradient& result, RowShape shape = RowShape::GENERAL);
+    void writeRows(const ResultGradient& block, ImageHeight rows, RowShape shape = RowShape::GENERAL);
+    void writeEncoded(std::span<const char> bytes);
+    void finish();
+
+    static constexpr const char* standardOutput = "-";  /* Output path selecting stdout */
 private:
-    std::ofstream file;
+    void flush(size_t minimum);
+    char* encodeShapedRow(const Pixel* row, ImageWidth width, char* out, RowShape shape) const;
+    char* encodeCompactRow(const Pixel* row, ImageWidth width, char* out);
+
+    OutputFormat format = OutputFormat::TEXT;
+    std::unique_ptr<output::Backend> backend;   /* Kept across open() calls while the backend stays the same */
+    bool opened = false;
+    std::span<char> buffer;     /* Backend buffer being filled */
+    size_t buffered = 0;        /* Bytes of buffer holding encoded data */
+    std::vector<Pixel> previousRow;     /* Last row written in the compact format, the base of its row deltas */
+    bool hasPreviousRow = false;
 };
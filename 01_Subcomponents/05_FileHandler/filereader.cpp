@@ -0,0 +1,210 @@
+/**
+ * @file filereader.cpp
+ * @brief Implements the FileReader class.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <iostream>
+#include <stdexcept>
+#include "filereader.hpp"
+#include "hexdecoder.hpp"
+#include "hexencoder.hpp"
+#include "rowformat.hpp"
+#include "stats.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GRADIENT_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    [[noreturn]] void fail(const std::string& what, const std::string& filepath, const int error) {
+        throw std::ios_base::failure(what + " " + filepath + ": " + std::strerror(error));
+    }
+
+    constexpr size_t rowsPerTask = 64;   /* Rows decoded by one parallel task of readText() */
+}
+
+/**
+ * @brief Opens a gradient file and maps it into memory.
+ *
+ * @param filepath Path to the file, "-" for the standard input.
+ * @throws std::ios_base::failure If the file cannot be opened or read.
+ */
+FileReader::FileReader(const std::string& filepath) {
+#ifdef GRADIENT_HAS_MMAP
+    if (filepath == standardInput) {
+        readStream(STDIN_FILENO, filepath);
+        return;
+    }
+    const int descriptor = open(filepath.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        fail("Could not open file with following path:", filepath, errno);
+    }
+    struct stat status{};
+    if (fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode)) {
+        readStream(descriptor, filepath);
+        close(descriptor);
+        return;
+    }
+    fileBytes = static_cast<size_t>(status.st_size);
+    if (fileBytes > 0) {
+        mapping = mmap(nullptr, fileBytes, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapping == MAP_FAILED) {
+            const int error = errno;
+            mapping = nullptr;
+            close(descriptor);
+            fail("Could not map", filepath, error);
+        }
+        bytes = static_cast<const char*>(mapping);
+    }
+    close(descriptor);
+#else
+    std::ifstream file;
+    std::istream* stream = &std::cin;
+    if (filepath != standardInput) {
+        file.open(filepath, std::ios::in | std::ios::binary);
+        if (!file.is_open()) {
+            throw std::ios_base::failure("Could not open file with following path: " + filepath);
+        }
+        stream = &file;
+    }
+    contents.assign(std::istreambuf_iterator<char>(*stream), std::istreambuf_iterator<char>());
+    bytes = contents.data();
+    fileBytes = contents.size();
+#endif
+}
+
+/**
+ * @brief Unmaps the file.
+ */
+FileReader::~FileReader() {
+#ifdef GRADIENT_HAS_MMAP
+    if (mapping != nullptr) {
+        munmap(mapping, fileBytes);
+    }
+#endif
+}
+
+/**
+ * @brief Reads a descriptor that cannot be mapped (pipe, terminal) to its end.
+ */
+void FileReader::readStream(const int descriptor, const std::string& filepath) {
+#ifdef GRADIENT_HAS_MMAP
+    constexpr size_t chunkBytes = 1024 * 1024;
+    for (;;) {
+        contents.resize(fileBytes + chunkBytes);
+        const ssize_t received = read(descriptor, contents.data() + fileBytes, chunkBytes);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0) {
+            fail("Could not read", filepath, errno);
+        }
+        if (received == 0) {
+            break;
+        }
+        fileBytes += static_cast<size_t>(received);
+    }
+    contents.resize(fileBytes);
+    bytes = contents.data();
+#else
+    (void)descriptor;
+    (void)filepath;
+#endif
+}
+
+/**
+ * @brief Width of the image in a text file, taken from the length of its first line.
+ *
+ * @throws std::runtime_error If the first line is not a whole number of pixels.
+ */
+ImageWidth FileReader::textWidth() const {
+    const void* newline = fileBytes > 0 ? std::memchr(bytes, '\n', fileBytes) : nullptr;
+    if (newline == nullptr) {
+        throw std::runtime_error("Not a gradient text file: no complete line");
+    }
+    const size_t lineBytes = static_cast<size_t>(static_cast<const char*>(newline) - bytes) + 1;
+    if (lineBytes != 1 && lineBytes % hexencoder::bytesPerPixel != 0) {
+        throw std::runtime_error("Not a gradient text file: first line of " + std::to_string(lineBytes) + " bytes");
+    }
+    return lineBytes == 1 ? 0 : lineBytes / hexencoder::bytesPerPixel;
+}
+
+/**
+ * @brief Decodes one row of a text or raw file.
+ *
+ * @param format TEXT or RAW.
+ * @param width Image width.
+ * @param line Row index in the file, 0 being the top row.
+ * @param out Destination for width pixels.
+ * @return Index of the first malformed pixel, width if the row is valid (see hexdecoder::decodeRow()).
+ *         Raw rows are always valid.
+ */
+ImageWidth FileReader::decodeRow(const OutputFormat format, const ImageWidth width, const ImageHeight line, Pixel* out) const {
+    const char* row = bytes + line * rowformat::rowBytes(format, width);
+    if (format == OutputFormat::TEXT) {
+        return hexdecoder::decodeRow(row, width, out);
+    }
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(out, row, static_cast<size_t>(width) * sizeof(Pixel));
+    } else {
+        for (ImageWidth x = 0; x < width; x++) {
+            out[x] = static_cast<Pixel>(static_cast<uint8_t>(row[2 * x]) | static_cast<uint8_t>(row[2 * x + 1]) << 8);
+        }
+    }
+    return width;
+}
+
+/**
+ * @brief Parses a whole text file into a framebuffer, rows spread over the thread pool.
+ *
+ * The dimensions come from the file itself: the first line gives the width, the file size
+ * the height. Rows are stored bottom-up like a generated gradient.
+ *
+ * @param pool Thread pool decoding the rows.
+ * @return The image held by the file.
+ * @throws std::runtime_error If the file is not a well-formed gradient text file.
+ */
+ResultGradient FileReader::readText(ThreadPool& pool) const {
+    const ImageWidth width = textWidth();
+    const size_t rowBytes = hexencoder::rowBytes(width);
+    if (fileBytes % rowBytes != 0) {
+        throw std::runtime_error("Not a gradient text file: " + std::to_string(fileBytes)
+                                 + " bytes are not a whole number of " + std::to_string(rowBytes) + "-byte rows");
+    }
+    const ImageHeight height = fileBytes / rowBytes;
+    const stats::Scope timing(stats::Stage::DECODE);
+    ResultGradient image(width, height);
+
+    /* Lowest pixel index found malformed, in file order */
+    std::atomic<uint64_t> firstError{UINT64_MAX};
+    pool.parallelFor(height, rowsPerTask, [&](const size_t begin, const size_t end) {
+        for (size_t line = begin; line < end; line++) {
+            const ImageWidth column = decodeRow(OutputFormat::TEXT, width, line, image.row(height - 1 - line));
+            if (column != width) {
+                uint64_t position = line * (width + 1) + column;
+                uint64_t current = firstError.load();
+                while (position < current && !firstError.compare_exchange_weak(current, position)) {}
+                return;
+            }
+        }
+    });
+    stats::addPixels(width * height);
+
+    if (const uint64_t position = firstError.load(); position != UINT64_MAX) {
+        throw std::runtime_error("Malformed pixel at row " + std::to_string(position / (width + 1))
+                                 + ", column " + std::to_string(position % (width + 1)));
+    }
+    return image;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file filereader.hpp
+ * @brief Defines the FileReader class, which maps a gradient file and parses it back into pixels.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "framebuffer.hpp"
+#include "threadpool.hpp"
+#include "types.hpp"
+
+/**
+ * @class FileReader
+ * @brief Read-only counterpart of FileHandler: maps a gradient file and decodes its rows.
+ *
+ * Regular files are memory-mapped; pipes, stdin ("-") and platforms without mmap are read
+ * into memory instead. Every row of the text and raw formats has the same size, so rows
+ * are located without scanning and decoded by any number of threads at once.
+ */
+class FileReader {
+public:
+    explicit FileReader(const std::string& filepath);
+    ~FileReader();
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
+
+    [[nodiscard]] const char* data() const { return bytes; }
+    [[nodiscard]] size_t size() const { return fileBytes; }
+    [[nodiscard]] ImageWidth textWidth() const;
+    [[nodiscard]] ImageWidth decodeRow(OutputFormat format, ImageWidth width, ImageHeight line, Pixel* out) const;
+    [[nodiscard]] ResultGradient readText(ThreadPool& pool) const;
+
+    static constexpr const char* standardInput = "-";  /* Input path selecting stdin */
+private:
+    void readStream(int descriptor, const std::string& filepath);
+
+    const char* bytes = nullptr;
+    size_t fileBytes = 0;
+    void* mapping = nullptr;         /* Null unless bytes point into a memory mapping */
+    std::vector<char> contents;      /* Holds the file when it could not be mapped */
+};
@@ -0,0 +1,156 @@
+/**
+ * @file hexdecoder.cpp
+ * @brief Implements the hex row decoder, with an AVX2 path picked from CPUID at startup.
+ */
+
+#include <array>
+#include <cstdint>
+#include "hexdecoder.hpp"
+#include "hexencoder.hpp"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define GRADIENT_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    /**
+     * @brief Value of every byte as a lowercase hex digit, -1 for bytes that are not one.
+     */
+    constexpr std::array<int8_t, 256> digitValues = [] {
+        std::array<int8_t, 256> table{};
+        table.fill(-1);
+        for (int digit = 0; digit < 10; digit++) {
+            table['0' + digit] = static_cast<int8_t>(digit);
+        }
+        for (int digit = 0; digit < 6; digit++) {
+            table['a' + digit] = static_cast<int8_t>(10 + digit);
+        }
+        return table;
+    }();
+
+    /**
+     * @brief Parses one pixel and its separator.
+     *
+     * @return False if the 7 bytes are not "0x", four hex digits and separator.
+     */
+    inline bool decodePixel(const char* in, const char separator, Pixel& out) {
+        const auto digit = [in](const int index) {
+            return static_cast<int32_t>(digitValues[static_cast<uint8_t>(in[index])]);
+        };
+        const int32_t d0 = digit(2), d1 = digit(3), d2 = digit(4), d3 = digit(5);
+        out = static_cast<Pixel>((d0 << 12) | (d1 << 8) | (d2 << 4) | d3);
+        return in[0] == '0' && in[1] == 'x' && in[6] == separator && (d0 | d1 | d2 | d3) >= 0;
+    }
+
+    /* An empty row is a lone newline */
+    ImageWidth decodeEmptyRow(const char* in) {
+        return in[0] == '\n' ? 0 : 1;
+    }
+
+    ImageWidth decodePixels(const char* in, const ImageWidth first, const ImageWidth width, Pixel* out) {
+        for (ImageWidth x = first; x < width; x++) {
+            if (!decodePixel(in + x * hexencoder::bytesPerPixel, x + 1 == width ? '\n' : ' ', out[x])) {
+                return x;
+            }
+        }
+        return width;
+    }
+
+#ifdef GRADIENT_X86_SIMD
+    /**
+     * @brief Parses 4 pixels per 32-byte load.
+     *
+     * The 28 bytes of 4 pixels put the digits of two pixels in each 128-bit lane, so one
+     * in-lane shuffle gathers them. Every byte is checked against the pixel template at once;
+     * a group failing the check is re-parsed by the scalar path to locate the bad pixel.
+     * Groups stop 5 pixels before the end of the row so the load never leaves the row.
+     */
+    __attribute__((target("avx2")))
+    ImageWidth decodeGroupsAvx2(const char* in, const ImageWidth width, Pixel* out) {
+        constexpr ImageWidth pixelsPerIteration = 4;
+        const __m256i order = _mm256_setr_epi8(2, 3, 4, 5, 9, 10, 11, 12, -1, -1, -1, -1, -1, -1, -1, -1,
+                                               0, 1, 2, 3, 7, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m256i pattern = _mm256_setr_epi8('0', 'x', 0, 0, 0, 0, ' ', '0', 'x', 0, 0, 0, 0, ' ',
+                                                 '0', 'x', 0, 0, 0, 0, ' ', '0', 'x', 0, 0, 0, 0, ' ', 0, 0, 0, 0);
+        const __m256i digitBytes = _mm256_setr_epi8(0, 0, -1, -1, -1, -1, 0, 0, 0, -1, -1, -1, -1, 0,
+                                                    0, 0, -1, -1, -1, -1, 0, 0, 0, -1, -1, -1, -1, 0, 0, 0, 0, 0);
+        const __m256i ignored = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, -1, -1, -1);
+        const __m256i below0 = _mm256_set1_epi8('0' - 1), above9 = _mm256_set1_epi8('9');
+        const __m256i belowA = _mm256_set1_epi8('a' - 1), aboveF = _mm256_set1_epi8('f');
+        const __m256i lowNibble = _mm256_set1_epi8(0x0F), letterOffset = _mm256_set1_epi8(9);
+        const __m256i nibbleWeights = _mm256_set1_epi16(0x0110);     /* Bytes 16, 1 */
+        const __m256i byteWeights = _mm256_set1_epi32(0x00010100);   /* Words 256, 1 */
+        const __m256i gather = _mm256_setr_epi32(0, 1, 4, 5, 0, 1, 4, 5);
+
+        ImageWidth x = 0;
+        for (; x + pixelsPerIteration + 1 <= width; x += pixelsPerIteration) {
+            const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + x * hexencoder::bytesPerPixel));
+            const __m256i isDigit = _mm256_andnot_si256(_mm256_cmpgt_epi8(bytes, above9), _mm256_cmpgt_epi8(bytes, below0));
+            const __m256i isLetter = _mm256_andnot_si256(_mm256_cmpgt_epi8(bytes, aboveF), _mm256_cmpgt_epi8(bytes, belowA));
+            const __m256i valid = _mm256_or_si256(
+                _mm256_or_si256(_mm256_and_si256(_mm256_or_si256(isDigit, isLetter), digitBytes),
+                                _mm256_andnot_si256(digitBytes, _mm256_cmpeq_epi8(bytes, pattern))),
+                ignored);
+            if (_mm256_movemask_epi8(valid) != -1) {
+                break;
+            }
+
+            const __m256i nibbles = _mm256_add_epi8(_mm256_and_si256(bytes, lowNibble),
+                                                    _mm256_and_si256(_mm256_cmpgt_epi8(bytes, above9), letterOffset));
+            const __m256i pairs = _mm256_maddubs_epi16(_mm256_shuffle_epi8(nibbles, order), nibbleWeights);
+            const __m256i pixels = _mm256_permutevar8x32_epi32(_mm256_madd_epi16(pairs, byteWeights), gather);
+            const __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(pixels), _mm256_castsi256_si128(pixels));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), packed);
+        }
+        return decodePixels(in, x, width, out);
+    }
+#endif
+}
+
+/**
+ * @brief Decodes one row of the hex text format.
+ *
+ * @param in First byte of the row.
+ * @param width Number of pixels in the row.
+ * @param out Destination for width pixels; entries from the first malformed pixel on are unspecified.
+ * @return Index of the first malformed pixel, width if the whole row is valid. An empty row
+ *         that is not a lone newline returns 1.
+ */
+ImageWidth hexdecoder::decodeRow(const char* in, const ImageWidth width, Pixel* out) {
+    static const bool avx2 = isAvx2Supported();
+    return avx2 ? decodeRowAvx2(in, width, out) : decodeRowScalar(in, width, out);
+}
+
+/**
+ * @brief Decodes one row pixel by pixel; the reference for the other paths.
+ */
+ImageWidth hexdecoder::decodeRowScalar(const char* in, const ImageWidth width, Pixel* out) {
+    return width == 0 ? decodeEmptyRow(in) : decodePixels(in, 0, width, out);
+}
+
+/**
+ * @brief Decodes one row 4 pixels at a time; only call it if isAvx2Supported().
+ *
+ * Builds without the x86 path decode pixel by pixel.
+ */
+ImageWidth hexdecoder::decodeRowAvx2(const char* in, const ImageWidth width, Pixel* out) {
+#ifdef GRADIENT_X86_SIMD
+    return width == 0 ? decodeEmptyRow(in) : decodeGroupsAvx2(in, width, out);
+#else
+    return decodeRowScalar(in, width, out);
+#endif
+}
+
+/**
+ * @brief Tells whether the running CPU can execute decodeRowAvx2().
+ */
+bool hexdecoder::isAvx2Supported() {
+#ifdef GRADIENT_X86_SIMD
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
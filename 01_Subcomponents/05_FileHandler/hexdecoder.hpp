@@ -0,0 +1,22 @@
+/**
+ * @file hexdecoder.hpp
+ * @brief Declares the row decoder parsing the hex text format written by hexencoder.
+ *
+ * A row of width pixels takes exactly hexencoder::rowBytes(width) bytes: every pixel is "0x"
+ * followed by four lowercase hex digits and a space, the last one a newline, exactly as
+ * hexencoder writes it. Anything else, upper-case digits included, is a malformed pixel, so a
+ * valid row is the only encoding of its pixels.
+ */
+
+#pragma once
+
+#include "types.hpp"
+
+namespace hexdecoder {
+    [[nodiscard]] ImageWidth decodeRow(const char* in, ImageWidth width, Pixel* out);
+
+    /* The paths decodeRow() picks from, to compare them (see 03_Tests/hexdecoder_test.cpp) */
+    [[nodiscard]] ImageWidth decodeRowScalar(const char* in, ImageWidth width, Pixel* out);
+    [[nodiscard]] ImageWidth decodeRowAvx2(const char* in, ImageWidth width, Pixel* out);
+    [[nodiscard]] bool isAvx2Supported();
+}
@@ -0,0 +1,78 @@
+/**
+ * @file hexencoder.cpp
+ * @brief Implements the table driven hex row encoder.
+ */
+
+#include <array>
+#include <cstring>
+#include "hexencoder.hpp"
+#include "replicate.hpp"
+
+namespace {
+    /**
+     * @brief Two lowercase hex digits for every byte value (512 bytes, stays in L1).
+     */
+    constexpr std::array<char, 512> digitPairs = [] {
+        constexpr char digits[] = "0123456789abcdef";
+        std::array<char, 512> table{};
+        for (size_t value = 0; value < 256; value++) {
+            table[2 * value] = digits[value >> 4];
+            table[2 * value + 1] = digits[value & 0xF];
+        }
+        return table;
+    }();
+}
+
+/**
+ * @brief Encodes a row of packed pixels into the hex text format.
+ *
+ * @param row Pixels to encode.
+ * @param width Number of pixels in the row.
+ * @param out Destination with room for rowBytes(width) bytes.
+ * @return Pointer past the last byte written.
+ */
+char* hexencoder::encodeRow(const Pixel* row, const ImageWidth width, char* out) {
+    if (width == 0) {
+        *out = '\n';
+        return out + 1;
+    }
+
+    for (ImageWidth x = 0; x < width; x++) {
+        const Pixel pixel = row[x];
+        out[0] = '0';
+        out[1] = 'x';
+        std::memcpy(out + 2, &digitPairs[2 * (pixel >> 8)], 2);
+        std::memcpy(out + 4, &digitPairs[2 * (pixel & 0xFF)], 2);
+        out[6] = ' ';
+        out += bytesPerPixel;
+    }
+    out[-1] = '\n';
+
+    return out;
+}
+
+/**
+ * @brief Encodes a row of width copies of one pixel.
+ *
+ * The pixel is encoded once and the text doubled with memcpy, so the row is written at
+ * memory bandwidth. The result equals encodeRow() of the same row.
+ *
+ * @param pixel Color of every pixel.
+ * @param width Number of pixels in the row.
+ * @param out Destination with room for rowBytes(width) bytes.
+ * @return Pointer past the last byte written.
+ */
+char* hexencoder::encodeConstantRow(const Pixel pixel, const ImageWidth width, char* out) {
+    if (width == 0) {
+        *out = '\n';
+        return out + 1;
+    }
+
+    encodeRow(&pixel, 1, out);
+    out[bytesPerPixel - 1] = ' ';
+    const size_t bytes = rowBytes(width);
+    replicate::repeat(out, bytesPerPixel, bytes);
+    out[bytes - 1] = '\n';
+
+    return out + bytes;
+}
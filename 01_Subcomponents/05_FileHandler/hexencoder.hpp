@@ -0,0 +1,30 @@
+/**
+ * @file hexencoder.hpp
+ * @brief Declares the row encoder producing the hex text format of the gradient files.
+ *
+ * Every pixel is written as "0x" followed by four lowercase hex digits. Pixels of a row are
+ * separated by a space and the row ends with a newline, so each pixel takes exactly
+ * bytesPerPixel bytes.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include "types.hpp"
+
+namespace hexencoder {
+    /**
+     * @brief Bytes taken by one pixel including its separator ("0x" + 4 digits + ' ' or '\n').
+     */
+    static constexpr size_t bytesPerPixel = 7;
+
+    /**
+     * @brief Bytes taken by one encoded row of the given width (an empty row is a lone newline).
+     */
+    [[nodiscard]] constexpr size_t rowBytes(const ImageWidth width) {
+        return width == 0 ? 1 : static_cast<size_t>(width) * bytesPerPixel;
+    }
+
+    char* encodeRow(const Pixel* row, ImageWidth width, char* out);
+    char* encodeConstantRow(Pixel pixel, ImageWidth width, char* out);
+}
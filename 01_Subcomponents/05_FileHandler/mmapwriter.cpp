@@ -0,0 +1,154 @@
+/**
+ * @file mmapwriter.cpp
+ * @brief Implements the MmapWriter class.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <ios>
+#include "mmapwriter.hpp"
+#include "outputbackend.hpp"
+#include "rowformat.hpp"
+#include "stats.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GRADIENT_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    [[noreturn]] void fail(const std::string& what, const std::string& filepath, const int error) {
+        throw std::ios_base::failure(what + " " + filepath + ": " + std::strerror(error));
+    }
+}
+
+/**
+ * @brief Tells whether a path can be written through a memory mapping.
+ *
+ * Pipes, terminals, character devices and the "-" (stdout) path cannot be mapped;
+ * those targets have to use the buffered FileHandler.
+ *
+ * @param filepath Output path.
+ * @return True for regular files and paths that do not exist yet.
+ */
+bool MmapWriter::isSupported(const std::string& filepath) {
+#ifdef GRADIENT_HAS_MMAP
+    if (filepath == "-") {
+        return false;
+    }
+    struct stat status{};
+    if (stat(filepath.c_str(), &status) != 0) {
+        return errno == ENOENT;
+    }
+    return S_ISREG(status.st_mode);
+#else
+    (void)filepath;
+    return false;
+#endif
+}
+
+/**
+ * @brief Creates the output file, sizes it for the whole image and maps it.
+ *
+ * @param filepath Path to the output file.
+ * @param format Encoding of the rows.
+ * @param width Image width in pixels.
+ * @param height Image height in pixels.
+ * @throws std::ios_base::failure If the file cannot be created, sized or mapped.
+ */
+MmapWriter::MmapWriter(const std::string& filepath, const OutputFormat format, const ImageWidth width, const ImageHeight height)
+    : format(format), width(width), height(height),
+      fileBytes(rowformat::imageBytes(format, width, height)) {
+#ifdef GRADIENT_HAS_MMAP
+    output::detach(filepath);
+    descriptor = open(filepath.c_str(), O_RDWR | O_CREAT | O_TRUNC, output::fileMode);
+    if (descriptor < 0) {
+        fail("Could not open file with following path:", filepath, errno);
+    }
+    if (fileBytes == 0) {
+        return;
+    }
+    if (ftruncate(descriptor, static_cast<off_t>(fileBytes)) != 0) {
+        const int error = errno;
+        release();
+        fail("Could not resize", filepath, error);
+    }
+#if defined(__linux__)
+    /* Reserve the blocks now, so a full disk is an error here instead of a SIGBUS later */
+    const int reserved = posix_fallocate(descriptor, 0, static_cast<off_t>(fileBytes));
+    if (reserved != 0 && reserved != EINVAL && reserved != EOPNOTSUPP) {
+        release();
+        fail("Could not allocate", filepath, reserved);
+    }
+#endif
+    void* address = mmap(nullptr, fileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    if (address == MAP_FAILED) {
+        const int error = errno;
+        release();
+        fail("Could not map", filepath, error);
+    }
+    mapping = static_cast<char*>(address);
+#else
+    (void)filepath;
+    throw std::ios_base::failure("Memory-mapped output is not supported on this platform");
+#endif
+}
+
+/**
+ * @brief Unmaps and closes the file if finish() was not called.
+ */
+MmapWriter::~MmapWriter() {
+    release();
+}
+
+/**
+ * @brief Generates every row and encodes it straight into the mapping.
+ *
+ * @param interpolator Interpolation producing the rows.
+ * @param pool Thread pool filling the file.
+ */
+void MmapWriter::write(const Interpolation& interpolator, ThreadPool& pool) {
+    interpolator.encodeImage(pool, format, mapping);
+}
+
+/**
+ * @brief Unmaps and closes the file, reporting errors.
+ *
+ * @throws std::ios_base::failure If the file could not be closed.
+ */
+void MmapWriter::finish() {
+#ifdef GRADIENT_HAS_MMAP
+    const stats::Scope timing(stats::Stage::WRITE);
+    stats::addBytes(fileBytes);
+    if (mapping != nullptr) {
+        munmap(mapping, fileBytes);
+        mapping = nullptr;
+    }
+    if (descriptor >= 0) {
+        const int result = close(descriptor);
+        descriptor = -1;
+        if (result != 0) {
+            throw std::ios_base::failure(std::string("Could not write the output file: ") + std::strerror(errno));
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Releases the mapping and the descriptor without reporting errors.
+ */
+void MmapWriter::release() {
+#ifdef GRADIENT_HAS_MMAP
+    if (mapping != nullptr) {
+        munmap(mapping, fileBytes);
+        mapping = nullptr;
+    }
+    if (descriptor >= 0) {
+        close(descriptor);
+        descriptor = -1;
+    }
+#endif
+}
@@ -0,0 +1,42 @@
+/**
+ * @file mmapwriter.hpp
+ * @brief Defines the MmapWriter class, which writes an image by filling a memory-mapped output file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "interpolation.hpp"
+#include "threadpool.hpp"
+#include "types.hpp"
+
+/**
+ * @class MmapWriter
+ * @brief Sizes the output file up front, maps it and lets worker threads encode rows in place.
+ *
+ * Every row of the supported formats has the same encoded size, so the offset of each row
+ * is known before it is generated and rows can be written in any order, in parallel.
+ * Only available on POSIX systems and for regular files; see isSupported().
+ */
+class MmapWriter {
+public:
+    MmapWriter(const std::string& filepath, OutputFormat format, ImageWidth width, ImageHeight height);
+    ~MmapWriter();
+    MmapWriter(const MmapWriter&) = delete;
+    MmapWriter& operator=(const MmapWriter&) = delete;
+
+    void write(const Interpolation& interpolator, ThreadPool& pool);
+    void finish();
+
+    [[nodiscard]] static bool isSupported(const std::string& filepath);
+private:
+    void release();
+
+    OutputFormat format;
+    ImageWidth width;
+    ImageHeight height;
+    size_t fileBytes;
+    int descriptor = -1;
+    char* mapping = nullptr;
+};
@@ -0,0 +1,742 @@
+/**
+ * @file outputbackend.cpp
+ * @brief Implements the write, O_DIRECT and io_uring output backends.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <ios>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include "outputbackend.hpp"
+#include "display.hpp"
+#include "stats.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GRADIENT_HAS_POSIX_IO 1
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define GRADIENT_HAS_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace {
+    /**
+     * @brief Tells whether a path names a regular file or a file that does not exist yet.
+     */
+    bool isRegularTarget(const std::string& filepath) {
+#ifdef GRADIENT_HAS_POSIX_IO
+        struct stat status{};
+        if (stat(filepath.c_str(), &status) != 0) {
+            return errno == ENOENT;
+        }
+        return S_ISREG(status.st_mode);
+#else
+        (void)filepath;
+        return false;
+#endif
+    }
+
+    /**
+     * @class ThreadedBackend
+     * @brief Writes submitted buffers in order on a writer thread, used by the WRITE and DIRECT backends.
+     *
+     * The thread is started with the first write that does not come from finish(), so files
+     * that fit into a single buffer are written on the calling thread.
+     */
+    class ThreadedBackend final : public output::Backend {
+    public:
+        explicit ThreadedBackend(const IoBackend kind) : Backend(kind) {}
+
+        ~ThreadedBackend() override {
+            abandon();
+            {
+                const std::lock_guard lock(mutex);
+                stopping = true;
+            }
+            changed.notify_all();
+            if (writer.joinable()) {
+                writer.join();
+            }
+        }
+
+    protected:
+        void start(Buffer* buffer) override {
+            if (closing && !writer.joinable()) {
+                {
+                    const stats::Scope timing(stats::Stage::WRITE, stats::Scope::CPU);
+                    writeAll(*buffer);
+                }
+                release(buffer);
+                return;
+            }
+            if (!writer.joinable()) {
+                writer = std::thread(&ThreadedBackend::writerLoop, this);
+            }
+            {
+                const std::lock_guard lock(mutex);
+                pending.push_back(buffer);
+            }
+            changed.notify_all();
+        }
+
+        Buffer* take() override {
+            std::unique_lock lock(mutex);
+            changed.wait(lock, [this] { return !free.empty() || failure.load() != 0; });
+            if (failure.load() != 0) {
+                throwFailure();
+            }
+            Buffer* buffer = free.back();
+            free.pop_back();
+            return buffer;
+        }
+
+        void release(Buffer* buffer) override {
+            {
+                const std::lock_guard lock(mutex);
+                free.push_back(buffer);
+            }
+            changed.notify_all();
+        }
+
+        void drain() override {
+            std::unique_lock lock(mutex);
+            changed.wait(lock, [this] { return pending.empty() && writing == 0; });
+        }
+
+        void reset(const std::vector<Buffer*>& buffers) override {
+            const std::lock_guard lock(mutex);
+            free = buffers;
+        }
+
+    private:
+        /**
+         * @brief Writes pending buffers in submission order until the backend is destroyed.
+         *
+         * After a failed write the remaining buffers are only recycled, the error is reported
+         * by the next take() or by finish().
+         */
+        void writerLoop() {
+            std::unique_lock lock(mutex);
+            while (true) {
+                changed.wait(lock, [this] { return stopping || !pending.empty(); });
+                if (pending.empty()) {
+                    return;
+                }
+                Buffer* buffer = pending.front();
+                pending.pop_front();
+                writing++;
+                lock.unlock();
+                if (failure.load() == 0) {
+                    const stats::Scope timing(stats::Stage::WRITE, stats::Scope::CPU);
+                    writeAll(*buffer);
+                }
+                lock.lock();
+                writing--;
+                free.push_back(buffer);
+                changed.notify_all();
+            }
+        }
+
+        std::thread writer;
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<Buffer*> pending;    /* Submitted buffers, oldest first */
+        std::vector<Buffer*> free;
+        size_t writing = 0;             /* Buffers being written by the thread */
+        bool stopping = false;
+    };
+
+#ifdef GRADIENT_HAS_URING
+    int uringSetup(const unsigned entries, io_uring_params* parameters) {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, parameters));
+    }
+
+    int uringEnter(const int ring, const unsigned submit, const unsigned complete, const unsigned flags) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, ring, submit, complete, flags, nullptr, 0));
+    }
+
+    /**
+     * @class UringBackend
+     * @brief Queues every submitted buffer as a write on an io_uring, without a writer thread.
+     *
+     * Uses the raw system calls of <linux/io_uring.h>, so no liburing is needed. Completions
+     * are reaped when a free buffer is needed and when the file is finished. Writes carry
+     * their file offset, so several of them may be in flight at once.
+     */
+    class UringBackend final : public output::Backend {
+    public:
+        UringBackend() : Backend(IoBackend::URING) {
+            io_uring_params parameters{};
+            ring = uringSetup(bufferCount, &parameters);
+            if (ring < 0) {
+                throw std::runtime_error(std::string("Could not set up io_uring: ") + std::strerror(errno));
+            }
+            submissionBytes = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned);
+            completionBytes = parameters.cq_off.cqes + parameters.cq_entries * sizeof(io_uring_cqe);
+            if (parameters.features & IORING_FEAT_SINGLE_MMAP) {
+                submissionBytes = completionBytes = std::max(submissionBytes, completionBytes);
+            }
+            entriesBytes = parameters.sq_entries * sizeof(io_uring_sqe);
+            try {
+                submissionRing = map(submissionBytes, IORING_OFF_SQ_RING);
+                completionRing = (parameters.features & IORING_FEAT_SINGLE_MMAP)
+                    ? submissionRing : map(completionBytes, IORING_OFF_CQ_RING);
+                entries = static_cast<io_uring_sqe*>(map(entriesBytes, IORING_OFF_SQES));
+            } catch (const std::runtime_error&) {
+                unmap();
+                throw;
+            }
+
+            auto* submission = static_cast<char*>(submissionRing);
+            submissionTail = reinterpret_cast<unsigned*>(submission + parameters.sq_off.tail);
+            submissionMask = *reinterpret_cast<unsigned*>(submission + parameters.sq_off.ring_mask);
+            submissionArray = reinterpret_cast<unsigned*>(submission + parameters.sq_off.array);
+            auto* completion = static_cast<char*>(completionRing);
+            completionHead = reinterpret_cast<unsigned*>(completion + parameters.cq_off.head);
+            completionTail = reinterpret_cast<unsigned*>(completion + parameters.cq_off.tail);
+            completionMask = *reinterpret_cast<unsigned*>(completion + parameters.cq_off.ring_mask);
+            completions = reinterpret_cast<io_uring_cqe*>(completion + parameters.cq_off.cqes);
+        }
+
+        ~UringBackend() override {
+            abandon();
+            unmap();
+        }
+
+    protected:
+        void start(Buffer* buffer) override {
+            const unsigned tail = *submissionTail;
+            const unsigned index = tail & submissionMask;
+            io_uring_sqe& entry = entries[index];
+            std::memset(&entry, 0, sizeof(entry));
+            entry.opcode = IORING_OP_WRITE;
+            entry.fd = descriptor;
+            entry.addr = reinterpret_cast<uint64_t>(buffer->data.get());
+            entry.len = static_cast<uint32_t>(buffer->length);
+            entry.off = buffer->offset;
+            entry.user_data = reinterpret_cast<uint64_t>(buffer);
+            submissionArray[index] = index;
+            __atomic_store_n(submissionTail, tail + 1, __ATOMIC_RELEASE);
+            inFlight++;
+
+            while (uringEnter(ring, 1, 0, 0) < 0) {
+                if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                    throw std::ios_base::failure(std::string("Could not queue a write: ") + std::strerror(errno));
+                }
+                reap();
+            }
+        }
+
+        Buffer* take() override {
+            while (free.empty() && !broken) {
+                reap();
+            }
+            if (failure.load() != 0 || free.empty()) {
+                throwFailure();
+            }
+            Buffer* buffer = free.back();
+            free.pop_back();
+            return buffer;
+        }
+
+        void release(Buffer* buffer) override {
+            free.push_back(buffer);
+        }
+
+        void drain() override {
+            while (inFlight > 0 && !broken) {
+                reap();
+            }
+        }
+
+        void reset(const std::vector<Buffer*>& buffers) override {
+            free = buffers;
+        }
+
+    private:
+        void* map(const size_t bytes, const off_t offset) {
+            void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, offset);
+            if (memory == MAP_FAILED) {
+                throw std::runtime_error(std::string("Could not map the io_uring: ") + std::strerror(errno));
+            }
+            return memory;
+        }
+
+        void unmap() {
+            if (entries != nullptr) {
+                munmap(entries, entriesBytes);
+            }
+            if (completionRing != nullptr && completionRing != submissionRing) {
+                munmap(completionRing, completionBytes);
+            }
+            if (submissionRing != nullptr) {
+                munmap(submissionRing, submissionBytes);
+            }
+            ::close(ring);
+        }
+
+        /**
+         * @brief Collects finished writes, waiting for one if none has finished yet.
+         *
+         * A short write is completed synchronously; a failed one is recorded for take() and finish().
+         */
+        void reap() {
+            unsigned head = *completionHead;
+            if (head == __atomic_load_n(completionTail, __ATOMIC_ACQUIRE)) {
+                if (inFlight == 0) {
+                    return;
+                }
+                if (uringEnter(ring, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+                    recordFailure(errno);
+                    broken = true;   /* Writes in flight are never seen again; closing the ring waits for them */
+                    return;
+                }
+            }
+            for (; head != __atomic_load_n(completionTail, __ATOMIC_ACQUIRE); head++) {
+                const io_uring_cqe& completed = completions[head & completionMask];
+                auto* buffer = reinterpret_cast<Buffer*>(completed.user_data);
+                if (completed.res < 0) {
+                    recordFailure(-completed.res);
+                } else if (static_cast<size_t>(completed.res) < buffer->length) {
+                    completeShortWrite(*buffer, static_cast<size_t>(completed.res));
+                }
+                free.push_back(buffer);
+                inFlight--;
+            }
+            __atomic_store_n(completionHead, head, __ATOMIC_RELEASE);
+        }
+
+        void completeShortWrite(const Buffer& buffer, size_t done) {
+            while (done < buffer.length && failure.load() == 0) {
+                const ssize_t written = pwrite(descriptor, buffer.data.get() + done, buffer.length - done,
+                                               static_cast<off_t>(buffer.offset + done));
+                if (written < 0 && errno != EINTR) {
+                    recordFailure(errno);
+                } else if (written > 0) {
+                    done += static_cast<size_t>(written);
+                }
+            }
+        }
+
+        int ring = -1;
+        void* submissionRing = nullptr;
+        void* completionRing = nullptr;
+        size_t submissionBytes = 0;
+        size_t completionBytes = 0;
+        io_uring_sqe* entries = nullptr;
+        size_t entriesBytes = 0;
+        unsigned* submissionTail = nullptr;
+        unsigned submissionMask = 0;
+        unsigned* submissionArray = nullptr;
+        unsigned* completionHead = nullptr;
+        unsigned* completionTail = nullptr;
+        unsigned completionMask = 0;
+        io_uring_cqe* completions = nullptr;
+        std::vector<Buffer*> free;
+        size_t inFlight = 0;
+        bool broken = false;     /* Waiting for completions failed */
+    };
+#endif
+}
+
+/**
+ * @brief Parses the name of an output backend (--io).
+ *
+ * @throws std::invalid_argument For an unknown name.
+ */
+IoBackend output::parse(const std::string& name) {
+    if (name == "write") {
+        return IoBackend::WRITE;
+    }
+    if (name == "direct") {
+        return IoBackend::DIRECT;
+    }
+    if (name == "uring") {
+        return IoBackend::URING;
+    }
+    throw std::invalid_argument("Unknown I/O backend: " + name + " (expected write, direct or uring)");
+}
+
+/** @brief Name of an output backend as accepted by parse(). */
+const char* output::toString(const IoBackend backend) {
+    switch (backend) {
+    case IoBackend::WRITE:
+        return "write";
+    case IoBackend::DIRECT:
+        return "direct";
+    case IoBackend::URING:
+        return "uring";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Tells whether the running kernel lets this process create an io_uring.
+ *
+ * Probed once; kernels before 5.6 and sandboxes blocking the system call report false.
+ */
+bool output::isUringSupported() {
+#ifdef GRADIENT_HAS_URING
+    static const bool supported = [] {
+        io_uring_params parameters{};
+        const int ring = uringSetup(1, &parameters);
+        if (ring < 0) {
+            return false;
+        }
+        ::close(ring);
+        return (parameters.features & IORING_FEAT_RW_CUR_POS) != 0;   /* Implies IORING_OP_WRITE (5.6) */
+    }();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Unlinks an existing output file that shares its contents with other links.
+ *
+ * With --cache-link an output file may be a hardlink to a read-only cache entry. Writers call
+ * this before opening the file with O_TRUNC, so they create a new file instead of rewriting
+ * the entry. Other files, devices and pipes are left alone.
+ *
+ * @param filepath Path about to be written.
+ */
+void output::detach(const std::string& filepath) {
+#ifdef GRADIENT_HAS_POSIX_IO
+    struct stat status{};
+    if (lstat(filepath.c_str(), &status) == 0 && S_ISREG(status.st_mode) && status.st_nlink > 1) {
+        ::unlink(filepath.c_str());
+    }
+#else
+    (void)filepath;
+#endif
+}
+
+/**
+ * @brief Picks the backend that can serve a path, falling back to WRITE.
+ *
+ * DIRECT and URING need a regular file: the standard output, pipes and devices are written
+ * with WRITE. URING also falls back when the kernel does not support it.
+ *
+ * @param requested Backend selected with --io.
+ * @param filepath Output path, "-" for the standard output.
+ */
+IoBackend output::Backend::select(const IoBackend requested, const std::string& filepath) {
+    if (requested == IoBackend::WRITE) {
+        return requested;
+    }
+    if (filepath == "-" || !isRegularTarget(filepath)) {
+        display::verbose(std::string("Output is not a regular file, --io ") + toString(requested) + " falls back to write");
+        return IoBackend::WRITE;
+    }
+    if (requested == IoBackend::URING && !isUringSupported()) {
+        display::verbose("io_uring is not available, --io uring falls back to write");
+        return IoBackend::WRITE;
+    }
+    return requested;
+}
+
+/**
+ * @brief Creates a backend of the given kind; see select() for the kinds a path supports.
+ */
+std::unique_ptr<output::Backend> output::Backend::create(const IoBackend kind) {
+#ifdef GRADIENT_HAS_URING
+    if (kind == IoBackend::URING) {
+        try {
+            return std::make_unique<UringBackend>();
+        } catch (const std::runtime_error& error) {
+            display::verbose(std::string(error.what()) + ", --io uring falls back to write");
+        }
+    }
+#endif
+    return std::make_unique<ThreadedBackend>(kind == IoBackend::URING ? IoBackend::WRITE : kind);
+}
+
+/**
+ * @brief Memory held by the buffer pool of a backend.
+ *
+ * @param bufferBytes Buffer size passed to setBufferBytes().
+ * @param minimum Largest number of bytes acquire() is asked for, e.g. one encoded row.
+ */
+size_t output::Backend::poolBytes(const size_t bufferBytes, const size_t minimum) {
+    const size_t required = std::max(minimum, std::max(bufferBytes, minimumBufferBytes) - alignment) + alignment;
+    return bufferCount * ((required + alignment - 1) / alignment * alignment);
+}
+
+/**
+ * @brief Sets the size of the buffers allocated from now on, at least minimumBufferBytes.
+ *
+ * Buffers are only ever reallocated larger, so a backend that already wrote a file with
+ * bigger buffers keeps them.
+ */
+void output::Backend::setBufferBytes(const size_t bytes) {
+    bufferBytes = std::max(bytes, minimumBufferBytes);
+}
+
+/** @brief Frees a buffer allocated with the backend alignment. */
+void output::Backend::Buffer::AlignedDelete::operator()(char* memory) const {
+    ::operator delete[](memory, std::align_val_t{alignment});
+}
+
+output::Backend::Backend(const IoBackend kind)
+    : backendKind(kind), granularity(kind == IoBackend::DIRECT ? alignment : 1), buffers(bufferCount) {
+    carry.reserve(alignment);
+}
+
+/**
+ * @brief Closes the current file without reporting errors. Derived classes call abandon()
+ * themselves, before their writer goes away.
+ */
+output::Backend::~Backend() = default;
+
+/**
+ * @brief Creates or truncates a file and starts writing it from the beginning.
+ *
+ * The path "-" selects the standard output. The DIRECT backend opens the file with O_DIRECT;
+ * file systems refusing it are written through the page cache instead, with the same padding.
+ *
+ * @param filepath Path to the output file.
+ * @throws std::ios_base::failure If the file cannot be opened.
+ */
+void output::Backend::open(const std::string& filepath) {
+    abandon();
+    path = filepath;
+    failure.store(0);
+    position = 0;
+    length = 0;
+    carry.clear();
+
+#ifdef GRADIENT_HAS_POSIX_IO
+    if (filepath == "-") {
+        std::cout.flush();
+        descriptor = STDOUT_FILENO;
+        ownsDescriptor = false;
+        return;
+    }
+    detach(filepath);
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_CLOEXEC
+    flags |= O_CLOEXEC;
+#endif
+#ifdef O_DIRECT
+    if (backendKind == IoBackend::DIRECT) {
+        descriptor = ::open(filepath.c_str(), flags | O_DIRECT, fileMode);
+        if (descriptor < 0 && errno == EINVAL) {
+            display::verbose("The file system of " + filepath + " does not support O_DIRECT, writing through the page cache");
+        }
+    }
+#endif
+    if (descriptor < 0) {
+        descriptor = ::open(filepath.c_str(), flags, fileMode);
+    }
+    if (descriptor < 0) {
+        throw std::ios_base::failure("Could not open file with following path: " + filepath);
+    }
+    ownsDescriptor = true;
+#else
+    stream = filepath == "-" ? stdout : std::fopen(filepath.c_str(), "wb");
+    if (stream == nullptr) {
+        throw std::ios_base::failure("Could not open file with following path: " + filepath);
+    }
+    ownsDescriptor = stream != stdout;
+    descriptor = 0;
+#endif
+}
+
+/**
+ * @brief Hands out a free buffer with room for at least minimum bytes.
+ *
+ * Waits while every buffer is in flight. When minimum exceeds the buffers (a very wide row),
+ * all writes are drained and the pool is reallocated larger.
+ *
+ * @param minimum Bytes the caller needs to encode.
+ * @return Writable memory; its bytes are submitted with submit().
+ * @throws std::ios_base::failure If an earlier write failed.
+ */
+std::span<char> output::Backend::acquire(const size_t minimum) {
+    const stats::Scope timing(stats::Stage::WRITE, stats::Scope::WALL);
+    const size_t required = std::max(minimum, bufferBytes - alignment) + alignment;
+    if (buffers.front().size < required) {
+        grow(required);
+    }
+    current = take();
+    std::memcpy(current->data.get(), carry.data(), carry.size());
+    return {current->data.get() + carry.size(), current->size - carry.size()};
+}
+
+/**
+ * @brief Starts writing the first bytes of the buffer returned by acquire().
+ *
+ * @param bytes Number of bytes the caller filled.
+ */
+void output::Backend::submit(const size_t bytes) {
+    if (current == nullptr) {
+        throw std::logic_error("No output buffer was acquired");
+    }
+    Buffer* buffer = current;
+    current = nullptr;
+    stats::addBytes(bytes);
+    length += bytes;
+
+    const size_t filled = carry.size() + bytes;
+    const size_t whole = filled / granularity * granularity;
+    carry.assign(buffer->data.get() + whole, buffer->data.get() + filled);
+    if (whole == 0) {
+        release(buffer);
+        return;
+    }
+    buffer->length = whole;
+    buffer->offset = position;
+    position += whole;
+    start(buffer);
+}
+
+/**
+ * @brief Submits the last bytes, waits for every write and closes the file.
+ *
+ * @param bytes Number of bytes the caller filled in the buffer returned by acquire(), if any.
+ * @throws std::ios_base::failure If a write, the final truncation or closing the file failed.
+ */
+void output::Backend::finish(const size_t bytes) {
+    if (descriptor < 0) {
+        return;
+    }
+    const stats::Scope timing(stats::Stage::WRITE, stats::Scope::WALL);
+    closing = true;
+    if (current != nullptr) {
+        submit(bytes);
+    }
+    const bool padded = !carry.empty();
+    if (padded && failure.load() == 0) {
+        /* The last partial block of a DIRECT file, written whole and cut off below */
+        Buffer* buffer = take();
+        std::memcpy(buffer->data.get(), carry.data(), carry.size());
+        std::memset(buffer->data.get() + carry.size(), 0, granularity - carry.size());
+        buffer->length = granularity;
+        buffer->offset = position;
+        start(buffer);
+    }
+    drain();
+    closing = false;
+    carry.clear();
+
+#ifdef GRADIENT_HAS_POSIX_IO
+    if (padded && failure.load() == 0 && ftruncate(descriptor, static_cast<off_t>(length)) != 0) {
+        recordFailure(errno);
+    }
+    if (ownsDescriptor && ::close(descriptor) != 0) {
+        recordFailure(errno);
+    }
+#else
+    if ((ownsDescriptor ? std::fclose(stream) : std::fflush(stream)) != 0) {
+        recordFailure(errno);
+    }
+    stream = nullptr;
+#endif
+    descriptor = -1;
+    if (failure.load() != 0) {
+        throwFailure();
+    }
+}
+
+/**
+ * @brief Stops writing the current file without reporting errors, e.g. after a failed job.
+ */
+void output::Backend::abandon() noexcept {
+    if (descriptor < 0) {
+        return;
+    }
+    if (current != nullptr) {
+        release(current);
+        current = nullptr;
+    }
+    drain();
+    closing = false;
+    carry.clear();
+    close();
+}
+
+/**
+ * @brief Writes a whole buffer at the current file position, retrying partial writes.
+ *
+ * Buffers arrive in submission order, so no offsets are needed and the standard output
+ * may be a pipe.
+ */
+void output::Backend::writeAll(const Buffer& buffer) {
+    const char* data = buffer.data.get();
+    size_t left = buffer.length;
+#ifdef GRADIENT_HAS_POSIX_IO
+    while (left > 0) {
+        const ssize_t written = ::write(descriptor, data, left);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            recordFailure(errno);
+            return;
+        }
+        data += written;
+        left -= static_cast<size_t>(written);
+    }
+#else
+    if (std::fwrite(data, 1, left, stream) != left) {
+        recordFailure(errno != 0 ? errno : EIO);
+    }
+#endif
+}
+
+/** @brief Keeps the first error of the current file. */
+void output::Backend::recordFailure(const int error) {
+    int expected = 0;
+    failure.compare_exchange_strong(expected, error != 0 ? error : EIO);
+}
+
+/** @brief Reports the recorded error of the current file. */
+void output::Backend::throwFailure() const {
+    throw std::ios_base::failure("Could not write the output file " + path + ": " + std::strerror(failure.load()));
+}
+
+/**
+ * @brief Replaces every buffer with one of at least bytes bytes, once no write is in flight.
+ */
+void output::Backend::grow(const size_t bytes) {
+    drain();
+    const size_t size = (bytes + alignment - 1) / alignment * alignment;
+    std::vector<Buffer*> all;
+    for (Buffer& buffer : buffers) {
+        buffer.data.reset(static_cast<char*>(::operator new[](size, std::align_val_t{alignment})));
+        buffer.size = size;
+        all.push_back(&buffer);
+    }
+    reset(all);
+}
+
+/** @brief Closes the file of an abandoned run. */
+void output::Backend::close() noexcept {
+#ifdef GRADIENT_HAS_POSIX_IO
+    if (ownsDescriptor) {
+        ::close(descriptor);
+    }
+#else
+    if (ownsDescriptor) {
+        std::fclose(stream);
+    }
+    stream = nullptr;
+#endif
+    descriptor = -1;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file outputbackend.hpp
+ * @brief Declares the output backends that hand the encoded bytes of FileHandler to the operating system.
+ *
+ * A backend owns a small pool of buffers. FileHandler encodes rows straight into the buffer
+ * returned by acquire() and hands it back with submit(); the backend writes it in the background
+ * while the next buffer is being filled, so encoding and writing overlap until every buffer of
+ * the pool is in flight.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+namespace output {
+    /* Permissions of every output file created through open(), before the umask */
+    constexpr int fileMode = 0644;
+
+    [[nodiscard]] IoBackend parse(const std::string& name);
+    [[nodiscard]] const char* toString(IoBackend backend);
+    [[nodiscard]] bool isUringSupported();
+    void detach(const std::string& filepath);
+
+    /**
+     * @class Backend
+     * @brief Writes a sequence of buffers to one file at a time, keeping several of them in flight.
+     *
+     * The DIRECT backend only writes whole multiples of the alignment: the unaligned end of a
+     * submitted buffer is carried over to the start of the next one, and the last block is
+     * padded and cut off again with ftruncate() when the file is finished. A backend may be
+     * reopened for any number of files; its buffers and writer are reused.
+     */
+    class Backend {
+    public:
+        static constexpr size_t bufferCount = 4;                  /* Buffers in flight */
+        static constexpr size_t defaultBufferBytes = 1024 * 1024; /* Size of each buffer unless a row needs more */
+        static constexpr size_t alignment = 4096;                 /* Buffer alignment, and O_DIRECT write granularity */
+        static constexpr size_t minimumBufferBytes = 2 * alignment;
+
+        [[nodiscard]] static IoBackend select(IoBackend requested, const std::string& filepath);
+        [[nodiscard]] static std::unique_ptr<Backend> create(IoBackend kind);
+        [[nodiscard]] static size_t poolBytes(size_t bufferBytes, size_t minimum);
+
+        virtual ~Backend();
+        Backend(const Backend&) = delete;
+        Backend& operator=(const Backend&) = delete;
+
+        [[nodiscard]] IoBackend kind() const { return backendKind; }
+        void setBufferBytes(size_t bytes);
+
+        void open(const std::string& filepath);
+        [[nodiscard]] std::span<char> acquire(size_t minimum);
+        void submit(size_t bytes);
+        void finish(size_t bytes);
+        void abandon() noexcept;
+
+    protected:
+        /* One buffer of the pool and the write it is part of */
+        struct Buffer {
+            struct AlignedDelete {
+                void operator()(char* memory) const;
+            };
+
+            std::unique_ptr<char[], AlignedDelete> data;
+            size_t size = 0;        /* Allocated bytes */
+            size_t length = 0;      /* Bytes to write */
+            uint64_t offset = 0;    /* File offset of the first byte */
+        };
+
+        explicit Backend(IoBackend kind);
+
+        /* Starts writing buffer->length bytes of buffer at buffer->offset; the buffer returns through release() */
+        virtual void start(Buffer* buffer) = 0;
+        /* Waits for a free buffer; throws once a write has failed */
+        [[nodiscard]] virtual Buffer* take() = 0;
+        /* Returns a buffer that was taken but not written */
+        virtual void release(Buffer* buffer) = 0;
+        /* Waits until every started write has completed */
+        virtual void drain() = 0;
+        /* Called with every buffer before the first write, and again after drain() when they are reallocated */
+        virtual void reset(const std::vector<Buffer*>& buffers) = 0;
+
+        void writeAll(const Buffer& buffer);
+        void recordFailure(int error);
+        [[noreturn]] void throwFailure() const;
+
+        std::string path;
+        int descriptor = -1;
+        std::FILE* stream = nullptr;            /* Used instead of the descriptor without POSIX I/O */
+        bool closing = false;                   /* finish() is writing the last buffers */
+        std::atomic<int> failure{0};            /* errno of the first failed write */
+    private:
+        void grow(size_t bytes);
+        void close() noexcept;
+
+        IoBackend backendKind;
+        size_t granularity;                     /* Every write is a multiple of it */
+        std::vector<Buffer> buffers;
+        size_t bufferBytes = defaultBufferBytes;    /* Size of each buffer unless a row needs more */
+        Buffer* current = nullptr;              /* Buffer handed out by acquire() */
+        std::vector<char> carry;                /* Unaligned end of the last submitted buffer */
+        uint64_t position = 0;                  /* File offset of the next write */
+        uint64_t length = 0;                    /* Bytes submitted to the current file */
+        bool ownsDescriptor = false;            /* False for the standard output */
+    };
+}
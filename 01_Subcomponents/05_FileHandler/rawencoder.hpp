@@ -0,0 +1,60 @@
+/**
+ * @file rawencoder.hpp
+ * @brief Defines the row encoder of the raw format: packed little-endian RGB565 values.
+ *
+ * On little-endian hosts an encoded row is the pixel row itself, so it can be rendered in
+ * place; elsewhere every pixel is split into its two bytes.
+ */
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include "replicate.hpp"
+#include "types.hpp"
+
+namespace rawencoder {
+    /**
+     * @brief Tells whether an encoded row has the memory layout of the pixel row.
+     */
+    static constexpr bool rendersInPlace = std::endian::native == std::endian::little;
+
+    /**
+     * @brief Bytes taken by one encoded row of the given width.
+     */
+    [[nodiscard]] constexpr size_t rowBytes(const ImageWidth width) {
+        return static_cast<size_t>(width) * sizeof(Pixel);
+    }
+
+    /**
+     * @brief Encodes a row of pixels.
+     *
+     * @return Pointer past the last byte written.
+     */
+    inline char* encodeRow(const Pixel* row, const ImageWidth width, char* out) {
+        if constexpr (rendersInPlace) {
+            std::memcpy(out, row, rowBytes(width));
+        } else {
+            for (ImageWidth x = 0; x < width; x++) {
+                out[2 * x] = static_cast<char>(row[x] & 0xFF);
+                out[2 * x + 1] = static_cast<char>(row[x] >> 8);
+            }
+        }
+        return out + rowBytes(width);
+    }
+
+    /**
+     * @brief Encodes a row of width copies of one pixel: one pixel, then the row doubled with memcpy.
+     *
+     * @return Pointer past the last byte written.
+     */
+    inline char* encodeConstantRow(const Pixel pixel, const ImageWidth width, char* out) {
+        if (width > 0) {
+            out[0] = static_cast<char>(pixel & 0xFF);
+            out[1] = static_cast<char>(pixel >> 8);
+            replicate::repeat(out, sizeof(Pixel), rowBytes(width));
+        }
+        return out + rowBytes(width);
+    }
+}
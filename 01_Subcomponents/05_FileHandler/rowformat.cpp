@@ -0,0 +1,118 @@
+/**
+ * @file rowformat.cpp
+ * @brief Implements the per-format row encoding.
+ */
+
+#include <stdexcept>
+#include "rowformat.hpp"
+#include "compactformat.hpp"
+#include "hexencoder.hpp"
+#include "rawencoder.hpp"
+
+/**
+ * @brief Bytes taken by one encoded row.
+ *
+ * @param format Output format.
+ * @param width Number of pixels in the row.
+ * @return Size of the encoded row in bytes, at most that size for the compact format.
+ * @throws std::invalid_argument For the tiled format, which is not written in rows.
+ */
+size_t rowformat::rowBytes(const OutputFormat format, const ImageWidth width) {
+    if (format == OutputFormat::TILED) {
+        throw std::invalid_argument("The tiled format is not written row by row");
+    }
+    if (format == OutputFormat::RLE) {
+        return compact::maxRowBytes(width);
+    }
+    if (format == OutputFormat::RAW) {
+        return rawencoder::rowBytes(width);
+    }
+    return hexencoder::rowBytes(width);
+}
+
+/**
+ * @brief Size of a whole encoded text or raw image, i.e. of the output file.
+ *
+ * @throws std::invalid_argument For the tiled format.
+ */
+size_t rowformat::imageBytes(const OutputFormat format, const ImageWidth width, const ImageHeight height) {
+    return rowBytes(format, width) * height;
+}
+
+/**
+ * @brief Encodes a row of packed pixels.
+ *
+ * @param format Output format.
+ * @param row Pixels to encode.
+ * @param width Number of pixels in the row.
+ * @param out Destination with room for rowBytes(format, width) bytes.
+ * @return Pointer past the last byte written.
+ * @throws std::invalid_argument For the tiled format, which is not written in rows.
+ */
+char* rowformat::encodeRow(const OutputFormat format, const Pixel* row, const ImageWidth width, char* out) {
+    if (format == OutputFormat::TILED) {
+        throw std::invalid_argument("The tiled format is not written row by row");
+    }
+    if (format == OutputFormat::TEXT) {
+        return hexencoder::encodeRow(row, width, out);
+    }
+    if (format == OutputFormat::RLE) {
+        return compact::encodeRow(row, nullptr, width, out);
+    }
+    return rawencoder::encodeRow(row, width, out);
+}
+
+/**
+ * @brief Encodes a row of width copies of one pixel, as encodeRow() would, without a pixel row.
+ *
+ * @param format Output format, TEXT or RAW.
+ * @param pixel Color of every pixel.
+ * @param width Number of pixels in the row.
+ * @param out Destination with room for rowBytes(format, width) bytes.
+ * @return Pointer past the last byte written.
+ * @throws std::invalid_argument For the compact format, whose rows are encoded from pixels, and the tiled format.
+ */
+char* rowformat::encodeConstantRow(const OutputFormat format, const Pixel pixel, const ImageWidth width, char* out) {
+    if (format == OutputFormat::TEXT) {
+        return hexencoder::encodeConstantRow(pixel, width, out);
+    }
+    if (format == OutputFormat::RLE || format == OutputFormat::TILED) {
+        throw std::invalid_argument(std::string("Constant rows are not encoded separately in the ") + toString(format) + " format");
+    }
+    return rawencoder::encodeConstantRow(pixel, width, out);
+}
+
+/**
+ * @brief Converts a --format value to an OutputFormat.
+ *
+ * @throws std::invalid_argument If the name is unknown.
+ */
+OutputFormat rowformat::parse(const std::string& name) {
+    if (name == "text") {
+        return OutputFormat::TEXT;
+    }
+    if (name == "raw") {
+        return OutputFormat::RAW;
+    }
+    if (name == "rle") {
+        return OutputFormat::RLE;
+    }
+    if (name == "tiled") {
+        return OutputFormat::TILED;
+    }
+    throw std::invalid_argument("Unknown output format: " + name);
+}
+
+/** @brief Returns the --format name of a format. */
+const char* rowformat::toString(const OutputFormat format) {
+    switch (format) {
+    case OutputFormat::RAW:
+        return "raw";
+    case OutputFormat::RLE:
+        return "rle";
+    case OutputFormat::TILED:
+        return "tiled";
+    default:
+        return "text";
+    }
+}
@@ -0,0 +1,23 @@
+/**
+ * @file rowformat.hpp
+ * @brief Declares the per-format row encoding used by every output writer.
+ *
+ * The text and raw formats use a fixed number of bytes per row, so the offset of any row in
+ * the output file is known before it is generated. Compact rows vary in size; for them
+ * rowBytes() is an upper bound and encodeRow() never refers to the previous row.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "types.hpp"
+
+namespace rowformat {
+    [[nodiscard]] size_t rowBytes(OutputFormat format, ImageWidth width);
+    [[nodiscard]] size_t imageBytes(OutputFormat format, ImageWidth width, ImageHeight height);
+    char* encodeRow(OutputFormat format, const Pixel* row, ImageWidth width, char* out);
+    char* encodeConstantRow(OutputFormat format, Pixel pixel, ImageWidth width, char* out);
+    [[nodiscard]] OutputFormat parse(const std::string& name);
+    [[nodiscard]] const char* toString(OutputFormat format);
+}
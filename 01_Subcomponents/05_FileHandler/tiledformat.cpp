@@ -0,0 +1,519 @@
+/**
+ * @file tiledformat.cpp
+ * @brief Implements the tiled, indexed output format.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ios>
+#include <stdexcept>
+#include "tiledformat.hpp"
+#include "framebuffer.hpp"
+#include "outputbackend.hpp"
+#include "stats.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GRADIENT_HAS_PWRITE 1
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    [[noreturn]] void fail(const std::string& what, const std::string& filepath, const int error) {
+        throw std::ios_base::failure(what + " " + filepath + ": " + std::strerror(error));
+    }
+
+    char* putU16(const uint16_t value, char* out) {
+        out[0] = static_cast<char>(value & 0xFF);
+        out[1] = static_cast<char>(value >> 8);
+        return out + 2;
+    }
+
+    char* putU32(const uint32_t value, char* out) {
+        for (int i = 0; i < 4; i++) {
+            out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+        }
+        return out + 4;
+    }
+
+    char* putU64(const uint64_t value, char* out) {
+        for (int i = 0; i < 8; i++) {
+            out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+        }
+        return out + 8;
+    }
+
+    char* putVarint(uint64_t value, char* out) {
+        while (value >= 0x80) {
+            *out++ = static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        *out++ = static_cast<char>(value);
+        return out;
+    }
+
+    size_t varintBytes(uint64_t value) {
+        size_t bytes = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            bytes++;
+        }
+        return bytes;
+    }
+
+    uint64_t getLittleEndian(const char* in, const int bytes) {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+        }
+        return value;
+    }
+
+    /**
+     * @brief Calls visit(color, length) for every run of a tile's pixels, rows top first.
+     *
+     * @param rows Pixels of the band holding the tile, rows bottom-up like a framebuffer.
+     * @param tile Rectangle of the tile within the band, y counted from the band's top row.
+     */
+    template <typename Visit>
+    void forEachRun(const Framebuffer& rows, const Region& tile, Visit&& visit) {
+        Pixel color = 0;
+        uint64_t length = 0;
+        for (ImageHeight y = 0; y < tile.height; y++) {
+            const Pixel* row = rows.row(static_cast<ImageHeight>(rows.height() - 1 - (tile.y + y))) + tile.x;
+            for (ImageWidth x = 0; x < tile.width; x++) {
+                if (length > 0 && row[x] == color) {
+                    length++;
+                    continue;
+                }
+                if (length > 0) {
+                    visit(color, length);
+                }
+                color = row[x];
+                length = 1;
+            }
+        }
+        if (length > 0) {
+            visit(color, length);
+        }
+    }
+
+    /**
+     * @brief Encodes one tile in the smaller of its two encodings.
+     *
+     * @param rows Band of rows holding the tile.
+     * @param tile Rectangle of the tile within the band.
+     * @param payload Receives the encoded tile.
+     * @return Encoding of the payload.
+     */
+    tiled::Encoding encodeTile(const Framebuffer& rows, const Region& tile, std::vector<char>& payload) {
+        size_t runBytes = 0;
+        forEachRun(rows, tile, [&runBytes](Pixel, const uint64_t length) { runBytes += 2 + varintBytes(length); });
+        const size_t rawBytes = tile.width * tile.height * sizeof(Pixel);
+
+        if (runBytes < rawBytes) {
+            payload.resize(runBytes);
+            char* out = payload.data();
+            forEachRun(rows, tile, [&out](const Pixel color, const uint64_t length) {
+                out = putVarint(length, putU16(color, out));
+            });
+            return tiled::Encoding::RUNS;
+        }
+        payload.resize(rawBytes);
+        char* out = payload.data();
+        for (ImageHeight y = 0; y < tile.height; y++) {
+            const Pixel* row = rows.row(static_cast<ImageHeight>(rows.height() - 1 - (tile.y + y))) + tile.x;
+            for (ImageWidth x = 0; x < tile.width; x++) {
+                out = putU16(row[x], out);
+            }
+        }
+        return tiled::Encoding::RAW;
+    }
+
+    void checkTileSize(const uint32_t size) {
+        if (size == 0 || size > tiled::maxTileSize) {
+            throw std::invalid_argument("Tile size must be between 1 and " + std::to_string(tiled::maxTileSize));
+        }
+    }
+}
+
+/**
+ * @brief Rectangle of a tile, cut to the image.
+ *
+ * @param column Tile column, 0 being the leftmost.
+ * @param row Tile row, 0 being the top.
+ * @return The tile's pixels; x and y count from the top-left corner of the image.
+ */
+Region tiled::Header::tile(const uint64_t column, const uint64_t row) const {
+    const ImageWidth x = column * tileWidth;
+    const ImageHeight y = row * tileHeight;
+    return Region{x, y, std::min<ImageWidth>(tileWidth, width - x), std::min<ImageHeight>(tileHeight, height - y)};
+}
+
+/**
+ * @brief Describes the image of a single run with square tiles.
+ *
+ * @throws std::invalid_argument If the tile size is out of range.
+ */
+tiled::Header tiled::headerFor(const gradient::Parameters& parameters, const uint32_t tileSize) {
+    checkTileSize(tileSize);
+    const Region region = parameters.output();
+    return Header{region.width, region.height, tileSize, tileSize, parameters.tl, parameters.tr, parameters.bl, parameters.br};
+}
+
+/**
+ * @brief Tells whether a buffer starts like a tiled file.
+ */
+bool tiled::isTiled(const char* bytes, const size_t size) {
+    return size >= sizeof(magic) && std::memcmp(bytes, magic, sizeof(magic)) == 0;
+}
+
+/**
+ * @brief Creates the output file; payloads start right after the space left for the index.
+ *
+ * @param filepath Path to the output file, which has to be seekable.
+ * @param header Image and tile dimensions.
+ * @throws std::invalid_argument For the standard output or tiles out of range.
+ * @throws std::ios_base::failure If the file cannot be created.
+ */
+tiled::Writer::Writer(const std::string& filepath, const Header& header)
+    : path(filepath), imageHeader(header), index(header.tileCount()), end(headerBytes + header.indexBytes()) {
+    checkTileSize(header.tileWidth);
+    checkTileSize(header.tileHeight);
+    if (filepath == "-") {
+        throw std::invalid_argument("The tiled format needs a seekable output file, not the standard output");
+    }
+    output::detach(filepath);
+#ifdef GRADIENT_HAS_PWRITE
+    descriptor = open(filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, output::fileMode);
+    if (descriptor < 0) {
+        fail("Could not open file with following path:", filepath, errno);
+    }
+#else
+    stream = std::fopen(filepath.c_str(), "wb");
+    if (stream == nullptr) {
+        fail("Could not open file with following path:", filepath, errno);
+    }
+#endif
+}
+
+/**
+ * @brief Closes the file if finish() was not called.
+ */
+tiled::Writer::~Writer() {
+    release();
+}
+
+/**
+ * @brief Renders, encodes and writes every tile, one row of tiles at a time.
+ *
+ * @param interpolator Interpolation producing the rows.
+ * @param pool Thread pool rendering rows, encoding tiles and writing them.
+ * @throws std::ios_base::failure If writing to the file failed.
+ */
+void tiled::Writer::write(const Interpolation& interpolator, ThreadPool& pool) {
+    const Header& h = imageHeader;
+    const uint64_t columns = h.tileColumns();
+    if (columns == 0) {
+        return;
+    }
+    Framebuffer band(h.width, static_cast<ImageHeight>(std::min<uint64_t>(h.tileHeight, h.height)));
+    std::vector<std::vector<char>> payloads(columns);
+
+    for (uint64_t tileRow = 0; tileRow < h.tileRows(); tileRow++) {
+        const ImageHeight top = tileRow * h.tileHeight;
+        const ImageHeight rows = std::min<ImageHeight>(h.tileHeight, h.height - top);
+        band.resize(h.width, rows);
+
+        /* The band holds image rows top .. top + rows - 1 (from the top), bottom-up like any framebuffer */
+        stats::addPixels(rows * h.width);
+        {
+            const stats::Scope timing(stats::Stage::GENERATE, stats::Scope::WALL);
+            const size_t grain = std::max<size_t>(rows / (pool.size() * 4), 1);
+            pool.parallelFor(rows, grain, [&](const size_t begin, const size_t stop) {
+                const stats::Scope bandTiming(stats::Stage::GENERATE, stats::Scope::CPU);
+                interpolator.renderRows(static_cast<ImageHeight>(h.height - top - rows + begin), static_cast<ImageHeight>(stop - begin),
+                                        band.row(static_cast<ImageHeight>(begin)), band.stride());
+            });
+        }
+
+        Entry* entries = index.data() + tileRow * columns;
+        {
+            const stats::Scope timing(stats::Stage::ENCODE, stats::Scope::WALL);
+            pool.parallelFor(columns, 1, [&](const size_t begin, const size_t stop) {
+                const stats::Scope tileTiming(stats::Stage::ENCODE, stats::Scope::CPU);
+                for (size_t column = begin; column < stop; column++) {
+                    Region tile = h.tile(column, tileRow);
+                    tile.y = 0;
+                    entries[column].encoding = encodeTile(band, tile, payloads[column]);
+                    entries[column].bytes = static_cast<uint32_t>(payloads[column].size());
+                }
+            });
+        }
+
+        /* Offsets follow from the sizes, then every tile goes to its own place in the file */
+        for (uint64_t column = 0; column < columns; column++) {
+            entries[column].offset = end;
+            end += entries[column].bytes;
+        }
+        const stats::Scope timing(stats::Stage::WRITE, stats::Scope::WALL);
+        auto writeTiles = [&](const size_t begin, const size_t stop) {
+            const stats::Scope tileTiming(stats::Stage::WRITE, stats::Scope::CPU);
+            for (size_t column = begin; column < stop; column++) {
+                writeAt(entries[column].offset, payloads[column].data(), payloads[column].size());
+            }
+        };
+#ifdef GRADIENT_HAS_PWRITE
+        pool.parallelFor(columns, 1, writeTiles);
+#else
+        writeTiles(0, columns);
+#endif
+    }
+}
+
+/**
+ * @brief Writes the header and the index and closes the file.
+ *
+ * @throws std::ios_base::failure If the file could not be written or closed.
+ */
+void tiled::Writer::finish() {
+    const stats::Scope timing(stats::Stage::WRITE);
+    const Header& h = imageHeader;
+    std::vector<char> start(headerBytes + h.indexBytes());
+    std::memcpy(start.data(), magic, sizeof(magic));
+    char* out = putU16(version, start.data() + sizeof(magic));
+    out = putU16(0, out);
+    out = putU64(h.width, out);
+    out = putU64(h.height, out);
+    out = putU32(h.tileWidth, out);
+    out = putU32(h.tileHeight, out);
+    for (const Pixel corner : {h.tl, h.tr, h.bl, h.br}) {
+        out = putU16(corner, out);
+    }
+    for (const Entry& entry : index) {
+        out = putU64(entry.offset, out);
+        out = putU32(entry.bytes, out);
+        out = putU16(static_cast<uint16_t>(entry.encoding), out);
+        out = putU16(0, out);
+    }
+    writeAt(0, start.data(), start.size());
+    stats::addBytes(end);
+
+#ifdef GRADIENT_HAS_PWRITE
+    const int result = descriptor >= 0 ? close(descriptor) : 0;
+    descriptor = -1;
+#else
+    const int result = stream != nullptr ? std::fclose(stream) : 0;
+    stream = nullptr;
+#endif
+    if (result != 0) {
+        fail("Could not write", path, errno);
+    }
+}
+
+/**
+ * @brief Writes bytes at a file offset; safe to call from several threads with POSIX I/O.
+ */
+void tiled::Writer::writeAt(uint64_t offset, const char* data, size_t bytes) {
+#ifdef GRADIENT_HAS_PWRITE
+    while (bytes > 0) {
+        const ssize_t written = pwrite(descriptor, data, bytes, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            fail("Could not write", path, written < 0 ? errno : EIO);
+        }
+        data += written;
+        offset += static_cast<uint64_t>(written);
+        bytes -= static_cast<size_t>(written);
+    }
+#else
+    if (std::fseek(stream, static_cast<long>(offset), SEEK_SET) != 0 || std::fwrite(data, 1, bytes, stream) != bytes) {
+        fail("Could not write", path, errno);
+    }
+#endif
+}
+
+/**
+ * @brief Closes the file without reporting errors.
+ */
+void tiled::Writer::release() noexcept {
+#ifdef GRADIENT_HAS_PWRITE
+    if (descriptor >= 0) {
+        close(descriptor);
+        descriptor = -1;
+    }
+#else
+    if (stream != nullptr) {
+        std::fclose(stream);
+        stream = nullptr;
+    }
+#endif
+}
+
+/**
+ * @brief Maps a tiled file and checks its header.
+ *
+ * The index is checked entry by entry when a tile is read, so opening costs the same for
+ * any image size.
+ *
+ * @param filepath Path to the file, "-" for the standard input.
+ * @throws std::ios_base::failure If the file cannot be read.
+ * @throws std::runtime_error If the file is not a tiled file of a supported version.
+ */
+tiled::Reader::Reader(const std::string& filepath) : file(filepath) {
+    const char* in = file.data();
+    if (file.size() < headerBytes || !isTiled(in, file.size())) {
+        throw std::runtime_error("Not a tiled gradient file");
+    }
+    const auto fileVersion = static_cast<uint16_t>(getLittleEndian(in + 4, 2));
+    if (fileVersion != version) {
+        throw std::runtime_error("Unsupported tiled format version " + std::to_string(fileVersion));
+    }
+    Header& h = imageHeader;
+    h.width = getLittleEndian(in + 8, 8);
+    h.height = getLittleEndian(in + 16, 8);
+    h.tileWidth = static_cast<uint32_t>(getLittleEndian(in + 24, 4));
+    h.tileHeight = static_cast<uint32_t>(getLittleEndian(in + 28, 4));
+    h.tl = static_cast<Pixel>(getLittleEndian(in + 32, 2));
+    h.tr = static_cast<Pixel>(getLittleEndian(in + 34, 2));
+    h.bl = static_cast<Pixel>(getLittleEndian(in + 36, 2));
+    h.br = static_cast<Pixel>(getLittleEndian(in + 38, 2));
+    if (h.width > maxImageDimension || h.height > maxImageDimension) {
+        throw std::runtime_error("Tiled file dimensions are out of range");
+    }
+    if (h.tileWidth == 0 || h.tileWidth > maxTileSize || h.tileHeight == 0 || h.tileHeight > maxTileSize) {
+        throw std::runtime_error("Tiled file tile size is out of range");
+    }
+    if (file.size() - headerBytes < h.indexBytes()) {
+        throw std::runtime_error("Tiled file is truncated in its index");
+    }
+}
+
+/**
+ * @brief Reads the index entry of a tile.
+ *
+ * @throws std::out_of_range If the tile is outside the image.
+ * @throws std::runtime_error If the entry points outside the file or has an unknown encoding.
+ */
+tiled::Entry tiled::Reader::entry(const uint64_t column, const uint64_t row) const {
+    const Header& h = imageHeader;
+    if (column >= h.tileColumns() || row >= h.tileRows()) {
+        throw std::out_of_range("Tile " + std::to_string(column) + "," + std::to_string(row) + " is outside the image");
+    }
+    const char* in = file.data() + headerBytes + (row * h.tileColumns() + column) * entryBytes;
+    Entry result{getLittleEndian(in, 8), static_cast<uint32_t>(getLittleEndian(in + 8, 4)),
+                 static_cast<Encoding>(getLittleEndian(in + 12, 2))};
+    if (result.offset > file.size() || result.bytes > file.size() - result.offset
+        || (result.encoding != Encoding::RAW && result.encoding != Encoding::RUNS)) {
+        throw std::runtime_error("Malformed index entry of tile " + std::to_string(column) + "," + std::to_string(row));
+    }
+    return result;
+}
+
+/**
+ * @brief Decodes one tile.
+ *
+ * @param column Tile column, 0 being the leftmost.
+ * @param row Tile row, 0 being the top.
+ * @param out Destination of the tile's top row; header().tile(column, row) tells its size.
+ * @param stride Pixels between the starts of two rows of out.
+ * @throws std::out_of_range If the tile is outside the image.
+ * @throws std::runtime_error If the tile is malformed.
+ */
+void tiled::Reader::readTile(const uint64_t column, const uint64_t row, Pixel* out, const size_t stride) const {
+    const Entry location = entry(column, row);
+    const Region tile = imageHeader.tile(column, row);
+    const char* in = file.data() + location.offset;
+    auto malformed = [column, row]() {
+        return std::runtime_error("Malformed tile " + std::to_string(column) + "," + std::to_string(row));
+    };
+
+    if (location.encoding == Encoding::RAW) {
+        if (location.bytes != tile.width * tile.height * sizeof(Pixel)) {
+            throw malformed();
+        }
+        for (ImageHeight y = 0; y < tile.height; y++) {
+            for (ImageWidth x = 0; x < tile.width; x++, in += 2) {
+                out[y * stride + x] = static_cast<Pixel>(getLittleEndian(in, 2));
+            }
+        }
+        return;
+    }
+
+    /* Runs may continue from one row of the tile to the next */
+    const char* last = in + location.bytes;
+    ImageWidth x = 0;
+    ImageHeight y = 0;
+    while (y < tile.height) {
+        if (last - in < 3) {
+            throw malformed();
+        }
+        const auto color = static_cast<Pixel>(getLittleEndian(in, 2));
+        in += 2;
+        uint64_t length = 0;
+        for (int shift = 0;; shift += 7) {
+            if (in == last || shift >= 64) {
+                throw malformed();
+            }
+            const auto next = static_cast<uint8_t>(*in++);
+            length |= static_cast<uint64_t>(next & 0x7F) << shift;
+            if ((next & 0x80) == 0) {
+                break;
+            }
+        }
+        if (length == 0 || length > (tile.height - y) * tile.width - x) {
+            throw malformed();
+        }
+        while (length > 0) {
+            const uint64_t span = std::min<uint64_t>(length, tile.width - x);
+            std::fill_n(out + y * stride + x, span, color);
+            length -= span;
+            x += span;
+            if (x == tile.width) {
+                x = 0;
+                y++;
+            }
+        }
+    }
+    if (in != last) {
+        throw malformed();
+    }
+}
+
+/**
+ * @brief Decodes a rectangle of the image from the tiles it overlaps.
+ *
+ * @param region Rectangle to read, x and y counted from the top-left corner of the image.
+ * @param out Destination of the rectangle's top row.
+ * @param stride Pixels between the starts of two rows of out.
+ * @throws std::out_of_range If the rectangle is not inside the image.
+ * @throws std::runtime_error If a tile is malformed.
+ */
+void tiled::Reader::readRegion(const Region& region, Pixel* out, const size_t stride) const {
+    const Header& h = imageHeader;
+    if (region.x > h.width || region.width > h.width - region.x || region.y > h.height || region.height > h.height - region.y) {
+        throw std::out_of_range("Region exceeds the " + std::to_string(h.width) + " x " + std::to_string(h.height) + " image");
+    }
+    if (region.width == 0 || region.height == 0) {
+        return;
+    }
+
+    std::vector<Pixel> scratch(static_cast<size_t>(h.tileWidth) * h.tileHeight);
+    for (uint64_t row = region.y / h.tileHeight; row <= (region.y + region.height - 1) / h.tileHeight; row++) {
+        for (uint64_t column = region.x / h.tileWidth; column <= (region.x + region.width - 1) / h.tileWidth; column++) {
+            const Region tile = h.tile(column, row);
+            readTile(column, row, scratch.data(), tile.width);
+
+            /* Copy the overlap of tile and region */
+            const ImageWidth left = std::max(region.x, tile.x), right = std::min(region.x + region.width, tile.x + tile.width);
+            const ImageHeight top = std::max(region.y, tile.y), bottom = std::min(region.y + region.height, tile.y + tile.height);
+            for (ImageHeight y = top; y < bottom; y++) {
+                std::copy_n(scratch.data() + (y - tile.y) * tile.width + (left - tile.x), right - left,
+                            out + (y - region.y) * stride + (left - region.x));
+            }
+        }
+    }
+}
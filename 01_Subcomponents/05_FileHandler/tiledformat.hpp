@@ -0,0 +1,138 @@
+/**
+ * @file tiledformat.hpp
+ * @brief Declares the tiled, indexed output format, its parallel writer and its random-access reader.
+ *
+ * Layout, all integers little-endian:
+ *
+ *     header   "G5TI" | u16 version | u16 reserved (0) | u64 width | u64 height
+ *              | u32 tile width | u32 tile height | u16 tl, tr, bl, br
+ *     index    one entry per tile, tile rows top first, tiles left to right:
+ *              u64 offset | u32 bytes | u16 encoding | u16 reserved (0)
+ *     tiles    the payloads the index points to:
+ *              0 RAW   the tile's u16 colors, rows top first
+ *              1 RUNS  (u16 color, varint length) pairs covering the tile's pixels in the same order
+ *
+ * Tiles at the right and bottom edges are cut to the image. The writer stores every tile in
+ * the smaller of its two encodings. The index sits at a fixed position and has fixed-size
+ * entries, so a reader finds any tile without looking at the others, and a viewport only
+ * touches the tiles it overlaps.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "defaults.hpp"
+#include "filereader.hpp"
+#include "interpolation.hpp"
+#include "parameters.hpp"
+#include "threadpool.hpp"
+#include "types.hpp"
+
+namespace tiled {
+    static constexpr char magic[4] = {'G', '5', 'T', 'I'};
+    static constexpr uint16_t version = 1;
+    static constexpr size_t headerBytes = 40;
+    static constexpr size_t entryBytes = 16;
+    static constexpr uint32_t defaultTileSize = defaults::tileSize;
+    static constexpr uint32_t maxTileSize = defaults::maxTileSize;   /* A raw tile stays below 2^32 bytes */
+
+    /**
+     * @enum Encoding
+     * @brief Storage of one tile's pixels.
+     */
+    enum class Encoding : uint16_t {
+        RAW = 0,
+        RUNS = 1
+    };
+
+    /**
+     * @struct Header
+     * @brief Image described by a tiled file.
+     */
+    struct Header {
+        ImageWidth width = 0;
+        ImageHeight height = 0;
+        uint32_t tileWidth = defaultTileSize;
+        uint32_t tileHeight = defaultTileSize;
+        Pixel tl = 0;
+        Pixel tr = 0;
+        Pixel bl = 0;
+        Pixel br = 0;
+
+        [[nodiscard]] uint64_t tileColumns() const { return (width + tileWidth - 1) / tileWidth; }
+        [[nodiscard]] uint64_t tileRows() const { return (height + tileHeight - 1) / tileHeight; }
+        [[nodiscard]] uint64_t tileCount() const { return tileColumns() * tileRows(); }
+        [[nodiscard]] size_t indexBytes() const { return static_cast<size_t>(tileCount()) * entryBytes; }
+        [[nodiscard]] Region tile(uint64_t column, uint64_t row) const;
+    };
+
+    [[nodiscard]] Header headerFor(const gradient::Parameters& parameters, uint32_t tileSize);
+
+    /**
+     * @struct Entry
+     * @brief Index entry of one tile.
+     */
+    struct Entry {
+        uint64_t offset = 0;
+        uint32_t bytes = 0;
+        Encoding encoding = Encoding::RAW;
+    };
+
+    /**
+     * @class Writer
+     * @brief Renders an image one row of tiles at a time and writes its tiles in parallel.
+     *
+     * The rows of a tile row are rendered over the pool, then every tile of it is encoded by
+     * one task. Once the band is encoded its file offsets follow from the tile sizes, and the
+     * tiles are written concurrently with pwrite() where it is available. The index is kept in
+     * memory and written last, so memory use is one tile row of pixels plus its encoding.
+     * The output has to be a seekable file.
+     */
+    class Writer {
+    public:
+        Writer(const std::string& filepath, const Header& header);
+        ~Writer();
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        void write(const Interpolation& interpolator, ThreadPool& pool);
+        void finish();
+    private:
+        void writeAt(uint64_t offset, const char* data, size_t bytes);
+        void release() noexcept;
+
+        std::string path;
+        Header imageHeader;
+        std::vector<Entry> index;
+        uint64_t end;               /* Offset of the next tile payload */
+        int descriptor = -1;
+        std::FILE* stream = nullptr;    /* Used instead of the descriptor without POSIX I/O */
+    };
+
+    /**
+     * @class Reader
+     * @brief Fetches single tiles or rectangles of a tiled file in time independent of the image size.
+     *
+     * The file is mapped by FileReader; reading a tile looks up its index entry and decodes
+     * its payload, touching no other part of the file. Reads are const and may run from
+     * several threads at once.
+     */
+    class Reader {
+    public:
+        explicit Reader(const std::string& filepath);
+
+        [[nodiscard]] const Header& header() const { return imageHeader; }
+        [[nodiscard]] Entry entry(uint64_t column, uint64_t row) const;
+        void readTile(uint64_t column, uint64_t row, Pixel* out, size_t stride) const;
+        void readRegion(const Region& region, Pixel* out, size_t stride) const;
+    private:
+        FileReader file;
+        Header imageHeader;
+    };
+
+    [[nodiscard]] bool isTiled(const char* bytes, size_t size);
+}
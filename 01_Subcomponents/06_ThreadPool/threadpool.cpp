@@ -0,0 +1,169 @@
+/**
+ * @file threadpool.cpp
+ * @brief Implements the work-stealing ThreadPool.
+ */
+
+#include <algorithm>
+#include "threadpool.hpp"
+#include "defaults.hpp"
+
+namespace {
+    /* Queue owned by the current thread; 0 for threads that are not pool workers */
+    thread_local size_t homeQueue = 0;
+}
+
+/**
+ * @brief Starts the worker threads.
+ *
+ * @param threadCount Total number of threads working on a parallelFor(), including the caller.
+ */
+ThreadPool::ThreadPool(const size_t threadCount) {
+    const size_t count = std::max<size_t>(threadCount, 1);
+    for (size_t i = 0; i < count; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 1; i < count; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+/**
+ * @brief Stops and joins the worker threads.
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Returns the number of threads used when none is requested explicitly.
+ */
+size_t ThreadPool::defaultThreadCount() {
+    return defaults::threadCount();
+}
+
+/**
+ * @brief Runs body over [0, count) split into ranges of at most grain elements.
+ *
+ * The ranges are spread over all worker deques; the calling thread works on them too and
+ * returns once every range has finished. The first exception thrown by body is rethrown.
+ *
+ * @param count Number of elements.
+ * @param grain Maximum number of elements handed to one call of body.
+ * @param body Function called with each range.
+ */
+void ThreadPool::parallelFor(const size_t count, const size_t grain, const RangeTask& body) {
+    if (count == 0) {
+        return;
+    }
+    const size_t step = std::max<size_t>(grain, 1);
+    const size_t taskCount = (count + step - 1) / step;
+    if (taskCount == 1 || workers.empty()) {
+        body(0, count);
+        return;
+    }
+
+    Job job{&body, taskCount, nullptr, {}};
+    queuedTasks.fetch_add(taskCount);
+    size_t target = nextQueue.fetch_add(1, std::memory_order_relaxed);
+    for (size_t begin = 0; begin < count; begin += step, target++) {
+        Queue& queue = *queues[target % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(Task{&job, begin, std::min(begin + step, count)});
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_all();
+
+    while (job.remaining.load() > 0) {
+        if (runOne(homeQueue)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this, &job] { return job.remaining.load() == 0 || queuedTasks.load() > 0; });
+    }
+
+    if (job.error) {
+        std::rethrow_exception(job.error);
+    }
+}
+
+/**
+ * @brief Main loop of a worker thread.
+ *
+ * @param index Index of the deque owned by this worker.
+ */
+void ThreadPool::workerLoop(const size_t index) {
+    homeQueue = index;
+    while (true) {
+        if (runOne(index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || queuedTasks.load() > 0; });
+        if (stopping && queuedTasks.load() == 0) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Runs one task, taken from the back of the home deque or stolen from another deque.
+ *
+ * @param home Index of the deque owned by the calling thread.
+ * @return True if a task was run.
+ */
+bool ThreadPool::runOne(const size_t home) {
+    if (queuedTasks.load() == 0) {
+        return false;
+    }
+    for (size_t offset = 0; offset < queues.size(); offset++) {
+        Queue& queue = *queues[(home + offset) % queues.size()];
+        std::unique_lock<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        Task task{};
+        if (offset == 0) {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        } else {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        }
+        lock.unlock();
+        queuedTasks.fetch_sub(1);
+        execute(task);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Runs a task and signals its job when it was the last one.
+ */
+void ThreadPool::execute(const Task& task) {
+    Job& job = *task.job;
+    try {
+        (*job.body)(task.begin, task.end);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(job.errorMutex);
+        if (!job.error) {
+            job.error = std::current_exception();
+        }
+    }
+
+    if (job.remaining.fetch_sub(1) == 1) {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_all();
+    }
+}
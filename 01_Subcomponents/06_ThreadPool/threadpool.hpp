@@ -0,0 +1,75 @@
+/**
+ * @file threadpool.hpp
+ * @brief Defines the ThreadPool class, a work-stealing pool used to generate row bands in parallel.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads, each owning a task deque.
+ *
+ * Workers take tasks from the back of their own deque and steal from the front of the
+ * other deques when it runs empty. The thread calling parallelFor() helps as well, so
+ * nested or concurrent parallelFor() calls cannot deadlock.
+ */
+class ThreadPool {
+public:
+    /**
+     * @typedef RangeTask
+     * @brief Body of a parallel loop, called with a half-open range [begin, end).
+     */
+    using RangeTask = std::function<void(size_t begin, size_t end)>;
+
+    explicit ThreadPool(size_t threadCount);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void parallelFor(size_t count, size_t grain, const RangeTask& body);
+    [[nodiscard]] size_t size() const { return workers.size() + 1; }
+
+    [[nodiscard]] static size_t defaultThreadCount();
+private:
+    /* Shared state of one parallelFor() call */
+    struct Job {
+        const RangeTask* body;
+        std::atomic<size_t> remaining;
+        std::exception_ptr error;
+        std::mutex errorMutex;
+    };
+
+    struct Task {
+        Job* job;
+        size_t begin;
+        size_t end;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(size_t index);
+    bool runOne(size_t home);
+    void execute(const Task& task);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queuedTasks{0};
+    std::atomic<size_t> nextQueue{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
@@ -0,0 +1,149 @@
+/**
+ * @file pipeline.cpp
+ * @brief Implements the StreamingPipeline class.
+ */
+
+#include <algorithm>
+#include <thread>
+#include "pipeline.hpp"
+#include "stats.hpp"
+
+/**
+ * @brief Constructs a pipeline; no buffers are allocated before run().
+ *
+ * @param interpolator Interpolation producing the rows.
+ * @param fileHandler Destination of the formatted rows.
+ * @param pool Thread pool rendering the rows of a block.
+ * @param blockRows Number of rows per block.
+ * @param ringSize Number of blocks in the ring.
+ */
+StreamingPipeline::StreamingPipeline(const Interpolation& interpolator, FileHandler& fileHandler, ThreadPool& pool,
+                                     const size_t blockRows, const size_t ringSize)
+    : interpolator(interpolator), fileHandler(fileHandler), pool(pool),
+      blockRows(std::max<size_t>(blockRows, 1)), ring(std::max<size_t>(ringSize, 2)) {}
+
+/**
+ * @brief Computes how many rows of the given width fit into a block.
+ *
+ * @param width Image width in pixels.
+ * @param blockBytes Pixel memory available for one block.
+ * @return Number of rows per block, at least 1.
+ */
+size_t StreamingPipeline::blockRowsFor(const ImageWidth width, const size_t blockBytes) {
+    return std::max<size_t>(blockBytes / (Framebuffer::strideFor(width) * sizeof(Pixel) + 1), 1);
+}
+
+/**
+ * @brief Generates and writes the whole image, then closes the file.
+ *
+ * Blocks are produced from the top of the image downwards, which is the order
+ * FileHandler emits rows in, so no block has to wait for a later one. A pipeline may run
+ * several images in turn, e.g. the frames of an animation, reusing its blocks.
+ *
+ * @param width Image width in pixels.
+ * @param height Image height in pixels.
+ * @param finish Close the file afterwards; false leaves it open for further images, e.g. the
+ * following frames of an animation.
+ * @throws The first exception raised while generating or writing.
+ */
+void StreamingPipeline::run(const ImageWidth width, const ImageHeight height, const bool finish) {
+    const auto rowsPerBlock = static_cast<ImageHeight>(std::min<size_t>(blockRows, std::max<ImageHeight>(height, 1)));
+    freeBlocks.clear();
+    filledBlocks.clear();
+    producerDone = false;
+    writerError = nullptr;
+    for (Block& block : ring) {
+        block.rows.resize(width, rowsPerBlock);
+        freeBlocks.push_back(&block);
+    }
+
+    std::thread writer(&StreamingPipeline::writerLoop, this);
+    std::exception_ptr producerError;
+
+    try {
+        for (ImageHeight top = height; top > 0;) {
+            Block* block = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [this] { return !freeBlocks.empty() || writerError; });
+                if (writerError) {
+                    break;
+                }
+                block = freeBlocks.front();
+                freeBlocks.pop_front();
+            }
+
+            block->firstRow = top > rowsPerBlock ? static_cast<ImageHeight>(top - rowsPerBlock) : 0;
+            block->rowCount = static_cast<ImageHeight>(top - block->firstRow);
+            const size_t grain = std::max<size_t>(block->rowCount / (pool.size() * 4), 1);
+            stats::addPixels(block->rowCount * width);
+            {
+                const stats::Scope timing(stats::Stage::GENERATE, stats::Scope::WALL);
+                pool.parallelFor(block->rowCount, grain, [this, block](const size_t begin, const size_t end) {
+                    const stats::Scope bandTiming(stats::Stage::GENERATE, stats::Scope::CPU);
+                    interpolator.renderRows(static_cast<ImageHeight>(block->firstRow + begin), static_cast<ImageHeight>(end - begin),
+                                            block->rows.row(static_cast<ImageHeight>(begin)), block->rows.stride());
+                });
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                filledBlocks.push_back(block);
+            }
+            changed.notify_all();
+            top = block->firstRow;
+        }
+    } catch (...) {
+        producerError = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        producerDone = true;
+    }
+    changed.notify_all();
+    writer.join();
+
+    if (producerError) {
+        std::rethrow_exception(producerError);
+    }
+    if (writerError) {
+        std::rethrow_exception(writerError);
+    }
+    if (finish) {
+        fileHandler.finish();
+    }
+}
+
+/**
+ * @brief Writer thread: formats and writes filled blocks in order and recycles them.
+ */
+void StreamingPipeline::writerLoop() {
+    while (true) {
+        Block* block = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return !filledBlocks.empty() || producerDone; });
+            if (filledBlocks.empty()) {
+                return;
+            }
+            block = filledBlocks.front();
+            filledBlocks.pop_front();
+        }
+
+        try {
+            fileHandler.writeRows(block->rows, block->rowCount, interpolator.shape());
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            writerError = std::current_exception();
+            changed.notify_all();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            freeBlocks.push_back(block);
+        }
+        changed.notify_all();
+    }
+}
@@ -0,0 +1,61 @@
+/**
+ * @file pipeline.hpp
+ * @brief Defines the StreamingPipeline class, which generates and writes an image block by block.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <vector>
+#include "filehandler.hpp"
+#include "framebuffer.hpp"
+#include "interpolation.hpp"
+#include "threadpool.hpp"
+
+/**
+ * @class StreamingPipeline
+ * @brief Overlaps generation and writing through a bounded ring of row blocks.
+ *
+ * The calling thread renders blocks in output order (top row first) with the thread pool,
+ * while a writer thread formats and writes finished blocks. Memory use is bounded by the
+ * ring, independent of the image height.
+ */
+class StreamingPipeline {
+public:
+    StreamingPipeline(const Interpolation& interpolator, FileHandler& fileHandler, ThreadPool& pool,
+                      size_t blockRows, size_t ringSize = defaultRingSize);
+    ~StreamingPipeline() = default;
+
+    void run(ImageWidth width, ImageHeight height, bool finish = true);
+
+    [[nodiscard]] static size_t blockRowsFor(ImageWidth width, size_t blockBytes = defaultBlockBytes);
+
+    static constexpr size_t defaultRingSize = 4;                   /* Blocks in flight */
+    static constexpr size_t defaultBlockBytes = 4 * 1024 * 1024;   /* Pixel bytes per block */
+private:
+    /* A block of rows and the range of image rows it holds */
+    struct Block {
+        ResultGradient rows;
+        ImageHeight firstRow = 0;
+        ImageHeight rowCount = 0;
+    };
+
+    void writerLoop();
+
+    const Interpolation& interpolator;
+    FileHandler& fileHandler;
+    ThreadPool& pool;
+    size_t blockRows;
+    std::vector<Block> ring;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Block*> freeBlocks;
+    std::deque<Block*> filledBlocks;
+    bool producerDone = false;
+    std::exception_ptr writerError;
+};
@@ -0,0 +1,352 @@
+/**
+ * @file batchrunner.cpp
+ * @brief Implements the BatchRunner class.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "batchrunner.hpp"
+#include "argparser.hpp"
+#include "display.hpp"
+#include "interpolation.hpp"
+#include "pipeline.hpp"
+#include "stats.hpp"
+#include "tiledformat.hpp"
+
+namespace {
+    /* Jobs with more pixels per block than this spread their rows over the pool */
+    constexpr size_t parallelBlockPixels = 256 * 1024;
+
+    /* Positional order of the JSON keys, followed by the optional ones */
+    const char* const jsonPositionalKeys[] = {"width", "height", "tl", "tr", "bl", "br", "output"};
+
+    /* Options a job may use; each takes a value. Any other option belongs to a whole run. */
+    const char* const jobOptions[] = {"--format", "--io", "--tile-size", "--gradient", "--stops", "--angle", "--region"};
+
+    void skipSpaces(const std::string& line, size_t& position) {
+        while (position < line.size() && std::isspace(static_cast<unsigned char>(line[position]))) {
+            position++;
+        }
+    }
+
+    void expect(const std::string& line, size_t& position, const char expected) {
+        skipSpaces(line, position);
+        if (position >= line.size() || line[position] != expected) {
+            throw std::invalid_argument(std::string("Malformed JSON, expected '") + expected + "'");
+        }
+        position++;
+    }
+
+    std::string parseJsonString(const std::string& line, size_t& position) {
+        expect(line, position, '"');
+        std::string value;
+        while (position < line.size() && line[position] != '"') {
+            if (line[position] == '\\' && position + 1 < line.size()) {
+                position++;
+            }
+            value += line[position++];
+        }
+        expect(line, position, '"');
+        return value;
+    }
+
+    /* Numbers and bare words are kept as text, ArgParser validates them */
+    std::string parseJsonValue(const std::string& line, size_t& position) {
+        skipSpaces(line, position);
+        if (position < line.size() && line[position] == '"') {
+            return parseJsonString(line, position);
+        }
+        const size_t start = position;
+        while (position < line.size() && line[position] != ',' && line[position] != '}'
+               && !std::isspace(static_cast<unsigned char>(line[position]))) {
+            position++;
+        }
+        if (start == position) {
+            throw std::invalid_argument("Malformed JSON, missing value");
+        }
+        return line.substr(start, position - start);
+    }
+}
+
+/**
+ * @brief Constructs a runner; the manifest is read by run().
+ *
+ * @param manifestPath Path to the manifest file.
+ * @param pool Thread pool shared by all jobs.
+ * @param cache Result cache consulted before and filled after every job; may be null.
+ */
+BatchRunner::BatchRunner(std::string manifestPath, ThreadPool& pool, const ResultCache* cache)
+    : manifestPath(std::move(manifestPath)), pool(pool), cache(cache),
+      workspaces(pool.size()) {
+    for (Workspace& workspace : workspaces) {
+        freeWorkspaces.push_back(&workspace);
+    }
+}
+
+/**
+ * @brief Runs every job of the manifest and prints a report.
+ *
+ * Jobs run concurrently on the pool; a failing job does not stop the others.
+ *
+ * @return True if every job succeeded.
+ * @throws std::ios_base::failure If the manifest cannot be read.
+ */
+bool BatchRunner::run() {
+    const std::vector<Job> jobs = readManifest();
+    std::vector<Result> results(jobs.size());
+
+    pool.parallelFor(jobs.size(), 1, [this, &jobs, &results](const size_t begin, const size_t end) {
+        for (size_t index = begin; index < end; index++) {
+            Workspace& workspace = acquireWorkspace();
+            runJob(jobs[index], workspace, results[index]);
+            releaseWorkspace(workspace);
+        }
+    });
+
+    report(jobs, results);
+    return std::all_of(results.begin(), results.end(), [](const Result& result) { return result.succeeded; });
+}
+
+/**
+ * @brief Reads the manifest and splits every job line into arguments.
+ *
+ * @return Jobs in manifest order. Lines that cannot be split are kept as jobs whose error
+ * holds the parse error; they fail with it when run.
+ */
+std::vector<BatchRunner::Job> BatchRunner::readManifest() const {
+    std::ifstream manifest(manifestPath);
+    if (!manifest.is_open()) {
+        throw std::ios_base::failure("Could not open manifest with following path: " + manifestPath);
+    }
+
+    std::vector<Job> jobs;
+    std::string line;
+    for (size_t number = 1; std::getline(manifest, line); number++) {
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+
+        Job job{number, {}, {}};
+        try {
+            job.tokens = splitLine(line);
+        } catch (const std::invalid_argument& e) {
+            job.error = e.what();
+        }
+        jobs.push_back(std::move(job));
+    }
+    return jobs;
+}
+
+/**
+ * @brief Splits a job line, in either manifest form, into command line arguments.
+ *
+ * @param line Whitespace separated arguments or a JSON object.
+ * @return Arguments accepted by ArgParser.
+ * @throws std::invalid_argument If a JSON line is malformed.
+ */
+std::vector<std::string> BatchRunner::splitLine(const std::string& line) {
+    const size_t first = line.find_first_not_of(" \t\r");
+    if (first != std::string::npos && line[first] == '{') {
+        return parseJsonLine(line);
+    }
+    std::vector<std::string> tokens;
+    std::istringstream words(line);
+    for (std::string word; words >> word;) {
+        tokens.push_back(word);
+    }
+    return tokens;
+}
+
+/**
+ * @brief Converts a JSON object line to the equivalent command line arguments.
+ *
+ * @param line A flat JSON object with string or numeric values.
+ * @return Positional arguments followed by options.
+ * @throws std::invalid_argument If the line is malformed or a key is missing or unknown.
+ */
+std::vector<std::string> BatchRunner::parseJsonLine(const std::string& line) {
+    std::vector<std::string> positional(std::size(jsonPositionalKeys));
+    std::vector<std::string> options;
+    size_t position = 0;
+
+    expect(line, position, '{');
+    skipSpaces(line, position);
+    bool more = position < line.size() && line[position] != '}';
+    while (more) {
+        const std::string key = parseJsonString(line, position);
+        expect(line, position, ':');
+        const std::string value = parseJsonValue(line, position);
+
+        const auto* match = std::find(std::begin(jsonPositionalKeys), std::end(jsonPositionalKeys), key);
+        if (match != std::end(jsonPositionalKeys)) {
+            positional[static_cast<size_t>(match - std::begin(jsonPositionalKeys))] = value;
+        } else if (key == "format" || key == "gradient" || key == "stops" || key == "angle" || key == "region"
+                   || key == "io") {
+            options.insert(options.end(), {"--" + key, value});
+        } else {
+            throw std::invalid_argument("Unknown JSON key: " + key);
+        }
+
+        skipSpaces(line, position);
+        more = position < line.size() && line[position] == ',';
+        if (more) {
+            position++;
+        }
+    }
+    expect(line, position, '}');
+
+    for (size_t index = 0; index < positional.size(); index++) {
+        if (positional[index].empty()) {
+            throw std::invalid_argument(std::string("Missing JSON key: ") + jsonPositionalKeys[index]);
+        }
+    }
+    positional.insert(positional.end(), options.begin(), options.end());
+    return positional;
+}
+
+/**
+ * @brief Generates and writes one job using the buffers of a workspace.
+ *
+ * The image is produced block by block into the reused row block and written through the
+ * reused FileHandler buffer. Large blocks spread their rows over the shared pool.
+ *
+ * @param job Job to run.
+ * @param workspace Buffers owned by the calling thread for the duration of the job.
+ * @param result Receives the outcome; exceptions never leave this function.
+ */
+void BatchRunner::runJob(const Job& job, Workspace& workspace, Result& result) {
+    const auto start = std::chrono::steady_clock::now();
+    try {
+        if (!job.error.empty()) {
+            throw std::invalid_argument(job.error);
+        }
+        const auto args = std::make_shared<ArgParser>(job.tokens);
+        if (!args->getBatchManifest().empty()) {
+            throw std::invalid_argument("Batch jobs cannot start another batch");
+        }
+        if (args->getFrameCount() > 0) {
+            throw std::invalid_argument("Batch jobs cannot render animations");
+        }
+        if (args->isVerifying()) {
+            throw std::invalid_argument("Batch jobs cannot verify files");
+        }
+        if (args->getOutputPath() == FileHandler::standardOutput) {
+            throw std::invalid_argument("Batch jobs cannot write to the standard output");
+        }
+        for (size_t index = 0; index < job.tokens.size(); index++) {
+            if (job.tokens[index].starts_with("--")) {
+                if (std::find(std::begin(jobOptions), std::end(jobOptions), job.tokens[index]) == std::end(jobOptions)) {
+                    throw std::invalid_argument("Batch jobs cannot use " + job.tokens[index]);
+                }
+                index++;
+            }
+        }
+        result.output = args->getOutputPath();
+
+        const std::string key = cache ? ResultCache::keyFor(*args) : std::string();
+        if (cache && cache->fetch(key, result.output)) {
+            result.succeeded = result.cached = true;
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            result.seconds = elapsed.count();
+            return;
+        }
+
+        const auto interpolator = InterpolationFactory::get(args->getParameters());
+        if (args->getOutputFormat() == OutputFormat::TILED) {
+            tiled::Writer writer(args->getOutputPath(), tiled::headerFor(args->getParameters(), args->getTileSize()));
+            writer.write(*interpolator, pool);
+            writer.finish();
+        } else {
+            const ImageWidth width = args->getRegion().width;
+            const ImageHeight height = args->getRegion().height;
+            const auto rowsPerBlock = static_cast<ImageHeight>(
+                std::min<size_t>(StreamingPipeline::blockRowsFor(width), std::max<ImageHeight>(height, 1)));
+
+            workspace.block.resize(width, rowsPerBlock);
+            workspace.fileHandler.open(args->getOutputPath(), args->getOutputFormat(), compact::headerFor(args->getParameters()),
+                                       args->getIoBackend());
+
+            for (ImageHeight top = height; top > 0;) {
+                const ImageHeight first = top > rowsPerBlock ? top - rowsPerBlock : 0;
+                const ImageHeight rows = top - first;
+                auto render = [&interpolator, &workspace, first](const size_t begin, const size_t end) {
+                    const stats::Scope timing(stats::Stage::GENERATE, stats::Scope::CPU);
+                    interpolator->renderRows(static_cast<ImageHeight>(first + begin), static_cast<ImageHeight>(end - begin),
+                                             workspace.block.row(static_cast<ImageHeight>(begin)), workspace.block.stride());
+                };
+                stats::addPixels(rows * width);
+                {
+                    const stats::Scope timing(stats::Stage::GENERATE, stats::Scope::WALL);
+                    if (rows * width >= parallelBlockPixels) {
+                        pool.parallelFor(rows, std::max<size_t>(rows / (pool.size() * 4), 1), render);
+                    } else {
+                        render(0, rows);
+                    }
+                }
+                workspace.fileHandler.writeRows(workspace.block, rows, interpolator->shape());
+                top = first;
+            }
+            workspace.fileHandler.finish();
+        }
+        if (cache) {
+            cache->insert(key, result.output);
+        }
+        result.succeeded = true;
+    } catch (const std::exception& e) {
+        workspace.fileHandler.abandon();
+        result.error = e.what();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+}
+
+/**
+ * @brief Takes a free workspace, or adds one if all are in use.
+ *
+ * A thread waiting for the rows of a large job helps the pool and may start another job
+ * before its own is done, so more jobs than threads can be running at once.
+ */
+BatchRunner::Workspace& BatchRunner::acquireWorkspace() {
+    std::lock_guard<std::mutex> lock(workspaceMutex);
+    if (freeWorkspaces.empty()) {
+        return workspaces.emplace_back();
+    }
+    Workspace* workspace = freeWorkspaces.back();
+    freeWorkspaces.pop_back();
+    return *workspace;
+}
+
+/**
+ * @brief Returns a workspace for use by the next job.
+ */
+void BatchRunner::releaseWorkspace(Workspace& workspace) {
+    std::lock_guard<std::mutex> lock(workspaceMutex);
+    freeWorkspaces.push_back(&workspace);
+}
+
+/**
+ * @brief Prints one line per job and a summary.
+ */
+void BatchRunner::report(const std::vector<Job>& jobs, const std::vector<Result>& results) const {
+    size_t failed = 0;
+    for (size_t index = 0; index < jobs.size(); index++) {
+        const Result& result = results[index];
+        char timing[32];
+        std::snprintf(timing, sizeof(timing), "%.3f ms", result.seconds * 1e3);
+        if (result.succeeded) {
+            display::info("[ok]     line " + std::to_string(jobs[index].line) + ": " + result.output + " (" + timing
+                          + (result.cached ? ", cached)" : ")"));
+        } else {
+            failed++;
+            display::info("[failed] line " + std::to_string(jobs[index].line) + ": " + result.error);
+        }
+    }
+    display::info("Batch finished: " + std::to_string(jobs.size()) + " jobs, "
+                  + std::to_string(jobs.size() - failed) + " succeeded, " + std::to_string(failed) + " failed");
+}
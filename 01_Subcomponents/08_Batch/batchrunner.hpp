@@ -0,0 +1,76 @@
+/**
+ * @file batchrunner.hpp
+ * @brief Defines the BatchRunner class, which runs all gradient jobs of a manifest in one process.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "filehandler.hpp"
+#include "framebuffer.hpp"
+#include "resultcache.hpp"
+#include "threadpool.hpp"
+#include "types.hpp"
+
+/**
+ * @class BatchRunner
+ * @brief Runs the jobs of a manifest on a shared thread pool and reports the outcome of each.
+ *
+ * A manifest holds one job per line, either as the command line arguments of a single run
+ * ("<width> <height> <tl> <tr> <bl> <br> <output_path> [options]") or as a JSON object with
+ * the keys width, height, tl, tr, bl, br, output and optionally format, gradient, stops and angle. Options that
+ * configure a whole run, such as --mmap or --stats-json, fail the job. Empty lines and lines
+ * starting with '#' are skipped. Every running job holds a workspace whose row block and output
+ * buffer are reused by the next job; there is one per pool thread, and more are added when a
+ * thread starts another job while it waits for the rows of its own. Jobs share the result cache of the command line, if any.
+ */
+class BatchRunner {
+public:
+    BatchRunner(std::string manifestPath, ThreadPool& pool, const ResultCache* cache = nullptr);
+    ~BatchRunner() = default;
+
+    [[nodiscard]] bool run();
+
+    [[nodiscard]] static std::vector<std::string> splitLine(const std::string& line);
+private:
+    /* One line of the manifest */
+    struct Job {
+        size_t line;
+        std::vector<std::string> tokens;
+        std::string error; /* Why the line could not be split, empty if it could */
+    };
+
+    /* Outcome of one job */
+    struct Result {
+        bool succeeded = false;
+        bool cached = false;
+        std::string output;
+        std::string error;
+        double seconds = 0.0;
+    };
+
+    /* Buffers reused by consecutive jobs */
+    struct Workspace {
+        Framebuffer block;
+        FileHandler fileHandler;
+    };
+
+    [[nodiscard]] std::vector<Job> readManifest() const;
+    [[nodiscard]] static std::vector<std::string> parseJsonLine(const std::string& line);
+    void runJob(const Job& job, Workspace& workspace, Result& result);
+    [[nodiscard]] Workspace& acquireWorkspace();
+    void releaseWorkspace(Workspace& workspace);
+    void report(const std::vector<Job>& jobs, const std::vector<Result>& results) const;
+
+    std::string manifestPath;
+    ThreadPool& pool;
+    const ResultCache* cache;
+
+    std::deque<Workspace> workspaces;    /* Grows without moving the workspaces in use */
+    std::vector<Workspace*> freeWorkspaces;
+    std::mutex workspaceMutex;
+};
@@ -0,0 +1,314 @@
+/**
+ * @file resultcache.cpp
+ * @brief Implements the ResultCache class.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <ios>
+#include <system_error>
+#include <vector>
+#include "resultcache.hpp"
+#include "display.hpp"
+#include "outputbackend.hpp"
+#include "rowformat.hpp"
+#include "stats.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GRADIENT_HAS_POSIX_FILES 1
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#endif
+
+namespace {
+    constexpr const char* temporaryPrefix = ".tmp-";
+
+    /* FNV-1a, 64 bit */
+    uint64_t hash(const std::string& text) {
+        uint64_t value = 0xcbf29ce484222325ULL;
+        for (const char character : text) {
+            value ^= static_cast<unsigned char>(character);
+            value *= 0x100000001b3ULL;
+        }
+        return value;
+    }
+
+#ifdef GRADIENT_HAS_POSIX_FILES
+    /* Closes a descriptor when leaving scope */
+    struct Descriptor {
+        int value;
+        explicit Descriptor(const int value) : value(value) {}
+        Descriptor(const Descriptor&) = delete;
+        Descriptor& operator=(const Descriptor&) = delete;
+        ~Descriptor() {
+            if (value >= 0) {
+                close(value);
+            }
+        }
+    };
+
+    /* Shares the extents of the source with the empty target, if the filesystem can */
+    bool reflink(const int source, const int target) {
+#if defined(__linux__)
+        return ioctl(target, FICLONE, source) == 0;
+#else
+        (void)source;
+        (void)target;
+        return false;
+#endif
+    }
+
+    /**
+     * Copies a whole file between descriptors: a reflink where the filesystem shares
+     * extents, otherwise an in-kernel copy. The target must be empty.
+     */
+    bool copyContents(const int source, const int target, const uint64_t bytes) {
+        if (reflink(source, target)) {
+            return true;
+        }
+#if defined(__linux__)
+        off_t offset = 0;
+        while (static_cast<uint64_t>(offset) < bytes) {
+            const ssize_t sent = sendfile(target, source, &offset, bytes - static_cast<uint64_t>(offset));
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent <= 0) {
+                return false;
+            }
+        }
+        return true;
+#else
+        std::vector<char> buffer(1024 * 1024);
+        uint64_t copied = 0;
+        while (copied < bytes) {
+            const ssize_t count = read(source, buffer.data(), buffer.size());
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0 || write(target, buffer.data(), static_cast<size_t>(count)) != count) {
+                return false;
+            }
+            copied += static_cast<uint64_t>(count);
+        }
+        return true;
+#endif
+    }
+#endif
+}
+
+/**
+ * @brief Opens the cache, creating its directory if needed.
+ *
+ * @param directory Directory holding the entries.
+ * @param maxBytes Total size of the entries above which old entries are evicted.
+ * @param allowLinks Serve hits by hardlink when a reflink is not possible.
+ * @throws std::filesystem::filesystem_error If the directory cannot be created.
+ */
+ResultCache::ResultCache(std::string directory, const uint64_t maxBytes, const bool allowLinks)
+    : directory(std::move(directory)), maxBytes(maxBytes), allowLinks(allowLinks) {
+    std::filesystem::create_directories(this->directory);
+}
+
+/**
+ * @brief Computes the cache key of the image described by the arguments.
+ *
+ * The key covers everything that changes the bytes of the output file and nothing else,
+ * so e.g. the thread count or --stream do not split the cache.
+ *
+ * @param args Parsed arguments of a single run.
+ * @return 16 hex digits.
+ */
+std::string ResultCache::keyFor(const ArgParser& args) {
+    std::string stops;
+    for (const Pixel stop : args.getStops()) {
+        stops += std::to_string(stop) + ',';
+    }
+    std::string parameters = std::string(generatorVersion)
+        + '|' + std::to_string(args.getImageWidth()) + '|' + std::to_string(args.getImageHeight())
+        + '|' + std::to_string(args.getTopLeft()) + '|' + std::to_string(args.getTopRight())
+        + '|' + std::to_string(args.getBottomLeft()) + '|' + std::to_string(args.getBottomRight())
+        + '|' + std::to_string(static_cast<int>(args.getInterpolationType()))
+        + '|' + stops + '|' + std::to_string(args.getAngle())
+        + '|' + rowformat::toString(args.getOutputFormat());
+    if (args.getOutputFormat() == OutputFormat::TILED) {
+        parameters += '|' + std::to_string(args.getTileSize());
+    }
+
+    /* Whole images keep the keys they had before --region existed */
+    const Region region = args.getRegion();
+    if (region.width != args.getImageWidth() || region.height != args.getImageHeight()) {
+        parameters += '|' + std::to_string(region.x) + ',' + std::to_string(region.y)
+                    + ',' + std::to_string(region.width) + ',' + std::to_string(region.height);
+    }
+
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash(parameters)));
+    return key;
+}
+
+/**
+ * @brief Serves a cached result to the output path.
+ *
+ * The output is a reflink of the entry where the filesystem supports it, else a hardlink to
+ * it if links are allowed, else a copy. An output that is already a hardlink to an entry is
+ * replaced rather than truncated, so the entry is never rewritten.
+ *
+ * @param key Key from keyFor().
+ * @param outputPath Path receiving the file.
+ * @return False on a miss; the output path is left untouched then.
+ * @throws std::ios_base::failure If the entry exists but could not be copied to the output.
+ */
+bool ResultCache::fetch(const std::string& key, const std::string& outputPath) const {
+#ifdef GRADIENT_HAS_POSIX_FILES
+    const std::string entry = entryPath(key);
+    const Descriptor source(open(entry.c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat status{};
+    if (source.value < 0 || fstat(source.value, &status) != 0) {
+        return false;
+    }
+    /* The modification time orders the entries for eviction */
+    futimens(source.value, nullptr);
+
+    const stats::Scope timing(stats::Stage::WRITE);
+    output::detach(outputPath);
+    const Descriptor target(open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, output::fileMode));
+    if (target.value >= 0 && reflink(source.value, target.value)) {
+        stats::addBytes(static_cast<uint64_t>(status.st_size));
+        return true;
+    }
+
+    if (allowLinks) {
+        const std::string link = temporaryPath(outputPath);
+        if (::link(entry.c_str(), link.c_str()) == 0) {
+            if (rename(link.c_str(), outputPath.c_str()) == 0) {
+                return true;
+            }
+            unlink(link.c_str());
+        }
+    }
+
+    stats::addBytes(static_cast<uint64_t>(status.st_size));
+    if (target.value < 0 || !copyContents(source.value, target.value, static_cast<uint64_t>(status.st_size))) {
+        throw std::ios_base::failure("Could not copy cached result to " + outputPath + ": " + std::strerror(errno));
+    }
+    return true;
+#else
+    (void)key;
+    (void)outputPath;
+    return false;
+#endif
+}
+
+/**
+ * @brief Stores a finished output file under the key.
+ *
+ * The file is copied to a temporary entry that is renamed into place once complete, so
+ * concurrent readers and writers never see a partial entry. Caching is best effort: failures
+ * are reported as verbose messages and leave the cache unchanged.
+ *
+ * @param key Key from keyFor().
+ * @param outputPath Path of the finished output file.
+ */
+void ResultCache::insert(const std::string& key, const std::string& outputPath) const {
+#ifdef GRADIENT_HAS_POSIX_FILES
+    const std::string entry = entryPath(key);
+    if (access(entry.c_str(), F_OK) == 0) {
+        return;
+    }
+
+    const Descriptor source(open(outputPath.c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat status{};
+    if (source.value < 0 || fstat(source.value, &status) != 0 || !S_ISREG(status.st_mode)) {
+        display::verbose("Cache: cannot read " + outputPath + ", result not cached");
+        return;
+    }
+
+    const std::string temporary = temporaryPath(entry);
+    bool stored;
+    {
+        const Descriptor target(open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0444));
+        stored = target.value >= 0 && copyContents(source.value, target.value, static_cast<uint64_t>(status.st_size));
+    }
+    if (!stored || rename(temporary.c_str(), entry.c_str()) != 0) {
+        display::verbose("Cache: could not store " + entry + ": " + std::strerror(errno));
+        unlink(temporary.c_str());
+        return;
+    }
+    evict();
+#else
+    (void)key;
+    (void)outputPath;
+#endif
+}
+
+/** @brief Path of the entry for a key. */
+std::string ResultCache::entryPath(const std::string& key) const {
+    return (std::filesystem::path(directory) / key).string();
+}
+
+/**
+ * @brief Unique temporary path next to the target, so renaming it onto the target is atomic.
+ */
+std::string ResultCache::temporaryPath(const std::string& target) {
+    static std::atomic<uint64_t> counter{0};
+    const std::filesystem::path path(target);
+    std::string name = std::string(temporaryPrefix) + path.filename().string();
+#ifdef GRADIENT_HAS_POSIX_FILES
+    name += '-' + std::to_string(getpid());
+#endif
+    name += '-' + std::to_string(counter.fetch_add(1));
+    return (path.parent_path() / name).string();
+}
+
+/**
+ * @brief Removes least recently used entries until the cache fits its size limit.
+ *
+ * Entries removed concurrently by another process are skipped silently.
+ */
+void ResultCache::evict() const {
+    struct Entry {
+        std::filesystem::file_time_type used;
+        uint64_t bytes;
+        std::filesystem::path path;
+    };
+
+    std::error_code error;
+    std::vector<Entry> entries;
+    uint64_t totalBytes = 0;
+    for (const auto& item : std::filesystem::directory_iterator(directory, error)) {
+        if (item.path().filename().string().starts_with(temporaryPrefix) || !item.is_regular_file(error)) {
+            continue;
+        }
+        const uint64_t bytes = item.file_size(error);
+        const auto used = item.last_write_time(error);
+        if (!error) {
+            entries.push_back({used, bytes, item.path()});
+            totalBytes += bytes;
+        }
+    }
+    if (totalBytes <= maxBytes) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    for (const Entry& entry : entries) {
+        if (totalBytes <= maxBytes) {
+            break;
+        }
+        std::filesystem::remove(entry.path, error);
+        totalBytes -= entry.bytes;
+        display::verbose("Cache: evicted " + entry.path.filename().string());
+    }
+}
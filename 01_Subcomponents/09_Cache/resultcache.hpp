@@ -0,0 +1,45 @@
+/**
+ * @file resultcache.hpp
+ * @brief Defines the ResultCache class, a content-addressed on-disk cache of generated files.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "argparser.hpp"
+#include "defaults.hpp"
+#include "types.hpp"
+
+/**
+ * @class ResultCache
+ * @brief Stores finished output files under a hash of the parameters that produced them.
+ *
+ * An entry is named after the hash of the image parameters, the interpolation, the output
+ * format and generatorVersion, so entries written by another generator version are never
+ * served. Entries are inserted atomically by renaming a complete temporary file into place.
+ * A hit is served by reflink or, failing that, by an in-kernel copy; hardlinks are used only
+ * when allowed, because a linked output shares its contents with the cache entry. Every hit
+ * refreshes the modification time of the entry, and when the cache grows beyond its size
+ * limit the least recently used entries are removed.
+ */
+class ResultCache {
+public:
+    ResultCache(std::string directory, uint64_t maxBytes, bool allowLinks);
+    ~ResultCache() = default;
+
+    [[nodiscard]] static std::string keyFor(const ArgParser& args);
+
+    [[nodiscard]] bool fetch(const std::string& key, const std::string& outputPath) const;
+    void insert(const std::string& key, const std::string& outputPath) const;
+
+    static constexpr uint64_t defaultMaxBytes = defaults::cacheBytes;   /* Size limit without --cache-size */
+private:
+    [[nodiscard]] std::string entryPath(const std::string& key) const;
+    [[nodiscard]] static std::string temporaryPath(const std::string& target);
+    void evict() const;
+
+    std::string directory;
+    uint64_t maxBytes;
+    bool allowLinks;
+};
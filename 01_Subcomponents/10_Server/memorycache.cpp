@@ -0,0 +1,53 @@
+/**
+ * @file memorycache.cpp
+ * @brief Implements the MemoryCache class.
+ */
+
+#include "memorycache.hpp"
+
+/**
+ * @brief Creates an empty cache.
+ *
+ * @param maxBytes Total size of the entries above which the least recently used ones are dropped.
+ */
+MemoryCache::MemoryCache(const size_t maxBytes) : maxBytes(maxBytes) {}
+
+/**
+ * @brief Looks an entry up and marks it as most recently used.
+ *
+ * @return The entry, or null on a miss.
+ */
+MemoryCache::Entry MemoryCache::find(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto found = index.find(key);
+    if (found == index.end()) {
+        return nullptr;
+    }
+    recent.splice(recent.begin(), recent, found->second);
+    return found->second->second;
+}
+
+/**
+ * @brief Adds an entry and evicts least recently used entries until the cache fits.
+ *
+ * Entries larger than the whole cache are not stored. Inserting an existing key keeps
+ * the entry already cached.
+ */
+void MemoryCache::insert(const std::string& key, Entry entry) {
+    if (!entry || entry->size() > maxBytes) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (index.contains(key)) {
+        return;
+    }
+    usedBytes += entry->size();
+    recent.emplace_front(key, std::move(entry));
+    index.emplace(key, recent.begin());
+
+    while (usedBytes > maxBytes) {
+        usedBytes -= recent.back().second->size();
+        index.erase(recent.back().first);
+        recent.pop_back();
+    }
+}
@@ -0,0 +1,42 @@
+/**
+ * @file memorycache.hpp
+ * @brief Defines the MemoryCache class, a size-bounded LRU of encoded images kept in memory.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @class MemoryCache
+ * @brief Thread-safe least-recently-used map from result keys to encoded images.
+ *
+ * Entries are shared and immutable, so a reader keeps its entry alive even if it is
+ * evicted while the bytes are still being sent.
+ */
+class MemoryCache {
+public:
+    using Entry = std::shared_ptr<const std::vector<char>>;
+
+    explicit MemoryCache(size_t maxBytes);
+    ~MemoryCache() = default;
+
+    [[nodiscard]] Entry find(const std::string& key);
+    void insert(const std::string& key, Entry entry);
+    [[nodiscard]] size_t capacity() const { return maxBytes; }
+private:
+    using Item = std::pair<std::string, Entry>;
+
+    size_t maxBytes;
+    size_t usedBytes = 0;
+    std::list<Item> recent;   /* Most recently used first */
+    std::unordered_map<std::string, std::list<Item>::iterator> index;
+    std::mutex mutex;
+};
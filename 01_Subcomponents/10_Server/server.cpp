@@ -0,0 +1,302 @@
+/**
+ * @file server.cpp
+ * @brief Implements the GradientServer class.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ios>
+#include <memory>
+#include <stdexcept>
+#include "server.hpp"
+#include "argparser.hpp"
+#include "batchrunner.hpp"
+#include "display.hpp"
+#include "interpolation.hpp"
+#include "pipeline.hpp"
+#include "resultcache.hpp"
+#include "rowformat.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GRADIENT_HAS_UNIX_SOCKETS 1
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef GRADIENT_HAS_UNIX_SOCKETS
+    [[noreturn]] void fail(const std::string& what, const int error) {
+        throw std::ios_base::failure(what + ": " + std::strerror(error));
+    }
+
+    sockaddr_un addressOf(const std::string& socketPath) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("Socket path is too long: " + socketPath);
+        }
+        std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+        return address;
+    }
+
+    bool sendAll(const int connection, const char* data, size_t size) {
+        while (size > 0) {
+            const ssize_t sent = send(connection, data, size, MSG_NOSIGNAL);
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent <= 0) {
+                return false;
+            }
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    /* Whether the peer of a connection runs as the user of the server */
+    bool sameUser(const int connection) {
+#if defined(SO_PEERCRED)
+        ucred credentials{};
+        socklen_t size = sizeof(credentials);
+        return getsockopt(connection, SOL_SOCKET, SO_PEERCRED, &credentials, &size) == 0 && credentials.uid == geteuid();
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+        uid_t user;
+        gid_t group;
+        return getpeereid(connection, &user, &group) == 0 && user == geteuid();
+#else
+        (void)connection;
+        return true;    /* The socket mode alone keeps other users out */
+#endif
+    }
+#endif
+}
+
+/**
+ * @brief Binds the socket; requests are accepted by run().
+ *
+ * A stale socket file left by a previous server is replaced; a socket that still accepts
+ * connections is an error. The socket is made accessible to its owner only before it
+ * starts listening.
+ *
+ * @param socketPath Path of the Unix domain socket.
+ * @param pool Thread pool generating the images.
+ * @param cacheBytes Size of the in-memory cache of encoded images.
+ * @throws std::ios_base::failure If the socket cannot be created.
+ */
+GradientServer::GradientServer(std::string socketPath, ThreadPool& pool, const size_t cacheBytes)
+    : socketPath(std::move(socketPath)), pool(pool), cache(cacheBytes) {
+#ifdef GRADIENT_HAS_UNIX_SOCKETS
+    const sockaddr_un address = addressOf(this->socketPath);
+    const auto* generic = reinterpret_cast<const sockaddr*>(&address);
+
+    struct stat status{};
+    if (stat(this->socketPath.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+        const int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        const bool alive = probe >= 0 && connect(probe, generic, sizeof(address)) == 0;
+        if (probe >= 0) {
+            close(probe);
+        }
+        if (alive) {
+            throw std::ios_base::failure("Another server is listening on " + this->socketPath);
+        }
+        unlink(this->socketPath.c_str());
+    }
+
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        fail("Could not create socket", errno);
+    }
+    if (bind(listener, generic, sizeof(address)) != 0 || chmod(this->socketPath.c_str(), S_IRUSR | S_IWUSR) != 0
+        || listen(listener, SOMAXCONN) != 0) {
+        const int error = errno;
+        close(listener);
+        fail("Could not listen on " + this->socketPath, error);
+    }
+#else
+    throw std::ios_base::failure("Server mode is not supported on this platform");
+#endif
+}
+
+/**
+ * @brief Closes and removes the socket.
+ */
+GradientServer::~GradientServer() {
+#ifdef GRADIENT_HAS_UNIX_SOCKETS
+    if (listener >= 0) {
+        close(listener);
+        unlink(socketPath.c_str());
+    }
+#endif
+}
+
+/**
+ * @brief Serves requests until a "quit" request arrives.
+ *
+ * Several connection threads accept concurrently; each keeps its own request and output
+ * buffers, and all of them share the thread pool and the memory cache.
+ */
+void GradientServer::run() {
+    display::verbose("Serving on " + socketPath);
+    std::vector<std::thread> threads;
+    const size_t count = std::max(pool.size(), minimumConnectionThreads);
+    for (size_t i = 0; i < count; i++) {
+        threads.emplace_back(&GradientServer::acceptLoop, this);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Main loop of a connection thread.
+ */
+void GradientServer::acceptLoop() {
+#ifdef GRADIENT_HAS_UNIX_SOCKETS
+    Workspace workspace;
+    workspace.request.reserve(maxRequestBytes);
+    while (!stopping.load()) {
+        const int connection = accept(listener, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (!stopping.load()) {
+                display::error(std::string("Server: accept failed: ") + std::strerror(errno));
+            }
+            return;
+        }
+        handle(connection, workspace);
+        close(connection);
+    }
+#endif
+}
+
+/**
+ * @brief Reads the request line of a connection and sends the response.
+ *
+ * Connections from other users are refused; requests write files and stop the server with
+ * the rights of the server's user.
+ */
+void GradientServer::handle(const int connection, Workspace& workspace) {
+#ifdef GRADIENT_HAS_UNIX_SOCKETS
+    workspace.request.clear();
+    char chunk[4096];
+    while (workspace.request.find('\n') == std::string::npos && workspace.request.size() < maxRequestBytes) {
+        const ssize_t received = recv(connection, chunk, sizeof(chunk), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        workspace.request.append(chunk, static_cast<size_t>(received));
+    }
+    workspace.request.resize(std::min(workspace.request.find('\n'), workspace.request.size()));
+
+    std::string header;
+    try {
+        if (!sameUser(connection)) {
+            throw std::runtime_error("The server only serves requests of its own user");
+        }
+        header = serve(connection, workspace);
+    } catch (const std::exception& e) {
+        header = std::string("ERROR ") + e.what() + "\n";
+        std::replace(header.begin(), header.end() - 1, '\n', ' ');
+    }
+    if (!header.empty()) {
+        sendAll(connection, header.data(), header.size());
+    }
+#else
+    (void)connection;
+    (void)workspace;
+#endif
+}
+
+/**
+ * @brief Produces the image of one request.
+ *
+ * @return The response header, or an empty string if the response was already sent.
+ * @throws std::exception If the request is invalid or the image cannot be written.
+ */
+std::string GradientServer::serve(const int connection, Workspace& workspace) {
+#ifdef GRADIENT_HAS_UNIX_SOCKETS
+    if (workspace.request == "quit") {
+        stop();
+        return "BYE\n";
+    }
+
+    const auto args = std::make_shared<ArgParser>(BatchRunner::splitLine(workspace.request));
+    if (!args->getBatchManifest().empty() || !args->getServeSocket().empty() || args->getFrameCount() > 0 || args->isVerifying()) {
+        throw std::invalid_argument("Requests cannot start a batch, another server, an animation or a verification");
+    }
+    if (args->getOutputFormat() == OutputFormat::RLE || args->getOutputFormat() == OutputFormat::TILED) {
+        throw std::invalid_argument(std::string("The server does not serve the ") + rowformat::toString(args->getOutputFormat()) + " format");
+    }
+    const std::string outputPath = args->getOutputPath();
+    const OutputFormat format = args->getOutputFormat();
+    const ImageWidth width = args->getRegion().width;
+    const ImageHeight height = args->getRegion().height;
+    const size_t imageBytes = rowformat::imageBytes(format, width, height);
+
+    if (imageBytes > cache.capacity()) {
+        if (outputPath == FileHandler::standardOutput) {
+            throw std::invalid_argument("Image is larger than the server cache, request it with an output path");
+        }
+        const auto interpolator = InterpolationFactory::get(args->getParameters());
+        workspace.fileHandler.open(outputPath, format, {}, args->getIoBackend());
+        try {
+            StreamingPipeline pipeline(*interpolator, workspace.fileHandler, pool, StreamingPipeline::blockRowsFor(width));
+            pipeline.run(width, height);
+        } catch (...) {
+            workspace.fileHandler.abandon();
+            throw;
+        }
+        return "FILE " + outputPath + "\n";
+    }
+
+    const std::string key = ResultCache::keyFor(*args);
+    MemoryCache::Entry image = cache.find(key);
+    if (!image) {
+        const auto interpolator = InterpolationFactory::get(args->getParameters());
+        auto encoded = std::make_shared<std::vector<char>>(imageBytes);
+        interpolator->encodeImage(pool, format, encoded->data());
+        image = std::move(encoded);
+        cache.insert(key, image);
+    }
+
+    if (outputPath == FileHandler::standardOutput) {
+        const std::string header = "DATA " + std::to_string(image->size()) + "\n";
+        if (sendAll(connection, header.data(), header.size())) {
+            sendAll(connection, image->data(), image->size());
+        }
+        return {};
+    }
+    workspace.fileHandler.open(outputPath, format, {}, args->getIoBackend());
+    try {
+        workspace.fileHandler.writeEncoded(*image);
+        workspace.fileHandler.finish();
+    } catch (...) {
+        workspace.fileHandler.abandon();
+        throw;
+    }
+    return "FILE " + outputPath + "\n";
+#else
+    (void)connection;
+    (void)workspace;
+    return {};
+#endif
+}
+
+/**
+ * @brief Makes every connection thread leave its accept loop.
+ */
+void GradientServer::stop() {
+#ifdef GRADIENT_HAS_UNIX_SOCKETS
+    stopping.store(true);
+    shutdown(listener, SHUT_RDWR);
+#endif
+}
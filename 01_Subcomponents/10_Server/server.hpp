@@ -0,0 +1,64 @@
+/**
+ * @file server.hpp
+ * @brief Defines the GradientServer class, which serves gradient requests over a Unix domain socket.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+#include "defaults.hpp"
+#include "filehandler.hpp"
+#include "memorycache.hpp"
+#include "threadpool.hpp"
+#include "types.hpp"
+
+/**
+ * @class GradientServer
+ * @brief Resident process answering gradient requests with a warm thread pool.
+ *
+ * Every connection carries one request line in either batch manifest form (see BatchRunner)
+ * and receives one response:
+ * - "DATA <n>\n" followed by n bytes of the encoded image, when the output path is "-";
+ * - "FILE <path>\n" once the image has been written to the requested output path;
+ * - "ERROR <message>\n" if the request could not be served.
+ * The request "quit" stops the server. Only the user running the server may connect: the
+ * socket has mode 0600 and peers of other users are refused, so requests write files with
+ * that user's rights; relative output paths are resolved against the server's working
+ * directory. Encoded images are kept in a MemoryCache, so repeated requests skip generation;
+ * images too large for it can only be written to a path and are streamed there block by block.
+ */
+class GradientServer {
+public:
+    GradientServer(std::string socketPath, ThreadPool& pool, size_t cacheBytes);
+    ~GradientServer();
+    GradientServer(const GradientServer&) = delete;
+    GradientServer& operator=(const GradientServer&) = delete;
+
+    void run();
+
+    static constexpr size_t defaultCacheBytes = defaults::serveCacheBytes;   /* Memory cache size without --serve-cache */
+private:
+    /* Buffers owned by one connection thread and reused between requests */
+    struct Workspace {
+        std::string request;
+        FileHandler fileHandler;
+    };
+
+    void acceptLoop();
+    void handle(int connection, Workspace& workspace);
+    [[nodiscard]] std::string serve(int connection, Workspace& workspace);
+    void stop();
+
+    static constexpr size_t minimumConnectionThreads = 4;   /* Connections served concurrently */
+    static constexpr size_t maxRequestBytes = 64 * 1024;
+
+    std::string socketPath;
+    ThreadPool& pool;
+    MemoryCache cache;
+    int listener = -1;
+    std::atomic<bool> stopping{false};
+};
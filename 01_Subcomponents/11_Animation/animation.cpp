@@ -0,0 +1,280 @@
+/**
+ * @file animation.cpp
+ * @brief Implements the AnimationRunner class.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include "animation.hpp"
+#include "display.hpp"
+#include "engine.hpp"
+#include "filehandler.hpp"
+#include "memoryplanner.hpp"
+#include "pipeline.hpp"
+#include "rowformat.hpp"
+#include "simdkernel.hpp"
+#include "stats.hpp"
+
+namespace {
+    /**
+     * @brief Value of frame number frame out of frames on the way from first to last.
+     *
+     * The change is spread with rdiv, so the first and last frames get exactly first and last.
+     */
+    int32_t interpolate(const int32_t first, const int32_t last, const uint64_t frame, const uint64_t frames) {
+        if (frames < 2) {
+            return first;
+        }
+        const int64_t change = static_cast<int64_t>(last) - first;   /* |change| < 2^31 and frame < 2^20 */
+        return static_cast<int32_t>(first + kernel::detail::roundedDivide(change * static_cast<int64_t>(frame),
+                                                                          static_cast<int64_t>(frames - 1)));
+    }
+
+    kernel::ChannelRow interpolate(const kernel::ChannelRow& first, const kernel::ChannelRow& last,
+                                   const uint64_t frame, const uint64_t frames) {
+        return kernel::ChannelRow{interpolate(first.start, last.start, frame, frames),
+                                  interpolate(first.step, last.step, frame, frames)};
+    }
+
+    /**
+     * @brief Finds the "%d" or "%0<width>d" placeholder of a numbered output path.
+     *
+     * @return Position of the '%', or npos if there is none.
+     * @throws std::invalid_argument If the path contains any other '%' sequence.
+     */
+    size_t placeholderOf(const std::string& pattern, size_t& length) {
+        const size_t position = pattern.find('%');
+        if (position == std::string::npos) {
+            return position;
+        }
+        size_t end = position + 1;
+        while (end < pattern.size() && pattern[end] >= '0' && pattern[end] <= '9' && end - position <= 2) {
+            end++;
+        }
+        /* Either "%d" or a '0' followed by the width */
+        const bool padded = end == position + 1 || (end == position + 3 && pattern[position + 1] == '0');
+        if (!padded || end >= pattern.size() || pattern[end] != 'd' || pattern.find('%', end) != std::string::npos) {
+            throw std::invalid_argument("Output path may only contain a single %d or %0Nd placeholder: " + pattern);
+        }
+        length = end + 1 - position;
+        return position;
+    }
+}
+
+/**
+ * @brief Computes the setups of every row in the first and the last frame.
+ *
+ * @param args Parsed arguments; the positional colors are the start corners and --to the end corners.
+ * @param pool Thread pool rendering the frames.
+ * @throws std::invalid_argument If the gradient is not bilinear or the output path is malformed.
+ */
+AnimationRunner::AnimationRunner(const std::shared_ptr<ArgParser>& args, ThreadPool& pool)
+    : args(args), pool(pool), width(args->getImageWidth()), height(args->getImageHeight()),
+      frames(args->getFrameCount()), rows(height) {
+    if (args->getInterpolationType() != InterpolationType::BILINEAR) {
+        throw std::invalid_argument("Animations move the four corners of the bilinear gradient only");
+    }
+    if (args->getOutputFormat() == OutputFormat::RLE || args->getOutputFormat() == OutputFormat::TILED) {
+        throw std::invalid_argument("Animations are written in the text or raw format");
+    }
+    static_cast<void>(isNumbered(args->getOutputPath()));   /* Rejects malformed placeholders before rendering */
+
+    const std::vector<Pixel> end = args->getEndCorners();
+    const kernel::BilinearKernel first(width, height, args->getTopLeft(), args->getTopRight(),
+                                       args->getBottomLeft(), args->getBottomRight());
+    const kernel::BilinearKernel last(width, height, end[0], end[1], end[2], end[3]);
+
+    pool.parallelFor(height, 4096, [this, &first, &last](const size_t begin, const size_t stop) {
+        for (size_t y = begin; y < stop; y++) {
+            rows[y] = RowMotion{first.setupRow(y), last.setupRow(y)};
+        }
+    });
+}
+
+/**
+ * @brief Renders the frame chosen with select(), the first one until then.
+ */
+AnimationRunner::FrameInterpolation::FrameInterpolation(const AnimationRunner& animation)
+    : Interpolation(animation.args->getParameters()), animation(animation) {}
+
+/**
+ * @brief Renders row y of the frame from the row's setups in the first and last frame.
+ */
+void AnimationRunner::FrameKernel::renderRow(const ImageHeight y, Pixel* out) const {
+    const RowMotion& motion = animation.rows[y];
+    const uint64_t frames = animation.frames;
+    const kernel::RowSetup setup{interpolate(motion.first.red, motion.last.red, frame, frames),
+                                 interpolate(motion.first.green, motion.last.green, frame, frames),
+                                 interpolate(motion.first.blue, motion.last.blue, frame, frames)};
+    kernel::renderRowSimd(setup, out, animation.width);
+}
+
+/**
+ * @brief Renders and writes every frame.
+ */
+void AnimationRunner::run() {
+    const auto start = std::chrono::steady_clock::now();
+    writeFrames(isNumbered(args->getOutputPath()));
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double pixels = static_cast<double>(width) * static_cast<double>(height) * static_cast<double>(frames);
+    char message[160];
+    std::snprintf(message, sizeof(message), "Rendered %llu frames in %.3f s (%.1f frames/s, %.2f Mpixel/s)",
+                  static_cast<unsigned long long>(frames), elapsed.count(),
+                  static_cast<double>(frames) / std::max(elapsed.count(), 1e-9), pixels / std::max(elapsed.count(), 1e-9) / 1e6);
+    display::verbose(message);
+    if (args->getMaxMemoryBytes() != 0) {
+        const uint64_t peak = stats::peakResidentBytes();
+        display::error("Peak memory: " + (peak != 0 ? planner::mebibytes(peak) : std::string("unknown")) + " of "
+                       + planner::mebibytes(args->getMaxMemoryBytes()));
+    }
+}
+
+/**
+ * @brief Encodes the frames a window at a time and writes them in order.
+ *
+ * A window holds as many frames as fit in bufferedFrameBytes, or in what --max-memory leaves
+ * next to the output buffers. Its frames are spread over the pool, one frame per task; a window
+ * of one frame spreads its rows instead. Frames larger than the window are streamed.
+ *
+ * @param numbered Write every frame to its own file instead of one concatenated output.
+ * @throws std::ios_base::failure If an output file cannot be written.
+ * @throws std::runtime_error If a frame cannot be written within --max-memory.
+ */
+void AnimationRunner::writeFrames(const bool numbered) {
+    engine::withEncoding(FrameKernel(*this, 0), args->getOutputFormat(), [this, numbered](const auto& probe) {
+        using FrameEngine = std::remove_cvref_t<decltype(probe)>;
+        const OutputFormat format = args->getOutputFormat();
+        const size_t frameBytes = probe.imageBytes();
+        const uint64_t budget = args->getMaxMemoryBytes();
+        const uint64_t baseline = budget != 0 ? stats::peakResidentBytes() : 0;
+        const uint64_t outputBytes = output::Backend::poolBytes(output::Backend::defaultBufferBytes,
+                                                                rowformat::rowBytes(format, width));
+        uint64_t windowBytes = bufferedFrameBytes;
+        if (budget != 0) {
+            windowBytes = std::min<uint64_t>(windowBytes, budget > baseline + outputBytes ? budget - baseline - outputBytes : 0);
+        }
+        const uint64_t pixelBytes = Framebuffer::strideFor(width) * height * sizeof(Pixel);
+        if (args->isStreaming() || pixelBytes > planner::inMemoryLimit || frameBytes > windowBytes) {
+            streamFrames(numbered, baseline);
+            return;
+        }
+
+        const size_t window = static_cast<size_t>(std::clamp<uint64_t>(
+            windowBytes / std::max<size_t>(frameBytes, 1), 1, std::min<uint64_t>(frames, maxWindowFrames)));
+        const std::string plan = std::to_string(window) + " frames per window, estimated "
+                                 + planner::mebibytes(baseline + window * frameBytes + outputBytes);
+        if (budget != 0) {
+            display::error("Plan: " + plan + " of " + planner::mebibytes(budget));
+        } else {
+            display::verbose("Plan: " + plan);
+        }
+        std::vector<char> encoded(window * frameBytes);
+
+        FileHandler fileHandler;
+        if (!numbered) {
+            fileHandler.open(args->getOutputPath(), format, {}, args->getIoBackend());
+        }
+        for (uint64_t first = 0; first < frames; first += window) {
+            const size_t count = static_cast<size_t>(std::min<uint64_t>(window, frames - first));
+            {
+                const stats::Scope timing(stats::Stage::GENERATE, stats::Scope::WALL);
+                if (count == 1) {
+                    FrameEngine(FrameKernel(*this, first)).encodeImage(pool, encoded.data());   /* Counts its pixels */
+                } else {
+                    stats::addPixels(width * height * count);
+                    pool.parallelFor(count, 1, [this, &encoded, first, frameBytes](const size_t begin, const size_t end) {
+                        std::vector<Pixel> scratch(width);
+                        for (size_t index = begin; index < end; index++) {
+                            FrameEngine(FrameKernel(*this, first + index))
+                                .encodeRows(0, height, encoded.data() + index * frameBytes, scratch.data());
+                        }
+                    });
+                }
+            }
+
+            if (!numbered) {
+                fileHandler.writeEncoded({encoded.data(), count * frameBytes});
+            }
+            for (size_t index = 0; numbered && index < count; index++) {
+                fileHandler.open(frameName(args->getOutputPath(), first + index), format, {}, args->getIoBackend());
+                fileHandler.writeEncoded({encoded.data() + index * frameBytes, frameBytes});
+                fileHandler.finish();
+            }
+        }
+        fileHandler.finish();
+    });
+}
+
+/**
+ * @brief Generates and writes the frames one at a time through a StreamingPipeline.
+ *
+ * The pipeline's blocks and output buffers are planned like those of a single streamed image
+ * (memoryplanner.hpp), so frames of any size stay within --max-memory. One pipeline and its
+ * blocks serve every frame.
+ *
+ * @param numbered Write every frame to its own file instead of one concatenated output.
+ * @param baseline Memory the process held before the frames, counted against the budget.
+ * @throws std::ios_base::failure If an output file cannot be written.
+ * @throws std::runtime_error If the pipeline does not fit into --max-memory.
+ */
+void AnimationRunner::streamFrames(const bool numbered, const uint64_t baseline) {
+    planner::Request request;
+    request.width = width;
+    request.height = height;
+    request.format = args->getOutputFormat();
+    request.streaming = true;
+    request.budget = args->getMaxMemoryBytes();
+    request.baseline = baseline;
+    const planner::Plan plan = planner::plan(request);
+    if (request.budget != 0) {
+        display::error("Plan: " + planner::describe(plan) + " per frame of " + planner::mebibytes(request.budget));
+    } else {
+        display::verbose("Plan: " + planner::describe(plan) + " per frame");
+    }
+
+    FileHandler fileHandler;
+    if (!numbered) {
+        fileHandler.open(args->getOutputPath(), request.format, {}, args->getIoBackend(), plan.bufferBytes);
+    }
+    FrameInterpolation interpolation(*this);
+    StreamingPipeline pipeline(interpolation, fileHandler, pool, plan.blockRows, plan.ringSize);
+    for (uint64_t frame = 0; frame < frames; frame++) {
+        if (numbered) {
+            fileHandler.open(frameName(args->getOutputPath(), frame), request.format, {}, args->getIoBackend(), plan.bufferBytes);
+        }
+        interpolation.select(frame);
+        pipeline.run(width, height, numbered);
+    }
+    fileHandler.finish();
+}
+
+/**
+ * @brief Tells whether an output path selects numbered frame files.
+ *
+ * @throws std::invalid_argument If the path contains a malformed placeholder.
+ */
+bool AnimationRunner::isNumbered(const std::string& pattern) {
+    size_t length = 0;
+    return placeholderOf(pattern, length) != std::string::npos;
+}
+
+/**
+ * @brief Substitutes the frame number into a numbered output path.
+ *
+ * @param pattern Output path with a "%d" or "%0<width>d" placeholder.
+ * @param frame Frame number, starting at 0.
+ * @return The path of the frame file.
+ */
+std::string AnimationRunner::frameName(const std::string& pattern, const uint64_t frame) {
+    size_t length = 0;
+    const size_t position = placeholderOf(pattern, length);
+    std::string number = std::to_string(frame);
+    if (length > 2 && pattern[position + 1] == '0') {
+        const auto digits = static_cast<size_t>(std::stoul(pattern.substr(position + 2, length - 3)));
+        number.insert(0, digits > number.size() ? digits - number.size() : 0, '0');
+    }
+    return pattern.substr(0, position) + number + pattern.substr(position + length);
+}
@@ -0,0 +1,87 @@
+/**
+ * @file animation.hpp
+ * @brief Defines the AnimationRunner class, which renders a sequence of frames with moving corner colors.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "argparser.hpp"
+#include "bilinearkernel.hpp"
+#include "interpolation.hpp"
+#include "threadpool.hpp"
+#include "types.hpp"
+
+/**
+ * @class AnimationRunner
+ * @brief Renders --frames bilinear frames whose corners move linearly from the positional
+ * colors to the --to colors.
+ *
+ * The fixed-point row setup of a frame is linear in its corner colors, so each row moves by
+ * a fixed per-row delta from the first frame to the last one. Both setups are computed once
+ * per row; a frame then spreads the delta with one multiply and rounded divide per value
+ * and row instead of redoing the corner setup, and frames render in any order on any thread
+ * with identical results. The first and last frames are bit-identical to the single images
+ * of the start and end corners.
+ *
+ * Frames are written to numbered files when the output path contains a printf-style
+ * placeholder ("frame_%04d.raw"), otherwise they are concatenated into one file or stream.
+ * Frames are encoded in memory a window at a time; a frame too large for the window, or
+ * whose framebuffer exceeds planner::inMemoryLimit, is streamed block by block through a
+ * StreamingPipeline instead. --max-memory bounds the window and plans the pipeline.
+ */
+class AnimationRunner {
+public:
+    AnimationRunner(const std::shared_ptr<ArgParser>& args, ThreadPool& pool);
+    ~AnimationRunner() = default;
+
+    void run();
+
+    [[nodiscard]] static bool isNumbered(const std::string& pattern);
+    [[nodiscard]] static std::string frameName(const std::string& pattern, uint64_t frame);
+private:
+    /* Setup of one row in the first and the last frame */
+    struct RowMotion {
+        kernel::RowSetup first;
+        kernel::RowSetup last;
+    };
+
+    /* Row kernel of one frame, see engine.hpp */
+    class FrameKernel {
+    public:
+        FrameKernel(const AnimationRunner& animation, uint64_t frame) : animation(animation), frame(frame) {}
+        void renderRow(ImageHeight y, Pixel* out) const;
+        [[nodiscard]] ImageWidth width() const { return animation.width; }
+        [[nodiscard]] ImageHeight height() const { return animation.height; }
+    private:
+        const AnimationRunner& animation;
+        uint64_t frame;
+    };
+
+    /* The selected frame as an Interpolation, for the StreamingPipeline */
+    class FrameInterpolation : public Interpolation {
+    public:
+        explicit FrameInterpolation(const AnimationRunner& animation);
+        void renderRow(ImageHeight y, Pixel* out) const override { FrameKernel(animation, frame).renderRow(y, out); }
+        void select(const uint64_t frame) { this->frame = frame; }
+    private:
+        const AnimationRunner& animation;
+        uint64_t frame = 0;
+    };
+
+    void writeFrames(bool numbered);
+    void streamFrames(bool numbered, uint64_t baseline);
+
+    static constexpr size_t bufferedFrameBytes = 256 * 1024 * 1024;   /* Encoded frames held at once */
+    static constexpr uint64_t maxWindowFrames = 4096;                 /* Upper bound of frames per window */
+
+    std::shared_ptr<ArgParser> args;
+    ThreadPool& pool;
+    ImageWidth width;
+    ImageHeight height;
+    uint64_t frames;
+    std::vector<RowMotion> rows;
+};
@@ -0,0 +1,273 @@
+/**
+ * @file verifier.cpp
+ * @brief Implements the Verifier class.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "verifier.hpp"
+#include "compactformat.hpp"
+#include "display.hpp"
+#include "filereader.hpp"
+#include "rowformat.hpp"
+#include "stats.hpp"
+#include "tiledformat.hpp"
+
+namespace {
+    std::string hex(const Pixel pixel) {
+        char text[8];
+        std::snprintf(text, sizeof(text), "0x%04x", pixel);
+        return text;
+    }
+}
+
+/**
+ * @brief Prepares the verification of the file at the output path.
+ *
+ * @param args Parameters the file was generated from.
+ * @param interpolator Interpolation rendering the expected rows.
+ * @param pool Thread pool checking the rows.
+ */
+Verifier::Verifier(const std::shared_ptr<ArgParser>& args, const Interpolation& interpolator, ThreadPool& pool)
+    : args(args), interpolator(interpolator), pool(pool) {}
+
+/**
+ * @brief Checks the file and reports the outcome.
+ *
+ * @return True if the file holds exactly the expected image.
+ * @throws std::ios_base::failure If the file cannot be read.
+ */
+bool Verifier::run() {
+    const auto start = std::chrono::steady_clock::now();
+    const OutputFormat format = args->getOutputFormat();
+    const std::string problem = format == OutputFormat::RLE ? checkCompact()
+                              : format == OutputFormat::TILED ? checkTiled() : checkMapped();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (!problem.empty()) {
+        display::error("Verification of " + args->getOutputPath() + " failed: " + problem);
+        return false;
+    }
+    const Region region = args->getRegion();
+    char message[160];
+    std::snprintf(message, sizeof(message), "Verified %llu x %llu pixels in %.3f s",
+                  static_cast<unsigned long long>(region.width), static_cast<unsigned long long>(region.height),
+                  elapsed.count());
+    display::info(std::string(message) + ", " + args->getOutputPath() + " matches");
+    return true;
+}
+
+/**
+ * @brief Checks a text or raw file through a memory mapping, bands of rows in parallel.
+ *
+ * Bands past the first mismatch found so far are skipped.
+ *
+ * @return Description of the first problem, empty if the file matches.
+ */
+std::string Verifier::checkMapped() {
+    const OutputFormat format = args->getOutputFormat();
+    const ImageWidth width = args->getRegion().width;
+    const ImageHeight height = args->getRegion().height;
+    const FileReader reader(args->getOutputPath());
+    const size_t rowBytes = rowformat::rowBytes(format, width);
+    const ImageHeight rows = rowBytes == 0 ? height : std::min<ImageHeight>(height, reader.size() / rowBytes);
+
+    Mismatch first;
+    std::mutex firstMutex;
+    std::atomic<ImageHeight> firstRow{UINT64_MAX};
+    pool.parallelFor(rows, rowsPerTask, [&](const size_t begin, const size_t end) {
+        std::vector<Pixel> expected(width), found(width);
+        for (size_t line = begin; line < end && line < firstRow.load(std::memory_order_relaxed); line++) {
+            {
+                const stats::Scope timing(stats::Stage::GENERATE);
+                interpolator.renderRow(height - 1 - line, expected.data());
+            }
+            ImageWidth valid = 0;
+            {
+                const stats::Scope timing(stats::Stage::DECODE);
+                valid = reader.decodeRow(format, width, line, found.data());
+            }
+            const ImageWidth checked = std::min(valid, width);
+            const auto differs = std::mismatch(expected.begin(), expected.begin() + static_cast<ptrdiff_t>(checked), found.begin());
+            const auto column = static_cast<ImageWidth>(differs.first - expected.begin());
+            if (column == checked && valid == width) {
+                continue;
+            }
+            const std::lock_guard lock(firstMutex);
+            if (line < first.row) {
+                const bool malformed = column == checked;
+                first = Mismatch{line, column, column < width ? expected[column] : Pixel{0},
+                                 malformed ? Pixel{0} : found[column], malformed};
+                firstRow.store(line, std::memory_order_relaxed);
+            }
+            return;
+        }
+    });
+    stats::addPixels(width * rows);
+
+    if (first.row != UINT64_MAX) {
+        return describe(first);
+    }
+    const size_t expectedBytes = rowformat::imageBytes(format, width, height);
+    if (reader.size() != expectedBytes) {
+        return "the file has " + std::to_string(reader.size()) + " bytes, expected " + std::to_string(expectedBytes)
+               + " (" + std::to_string(rows) + " of " + std::to_string(height) + " rows complete)";
+    }
+    return {};
+}
+
+/**
+ * @brief Checks a compact file, decoding it as a stream.
+ *
+ * @return Description of the first problem, empty if the file matches.
+ */
+std::string Verifier::checkCompact() {
+    const std::string& path = args->getOutputPath();
+    std::ifstream file;
+    if (path != FileReader::standardInput) {
+        file.open(path, std::ios::in | std::ios::binary);
+        if (!file.is_open()) {
+            throw std::ios_base::failure("Could not open file with following path: " + path);
+        }
+    }
+    std::istream& input = path == FileReader::standardInput ? std::cin : file;
+
+    const ImageWidth width = args->getRegion().width;
+    const ImageHeight height = args->getRegion().height;
+    ImageHeight line = 0;
+    std::unique_ptr<compact::Decoder> decoder;
+    try {
+        decoder = std::make_unique<compact::Decoder>(input);
+        const compact::Header& header = decoder->header();
+        const compact::Header expectedHeader = compact::headerFor(args->getParameters());
+        if (header.width != width || header.height != height) {
+            return "the header describes " + std::to_string(header.width) + " x " + std::to_string(header.height)
+                   + " pixels, expected " + std::to_string(width) + " x " + std::to_string(height);
+        }
+        if (header.tl != expectedHeader.tl || header.tr != expectedHeader.tr
+            || header.bl != expectedHeader.bl || header.br != expectedHeader.br) {
+            return "the header holds different corner colors";
+        }
+
+        std::vector<Pixel> expected(width), found(width);
+        for (; line < height; line++) {
+            {
+                const stats::Scope timing(stats::Stage::DECODE);
+                if (!decoder->readRow(found.data())) {
+                    return "the file ends after " + std::to_string(line) + " of " + std::to_string(height) + " rows";
+                }
+            }
+            {
+                const stats::Scope timing(stats::Stage::GENERATE);
+                interpolator.renderRow(height - 1 - line, expected.data());
+            }
+            const auto differs = std::mismatch(expected.begin(), expected.end(), found.begin());
+            if (differs.first != expected.end()) {
+                const auto column = static_cast<ImageWidth>(differs.first - expected.begin());
+                return describe(Mismatch{line, column, expected[column], found[column], false});
+            }
+        }
+    } catch (const std::runtime_error& e) {
+        return std::string(e.what()) + " (row " + std::to_string(line) + ")";
+    }
+    stats::addPixels(width * height);
+    if (!decoder->atEnd()) {
+        return "the file continues after the last row";
+    }
+    return {};
+}
+
+/**
+ * @brief Checks a tiled file, one row of tiles at a time.
+ *
+ * The expected rows of a tile row are rendered once, then its tiles are decoded and compared
+ * in parallel. Tiles are found through the index, so payloads the index does not reach are
+ * not looked at.
+ *
+ * @return Description of the first problem, empty if the file matches.
+ */
+std::string Verifier::checkTiled() {
+    const ImageWidth width = args->getRegion().width;
+    const ImageHeight height = args->getRegion().height;
+    std::unique_ptr<tiled::Reader> reader;
+    try {
+        reader = std::make_unique<tiled::Reader>(args->getOutputPath());
+    } catch (const std::runtime_error& e) {
+        return e.what();
+    }
+    const tiled::Header& header = reader->header();
+    const tiled::Header expectedHeader = tiled::headerFor(args->getParameters(), header.tileWidth);
+    if (header.width != width || header.height != height) {
+        return "the header describes " + std::to_string(header.width) + " x " + std::to_string(header.height)
+               + " pixels, expected " + std::to_string(width) + " x " + std::to_string(height);
+    }
+    if (header.tl != expectedHeader.tl || header.tr != expectedHeader.tr
+        || header.bl != expectedHeader.bl || header.br != expectedHeader.br) {
+        return "the header holds different corner colors";
+    }
+
+    ResultGradient expected(width, std::min<ImageHeight>(header.tileHeight, height));
+    for (uint64_t tileRow = 0; tileRow < header.tileRows(); tileRow++) {
+        const ImageHeight top = tileRow * header.tileHeight;
+        const ImageHeight rows = std::min<ImageHeight>(header.tileHeight, height - top);
+        {
+            const stats::Scope timing(stats::Stage::GENERATE);
+            interpolator.renderRows(height - top - rows, rows, expected.row(0), expected.stride());
+        }
+
+        Mismatch first;
+        std::mutex firstMutex;
+        try {
+            pool.parallelFor(header.tileColumns(), 1, [&](const size_t begin, const size_t end) {
+                std::vector<Pixel> found(static_cast<size_t>(header.tileWidth) * header.tileHeight);
+                for (size_t column = begin; column < end; column++) {
+                    const Region tile = header.tile(column, tileRow);
+                    {
+                        const stats::Scope timing(stats::Stage::DECODE);
+                        reader->readTile(column, tileRow, found.data(), tile.width);
+                    }
+                    for (ImageHeight y = 0; y < tile.height; y++) {
+                        const Pixel* want = expected.row(rows - 1 - y) + tile.x;
+                        const Pixel* have = found.data() + y * tile.width;
+                        const auto differs = std::mismatch(want, want + tile.width, have);
+                        if (differs.first == want + tile.width) {
+                            continue;
+                        }
+                        const auto x = static_cast<ImageWidth>(differs.first - want);
+                        const std::lock_guard lock(firstMutex);
+                        const ImageHeight line = top + y;
+                        if (line < first.row || (line == first.row && tile.x + x < first.column)) {
+                            first = Mismatch{line, tile.x + x, *differs.first, *differs.second, false};
+                        }
+                        break;
+                    }
+                }
+            });
+        } catch (const std::runtime_error& e) {
+            return e.what();
+        }
+        stats::addPixels(width * rows);
+        if (first.row != UINT64_MAX) {
+            return describe(first);
+        }
+    }
+    return {};
+}
+
+/**
+ * @brief Describes a mismatch for the error message.
+ */
+std::string Verifier::describe(const Mismatch& mismatch) {
+    const std::string where = "row " + std::to_string(mismatch.row) + " (from the top), column " + std::to_string(mismatch.column);
+    if (mismatch.malformed) {
+        return "malformed pixel at " + where + ", expected " + hex(mismatch.expected);
+    }
+    return "first mismatch at " + where + ": expected " + hex(mismatch.expected) + ", found " + hex(mismatch.found);
+}
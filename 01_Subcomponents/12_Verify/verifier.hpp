@@ -0,0 +1,53 @@
+/**
+ * @file verifier.hpp
+ * @brief Defines the Verifier class, which checks an existing file against the parameters it was generated from.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "argparser.hpp"
+#include "interpolation.hpp"
+#include "threadpool.hpp"
+#include "types.hpp"
+
+/**
+ * @class Verifier
+ * @brief Compares the file at the output path with the image its arguments describe (--verify).
+ *
+ * Text and raw files are memory-mapped and checked in row bands spread over the thread pool:
+ * each band renders its expected rows and decodes the file rows next to them, so nothing
+ * larger than a row is held per thread and the check runs at the speed the file can be read.
+ * Compact files are decoded as a stream. Tiled files are checked a row of tiles at a time,
+ * the tiles of a row in parallel. The first mismatching pixel in file order (image order for
+ * tiled files) is reported, or a malformed pixel, or a file that is too short or too long.
+ */
+class Verifier {
+public:
+    Verifier(const std::shared_ptr<ArgParser>& args, const Interpolation& interpolator, ThreadPool& pool);
+    ~Verifier() = default;
+
+    [[nodiscard]] bool run();
+private:
+    /* First difference found, in file order; row 0 is the top row */
+    struct Mismatch {
+        ImageHeight row = UINT64_MAX;
+        ImageWidth column = 0;
+        Pixel expected = 0;
+        Pixel found = 0;
+        bool malformed = false;
+    };
+
+    [[nodiscard]] std::string checkMapped();
+    [[nodiscard]] std::string checkCompact();
+    [[nodiscard]] std::string checkTiled();
+    [[nodiscard]] static std::string describe(const Mismatch& mismatch);
+
+    static constexpr size_t rowsPerTask = 64;   /* Rows checked by one parallel task */
+
+    std::shared_ptr<ArgParser> args;
+    const Interpolation& interpolator;
+    ThreadPool& pool;
+};
@@ -0,0 +1,86 @@
+/**
+ * @file gradientcore.cpp
+ * @brief Implements the public API of the gradient_core library.
+ */
+
+#include "gradientcore.hpp"
+#include "interpolation.hpp"
+
+/**
+ * @brief Describes a Status in words.
+ */
+const char* gradient::toString(const Status status) noexcept {
+    switch (status) {
+    case Status::OK:
+        return "ok";
+    case Status::ROWS_OUT_OF_RANGE:
+        return "rows out of range";
+    case Status::STRIDE_TOO_SMALL:
+        return "stride smaller than the width";
+    case Status::BUFFER_TOO_SMALL:
+        return "buffer too small";
+    }
+    return "unknown status";
+}
+
+/**
+ * @brief Checks the parameters and prepares the kernel, sampling the color stops once.
+ *
+ * @param parameters Image size, colors, gradient type and region.
+ * @throws std::invalid_argument If the parameters are out of range (Parameters::validate).
+ * @throws std::bad_alloc If the kernel tables cannot be allocated.
+ */
+gradient::Renderer::Renderer(const Parameters& parameters)
+    : interpolation(InterpolationFactory::get(parameters)), output(parameters.output()) {}
+
+/**
+ * @brief Renders the whole image (or region) into pixels.
+ *
+ * @param pixels Destination, at least (height() - 1) * stride + width() pixels.
+ * @param stride Distance between the first pixels of consecutive rows, in pixels.
+ * @return Status::OK, or the reason nothing was written.
+ */
+gradient::Status gradient::Renderer::render(const std::span<uint16_t> pixels, const size_t stride) const noexcept {
+    return renderRows(0, output.height, pixels, stride);
+}
+
+/**
+ * @brief Renders count rows starting at row first, counted from the top, into pixels.
+ *
+ * The first requested row lands at pixels[0]. The buffer is checked before anything is
+ * written, so a call either renders every row or leaves the buffer untouched. Different row
+ * ranges may be rendered concurrently from several threads.
+ *
+ * @param first Index of the first row, 0 being the top row.
+ * @param count Number of rows.
+ * @param pixels Destination, at least (count - 1) * stride + width() pixels.
+ * @param stride Distance between the first pixels of consecutive rows, in pixels.
+ * @return Status::OK, or the reason nothing was written.
+ */
+gradient::Status gradient::Renderer::renderRows(const ImageHeight first, const ImageHeight count,
+                                                const std::span<uint16_t> pixels, const size_t stride) const noexcept {
+    if (first > output.height || count > output.height - first) {
+        return Status::ROWS_OUT_OF_RANGE;
+    }
+    if (count == 0 || output.width == 0) {
+        return Status::OK;
+    }
+    if (stride < output.width) {
+        return Status::STRIDE_TOO_SMALL;
+    }
+    if (pixels.size() < output.width || (count - 1) > (pixels.size() - output.width) / stride) {
+        return Status::BUFFER_TOO_SMALL;
+    }
+
+    /* Rows that are all the same are rendered once and copied; the bottom-up order does not matter then */
+    if (rowsIdentical(interpolation->shape())) {
+        interpolation->renderRows(output.height - first - count, count, pixels.data(), stride);
+        return Status::OK;
+    }
+
+    /* Interpolations count rows from the bottom */
+    for (ImageHeight row = 0; row < count; row++) {
+        interpolation->renderRow(output.height - 1 - (first + row), pixels.data() + row * stride);
+    }
+    return Status::OK;
+}
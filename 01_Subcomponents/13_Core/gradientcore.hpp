@@ -0,0 +1,70 @@
+/**
+ * @file gradientcore.hpp
+ * @brief Declares the public API of the gradient_core library.
+ *
+ * The library renders gradients into buffers owned by the caller. Everything that allocates or
+ * may throw happens once, when a Renderer is constructed; render() and renderRows() neither
+ * allocate nor throw and report misuse through a Status. The command line program is built on
+ * the same library.
+ *
+ * @code
+ * gradient::Parameters parameters;
+ * parameters.width = 640;
+ * parameters.height = 480;
+ * parameters.tl = 0xf800; parameters.tr = 0x07e0; parameters.bl = 0x001f; parameters.br = 0xffff;
+ * const gradient::Renderer renderer(parameters);
+ *
+ * std::vector<uint16_t> pixels(640 * 480);
+ * const gradient::Status status = renderer.render(pixels, 640);
+ * @endcode
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include "parameters.hpp"
+#include "types.hpp"
+
+class Interpolation;
+
+namespace gradient {
+    /**
+     * @enum Status
+     * @brief Outcome of a render call.
+     */
+    enum class Status {
+        OK,
+        ROWS_OUT_OF_RANGE,      /* first + count exceeds the height of the rendered region */
+        STRIDE_TOO_SMALL,       /* The stride is below the width of the rendered region */
+        BUFFER_TOO_SMALL        /* The buffer cannot hold the requested rows at the given stride */
+    };
+
+    [[nodiscard]] const char* toString(Status status) noexcept;
+
+    /**
+     * @class Renderer
+     * @brief Renders the image described by a Parameters object into caller-provided buffers.
+     *
+     * Rows are written top row first, as in the output files; pixels are packed RGB565. With a
+     * region only that rectangle is rendered, and rows and columns count from its top-left corner.
+     * A Renderer is immutable, so several threads may render different rows at the same time.
+     */
+    class Renderer {
+    public:
+        explicit Renderer(const Parameters& parameters);
+
+        [[nodiscard]] ImageWidth width() const noexcept { return output.width; }
+        [[nodiscard]] ImageHeight height() const noexcept { return output.height; }
+
+        [[nodiscard]] Status render(std::span<uint16_t> pixels, size_t stride) const noexcept;
+        [[nodiscard]] Status renderRows(ImageHeight first, ImageHeight count,
+                                        std::span<uint16_t> pixels, size_t stride) const noexcept;
+
+    private:
+        std::shared_ptr<const Interpolation> interpolation;
+        Region output;
+    };
+}
@@ -0,0 +1,165 @@
+/**
+ * @file memoryplanner.cpp
+ * @brief Implements the memory planner of single images.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include "memoryplanner.hpp"
+#include "framebuffer.hpp"
+#include "pipeline.hpp"
+#include "rowformat.hpp"
+#include "tiledformat.hpp"
+
+namespace {
+    /* Output buffers and per-file state of FileHandler */
+    uint64_t outputBytes(const planner::Request& request, const size_t bufferBytes) {
+        const size_t rowBytes = rowformat::rowBytes(request.format, request.width);
+        const uint64_t previousRow = request.format == OutputFormat::RLE ? request.width * sizeof(Pixel) : 0;
+        return output::Backend::poolBytes(bufferBytes, rowBytes) + previousRow;
+    }
+
+    uint64_t rowPixelBytes(const ImageWidth width) {
+        return std::max<uint64_t>(Framebuffer::strideFor(width) * sizeof(Pixel), 1);
+    }
+
+    /* One band of tile rows, the encoded tiles of the band (never larger than the band) and the index */
+    uint64_t tiledBytes(const planner::Request& request) {
+        tiled::Header header;
+        header.width = request.width;
+        header.height = request.height;
+        header.tileWidth = header.tileHeight = request.tileSize;
+        const uint64_t band = rowPixelBytes(request.width) * std::min<uint64_t>(request.tileSize, request.height);
+        return 2 * band + header.tileCount() * (sizeof(tiled::Entry) + tiled::entryBytes) + tiled::headerBytes;
+    }
+
+    planner::Plan streamingPlan(const planner::Request& request, const size_t ringSize, const size_t blockRows,
+                                const size_t bufferBytes) {
+        planner::Plan plan;
+        plan.strategy = planner::Strategy::STREAMING;
+        plan.ringSize = ringSize;
+        plan.blockRows = std::min<size_t>(blockRows, std::max<ImageHeight>(request.height, 1));
+        plan.bufferBytes = bufferBytes;
+        plan.estimatedBytes = request.baseline + ringSize * plan.blockRows * rowPixelBytes(request.width)
+                              + outputBytes(request, bufferBytes);
+        return plan;
+    }
+
+    bool fits(const planner::Request& request, const uint64_t bytes) {
+        return request.budget == 0 || bytes <= request.budget;
+    }
+
+    [[noreturn]] void tooSmall(const planner::Request& request, const uint64_t needed, const std::string& hint) {
+        throw std::runtime_error("--max-memory " + planner::mebibytes(request.budget) + " is below the "
+                                 + planner::mebibytes(needed) + " needed to write the image" + hint);
+    }
+
+    /*
+     * Streaming with the default buffers if they fit. Otherwise a quarter of the memory left goes
+     * to the output buffers and the rest to the ring, which gives up its spare blocks before
+     * its blocks get shorter than a row.
+     */
+    planner::Plan planStreaming(const planner::Request& request) {
+        const size_t defaultRows = StreamingPipeline::blockRowsFor(request.width);
+        planner::Plan plan = streamingPlan(request, StreamingPipeline::defaultRingSize, defaultRows,
+                                           output::Backend::defaultBufferBytes);
+        if (fits(request, plan.estimatedBytes)) {
+            return plan;
+        }
+
+        const uint64_t available = request.budget > request.baseline ? request.budget - request.baseline : 0;
+        const size_t bufferBytes = static_cast<size_t>(std::clamp<uint64_t>(available / 4 / output::Backend::bufferCount,
+                                                                            output::Backend::minimumBufferBytes,
+                                                                            output::Backend::defaultBufferBytes));
+        const uint64_t output = outputBytes(request, bufferBytes);
+        for (const size_t ringSize : {StreamingPipeline::defaultRingSize, size_t{2}}) {
+            const uint64_t blockBytes = available > output ? (available - output) / ringSize : 0;
+            const uint64_t rows = std::min<uint64_t>(blockBytes / rowPixelBytes(request.width), defaultRows);
+            if (rows > 0) {
+                return streamingPlan(request, ringSize, static_cast<size_t>(rows), bufferBytes);
+            }
+        }
+        tooSmall(request, streamingPlan(request, 2, 1, output::Backend::minimumBufferBytes).estimatedBytes, "");
+    }
+}
+
+/**
+ * @brief Chooses the writer of an image and sizes its buffers.
+ *
+ * The tiled format always uses the tiled writer, and --mmap the mmap writer when the mapped
+ * file fits. Otherwise the image is generated in memory unless --stream was given, the
+ * framebuffer is larger than inMemoryLimit or it does not fit, and streamed in blocks
+ * sized to fit if not.
+ *
+ * @param request Image and options; without a budget the default buffer sizes are used.
+ * @return The plan, whose estimate stays within the budget.
+ * @throws std::runtime_error If no writer fits into the budget.
+ */
+planner::Plan planner::plan(const Request& request) {
+    if (request.format == OutputFormat::TILED) {
+        Plan plan;
+        plan.strategy = Strategy::TILED;
+        plan.estimatedBytes = request.baseline + tiledBytes(request);
+        if (!fits(request, plan.estimatedBytes)) {
+            tooSmall(request, plan.estimatedBytes, ", try a smaller --tile-size");
+        }
+        return plan;
+    }
+
+    if (request.mapped) {
+        Plan plan;
+        plan.strategy = Strategy::MAPPED;
+        plan.estimatedBytes = request.baseline + rowformat::rowBytes(request.format, request.width) * request.height;
+        if (fits(request, plan.estimatedBytes)) {
+            return plan;
+        }
+    }
+
+    const uint64_t imageBytes = rowPixelBytes(request.width) * request.height;
+    if (!request.streaming && imageBytes <= inMemoryLimit) {
+        Plan plan;
+        plan.estimatedBytes = request.baseline + imageBytes + outputBytes(request, plan.bufferBytes);
+        if (fits(request, plan.estimatedBytes)) {
+            return plan;
+        }
+    }
+    return planStreaming(request);
+}
+
+/** @brief Returns the name of a strategy, as shown in the plan. */
+const char* planner::toString(const Strategy strategy) {
+    switch (strategy) {
+    case Strategy::STREAMING:
+        return "streaming";
+    case Strategy::MAPPED:
+        return "mmap";
+    case Strategy::TILED:
+        return "tiled";
+    default:
+        return "in-memory";
+    }
+}
+
+/**
+ * @brief Describes a plan in one line, e.g. "streaming, 4 blocks of 120 rows, 4 x 256 KiB output
+ * buffers, estimated 9.4 MiB".
+ */
+std::string planner::describe(const Plan& plan) {
+    std::string text = toString(plan.strategy);
+    if (plan.strategy == Strategy::STREAMING) {
+        text += ", " + std::to_string(plan.ringSize) + " blocks of " + std::to_string(plan.blockRows) + " rows";
+    }
+    if (plan.strategy == Strategy::STREAMING || plan.strategy == Strategy::IN_MEMORY) {
+        text += ", " + std::to_string(output::Backend::bufferCount) + " x " + std::to_string(plan.bufferBytes >> 10)
+                + " KiB output buffers";
+    }
+    return text + ", estimated " + mebibytes(plan.estimatedBytes);
+}
+
+/** @brief Formats a size in MiB with one decimal, e.g. "12.5 MiB". */
+std::string planner::mebibytes(const uint64_t bytes) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.1f MiB", static_cast<double>(bytes) / (1024.0 * 1024.0));
+    return text;
+}
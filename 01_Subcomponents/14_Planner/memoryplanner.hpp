@@ -0,0 +1,66 @@
+/**
+ * @file memoryplanner.hpp
+ * @brief Declares the planner choosing how a single image is written within a memory budget (--max-memory).
+ *
+ * Every writer holds a known amount of memory: the buffered writer the whole framebuffer, the
+ * streaming pipeline its ring of row blocks, the tiled writer one row of tiles and the mmap
+ * writer the dirty pages of the mapped file, each next to the buffers of its output backend.
+ * The planner estimates them with the formulas the writers size their buffers with, takes the
+ * first writer that fits and, for the streaming pipeline, shrinks the blocks and the output
+ * buffers until it does.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "outputbackend.hpp"
+#include "types.hpp"
+
+namespace planner {
+    static constexpr uint64_t inMemoryLimit = uint64_t{1} << 30;   /* Largest framebuffer generated in one piece */
+
+    /**
+     * @enum Strategy
+     * @brief Writer an image is generated with.
+     */
+    enum class Strategy {
+        IN_MEMORY,  /* Whole framebuffer, then FileHandler */
+        STREAMING,  /* StreamingPipeline, bounded ring of row blocks */
+        MAPPED,     /* MmapWriter (--mmap) */
+        TILED       /* tiled::Writer (--format tiled), one row of tiles */
+    };
+
+    /**
+     * @struct Request
+     * @brief Image to write and what the command line asks for.
+     */
+    struct Request {
+        ImageWidth width = 0;
+        ImageHeight height = 0;
+        OutputFormat format = OutputFormat::TEXT;
+        uint32_t tileSize = 0;
+        bool streaming = false;     /* --stream */
+        bool mapped = false;        /* --mmap, and the output can be mapped */
+        uint64_t budget = 0;        /* --max-memory in bytes, 0 for no limit */
+        uint64_t baseline = 0;      /* Memory the process already holds */
+    };
+
+    /**
+     * @struct Plan
+     * @brief Chosen writer, its buffer sizes and the memory it is expected to need.
+     */
+    struct Plan {
+        Strategy strategy = Strategy::IN_MEMORY;
+        size_t blockRows = 0;       /* Rows per block of the streaming pipeline */
+        size_t ringSize = 0;        /* Blocks of the streaming pipeline */
+        size_t bufferBytes = output::Backend::defaultBufferBytes;   /* Size of each output buffer */
+        uint64_t estimatedBytes = 0;    /* Including the baseline */
+    };
+
+    [[nodiscard]] Plan plan(const Request& request);
+    [[nodiscard]] const char* toString(Strategy strategy);
+    [[nodiscard]] std::string describe(const Plan& plan);
+    [[nodiscard]] std::string mebibytes(uint64_t bytes);
+}
@@ -0,0 +1,367 @@
+/**
+ * @file benchmark.cpp
+ * @brief Benchmark suite timing generation, row encoding and decoding and writing on their own and end to end.
+ *
+ * Runs every stage over a matrix of square sizes, corner patterns and gradient types, formats and thread counts
+ * and reports pixels and bytes per second together with the heap allocations of each run,
+ * counted through the stats module.
+ * Results can be written as JSON and compared against a previously saved JSON baseline.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "filehandler.hpp"
+#include "gradienttype.hpp"
+#include "hexdecoder.hpp"
+#include "interpolation.hpp"
+#include "rowformat.hpp"
+#include "simdkernel.hpp"
+#include "stats.hpp"
+#include "threadpool.hpp"
+#include "types.hpp"
+
+namespace {
+    /* Gradient type and corner colors: tl, tr, bl, br (the color stops of the non-bilinear types) */
+    struct Pattern {
+        const char* name;
+        const char* gradient;
+        Pixel corners[4];
+    };
+
+    const Pattern patterns[] = {
+        {"corners", "bilinear", {0xf800, 0x07e0, 0x001f, 0xffff}},
+        {"horizontal", "bilinear", {0x001f, 0xf800, 0x001f, 0xf800}},
+        {"vertical", "bilinear", {0xffff, 0xffff, 0x0000, 0x0000}},
+        {"solid", "bilinear", {0x7bef, 0x7bef, 0x7bef, 0x7bef}},
+        {"linear", "linear", {0xf800, 0x07e0, 0x001f, 0xffff}},
+        {"radial", "radial", {0xf800, 0x07e0, 0x001f, 0xffff}},
+        {"conic", "conic", {0xf800, 0x07e0, 0x001f, 0xffff}},
+    };
+
+    constexpr size_t decodeSampleBytes = 64 * 1024 * 1024;   /* Encoded text cycled through by the decode stage */
+
+    /* One measured combination */
+    struct Result {
+        std::string stage;
+        ImageWidth size = 0;
+        std::string pattern;
+        std::string format;
+        size_t threads = 0;
+        double seconds = 0.0;
+        double pixelsPerSecond = 0.0;
+        double bytesPerSecond = 0.0;
+        uint64_t allocations = 0;
+        uint64_t allocationBytes = 0;
+
+        [[nodiscard]] std::string key() const {
+            return stage + ' ' + std::to_string(size) + ' ' + pattern + ' ' + format + ' ' + std::to_string(threads);
+        }
+    };
+
+    struct Options {
+        std::vector<ImageWidth> sizes = {16, 64, 256, 1024, 4096, 16384};
+        std::vector<size_t> threads = {1, ThreadPool::defaultThreadCount()};
+        std::string output = "/dev/null";
+        std::string jsonPath;
+        std::string baselinePath;
+        double tolerance = 0.10;
+        double minSeconds = 0.2;
+    };
+
+    int usage() {
+        std::cerr << "Usage: program_bench [options]\n"
+                  << "--quick            sizes up to 1024 only\n"
+                  << "--sizes A,B,...    square image sizes (default: 16,64,256,1024,4096,16384)\n"
+                  << "--threads A,B,...  thread counts (default: 1 and all cores)\n"
+                  << "--output PATH      file written by the write stages (default: /dev/null)\n"
+                  << "--min-time S       repeat each measurement for at least S seconds (default: 0.2)\n"
+                  << "--json FILE        write the results as JSON\n"
+                  << "--compare FILE     compare against a JSON baseline, exit with 1 on regressions\n"
+                  << "--tolerance F      allowed slowdown before a regression is flagged (default: 0.10)\n";
+        return 2;
+    }
+
+    template <typename T>
+    std::vector<T> parseList(const std::string& text) {
+        std::vector<T> values;
+        std::stringstream stream(text);
+        for (std::string item; std::getline(stream, item, ',');) {
+            values.push_back(static_cast<T>(std::stoull(item)));
+        }
+        return values;
+    }
+
+    std::shared_ptr<Interpolation> makeInterpolator(const ImageWidth size, const Pattern& pattern) {
+        gradient::Parameters parameters;
+        parameters.width = size;
+        parameters.height = size;
+        parameters.tl = pattern.corners[0];
+        parameters.tr = pattern.corners[1];
+        parameters.bl = pattern.corners[2];
+        parameters.br = pattern.corners[3];
+        parameters.type = gradienttype::parse(pattern.gradient);
+        return InterpolationFactory::get(parameters);
+    }
+
+    /**
+     * Runs body until minSeconds have passed (at least once) and keeps the fastest run,
+     * together with the allocations that run made.
+     */
+    template <typename Body>
+    void measure(Result& result, const double minSeconds, Body&& body) {
+        double total = 0.0;
+        result.seconds = 0.0;
+        do {
+            const uint64_t allocationsBefore = stats::allocations();
+            const uint64_t bytesBefore = stats::allocatedBytes();
+            const auto start = std::chrono::steady_clock::now();
+            body();
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            total += elapsed.count();
+            if (result.seconds == 0.0 || elapsed.count() < result.seconds) {
+                result.seconds = elapsed.count();
+                result.allocations = stats::allocations() - allocationsBefore;
+                result.allocationBytes = stats::allocatedBytes() - bytesBefore;
+            }
+        } while (total < minSeconds);
+    }
+
+    void record(std::vector<Result>& results, Result result, const uint64_t bytes) {
+        const double pixels = static_cast<double>(result.size) * static_cast<double>(result.size);
+        const double seconds = std::max(result.seconds, 1e-9);
+        result.pixelsPerSecond = pixels / seconds;
+        result.bytesPerSecond = static_cast<double>(bytes) / seconds;
+        std::printf("%-10s %6llu^2 %-10s %-4s %3zu thr %10.3f ms %10.2f Mpx/s %10.2f MB/s %8llu allocs\n",
+                    result.stage.c_str(), static_cast<unsigned long long>(result.size), result.pattern.c_str(),
+                    result.format.c_str(), result.threads, result.seconds * 1e3, result.pixelsPerSecond / 1e6,
+                    result.bytesPerSecond / 1e6, static_cast<unsigned long long>(result.allocations));
+        std::fflush(stdout);
+        results.push_back(std::move(result));
+    }
+
+    void run(const Options& options, std::vector<Result>& results) {
+        for (const size_t threads : options.threads) {
+            ThreadPool pool(threads);
+            for (const ImageWidth size : options.sizes) {
+                for (const Pattern& pattern : patterns) {
+                    const auto interpolator = makeInterpolator(size, pattern);
+                    Result base;
+                    base.size = size;
+                    base.pattern = pattern.name;
+                    base.threads = pool.size();
+
+                    Result generate = base;
+                    generate.stage = "generate";
+                    generate.format = "-";
+                    ResultGradient image;
+                    measure(generate, options.minSeconds, [&] { image = interpolator->generate(pool); });
+                    record(results, generate, image.stride() * image.height() * sizeof(Pixel));
+
+                    for (const OutputFormat format : {OutputFormat::TEXT, OutputFormat::RAW}) {
+                        base.format = rowformat::toString(format);
+                        const size_t rowBytes = rowformat::rowBytes(format, size);
+                        const uint64_t fileBytes = static_cast<uint64_t>(rowBytes) * size;
+
+                        /* The encoder does not depend on the thread count */
+                        if (threads == options.threads.front()) {
+                            Result encode = base;
+                            encode.stage = "encode";
+                            std::vector<char> row(rowBytes);
+                            measure(encode, options.minSeconds, [&] {
+                                for (ImageHeight y = 0; y < image.height(); y++) {
+                                    rowformat::encodeRow(format, image.row(y), size, row.data());
+                                }
+                            });
+                            record(results, encode, fileBytes);
+                        }
+
+                        /* The text decoder (--verify) reads a sample of encoded rows larger than the caches */
+                        if (threads == options.threads.front() && format == OutputFormat::TEXT) {
+                            Result decode = base;
+                            decode.stage = "decode";
+                            const ImageHeight sampleRows = std::clamp<ImageHeight>(decodeSampleBytes / rowBytes, 1, size);
+                            std::vector<char> text(sampleRows * rowBytes);
+                            for (ImageHeight y = 0; y < sampleRows; y++) {
+                                rowformat::encodeRow(format, image.row(y), size, text.data() + y * rowBytes);
+                            }
+                            std::vector<Pixel> row(size);
+                            measure(decode, options.minSeconds, [&] {
+                                for (ImageHeight y = 0; y < size; y++) {
+                                    if (hexdecoder::decodeRow(text.data() + (y % sampleRows) * rowBytes, size, row.data()) != size) {
+                                        throw std::runtime_error("Decoded text differs from the encoded rows");
+                                    }
+                                }
+                            });
+                            record(results, decode, fileBytes);
+                        }
+
+                        Result write = base;
+                        write.stage = "write";
+                        measure(write, options.minSeconds, [&] {
+                            FileHandler fileHandler(options.output, format);
+                            fileHandler.writeResults(image);
+                        });
+                        record(results, write, fileBytes);
+
+                        Result endToEnd = base;
+                        endToEnd.stage = "end-to-end";
+                        measure(endToEnd, options.minSeconds, [&] {
+                            FileHandler fileHandler(options.output, format);
+                            fileHandler.writeResults(interpolator->generate(pool));
+                        });
+                        record(results, endToEnd, fileBytes);
+                    }
+                }
+            }
+        }
+    }
+
+    /* One result per line, so the baseline can be read back without a JSON library */
+    void writeJson(const std::string& path, const std::vector<Result>& results) {
+        std::ofstream file(path);
+        file << "{\n  \"generator_version\": \"" << generatorVersion << "\",\n"
+             << "  \"simd\": \"" << kernel::toString(kernel::activeSimdPath()) << "\",\n"
+             << "  \"results\": [\n";
+        char line[512];
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            std::snprintf(line, sizeof(line),
+                          "    {\"stage\": \"%s\", \"size\": %llu, \"pattern\": \"%s\", \"format\": \"%s\", "
+                          "\"threads\": %zu, \"seconds\": %.9f, \"pixels_per_second\": %.1f, "
+                          "\"bytes_per_second\": %.1f, \"allocations\": %llu, \"allocated_bytes\": %llu}%s\n",
+                          r.stage.c_str(), static_cast<unsigned long long>(r.size), r.pattern.c_str(), r.format.c_str(),
+                          r.threads, r.seconds, r.pixelsPerSecond, r.bytesPerSecond,
+                          static_cast<unsigned long long>(r.allocations),
+                          static_cast<unsigned long long>(r.allocationBytes), i + 1 < results.size() ? "," : "");
+            file << line;
+        }
+        file << "  ]\n}\n";
+        if (!file) {
+            throw std::ios_base::failure("Could not write " + path);
+        }
+    }
+
+    std::string field(const std::string& line, const std::string& name) {
+        const std::string marker = "\"" + name + "\": ";
+        size_t position = line.find(marker);
+        if (position == std::string::npos) {
+            return {};
+        }
+        position += marker.size();
+        const bool quoted = line[position] == '"';
+        position += quoted ? 1 : 0;
+        const size_t end = line.find_first_of(quoted ? "\"" : ",}", position);
+        return line.substr(position, end - position);
+    }
+
+    std::map<std::string, Result> readJson(const std::string& path) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            throw std::ios_base::failure("Could not open baseline " + path);
+        }
+        std::map<std::string, Result> baseline;
+        for (std::string line; std::getline(file, line);) {
+            if (line.find("\"stage\"") == std::string::npos) {
+                continue;
+            }
+            Result result;
+            result.stage = field(line, "stage");
+            result.size = std::stoull(field(line, "size"));
+            result.pattern = field(line, "pattern");
+            result.format = field(line, "format");
+            result.threads = std::stoull(field(line, "threads"));
+            result.pixelsPerSecond = std::stod(field(line, "pixels_per_second"));
+            result.allocations = std::stoull(field(line, "allocations"));
+            baseline[result.key()] = result;
+        }
+        return baseline;
+    }
+
+    /* Flags results slower than the baseline by more than the tolerance, or allocating more */
+    bool compare(const std::vector<Result>& results, const std::map<std::string, Result>& baseline, const double tolerance) {
+        size_t regressions = 0;
+        size_t compared = 0;
+        for (const Result& result : results) {
+            const auto found = baseline.find(result.key());
+            if (found == baseline.end()) {
+                continue;
+            }
+            compared++;
+            const double ratio = result.pixelsPerSecond / std::max(found->second.pixelsPerSecond, 1e-9);
+            const bool slower = ratio < 1.0 - tolerance;
+            const auto allowedAllocations = static_cast<uint64_t>(static_cast<double>(found->second.allocations) * (1.0 + tolerance));
+            const bool allocates = result.allocations > allowedAllocations + 1;
+            if (slower || allocates) {
+                regressions++;
+                std::printf("REGRESSION %s: %.2f -> %.2f Mpx/s (%+.1f%%), %llu -> %llu allocs\n", result.key().c_str(),
+                            found->second.pixelsPerSecond / 1e6, result.pixelsPerSecond / 1e6, (ratio - 1.0) * 100.0,
+                            static_cast<unsigned long long>(found->second.allocations),
+                            static_cast<unsigned long long>(result.allocations));
+            }
+        }
+        std::printf("Compared %zu results against the baseline, %zu regressions\n", compared, regressions);
+        return regressions == 0;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    try {
+        for (int i = 1; i < argc; i++) {
+            const std::string option = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for option " + option);
+                }
+                return argv[++i];
+            };
+            if (option == "--quick") {
+                options.sizes = {16, 64, 256, 1024};
+            } else if (option == "--sizes") {
+                options.sizes = parseList<ImageWidth>(value());
+            } else if (option == "--threads") {
+                options.threads = parseList<size_t>(value());
+            } else if (option == "--output") {
+                options.output = value();
+            } else if (option == "--min-time") {
+                options.minSeconds = std::stod(value());
+            } else if (option == "--json") {
+                options.jsonPath = value();
+            } else if (option == "--compare") {
+                options.baselinePath = value();
+            } else if (option == "--tolerance") {
+                options.tolerance = std::stod(value());
+            } else {
+                return usage();
+            }
+        }
+        std::sort(options.threads.begin(), options.threads.end());
+        options.threads.erase(std::unique(options.threads.begin(), options.threads.end()), options.threads.end());
+
+        /* Enables the allocation counter of the stats module */
+        stats::enable(stats::sample());
+        std::printf("SIMD path: %s\n", kernel::toString(kernel::activeSimdPath()));
+        std::vector<Result> results;
+        run(options, results);
+
+        if (!options.jsonPath.empty()) {
+            writeJson(options.jsonPath, results);
+        }
+        if (!options.baselinePath.empty() && !compare(results, readJson(options.baselinePath), options.tolerance)) {
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return usage();
+    }
+    return 0;
+}
@@ -0,0 +1,39 @@
+# @file batch_test.cmake
+# @brief Runs --batch with more large jobs than threads and checks every output.
+#
+# Jobs this large render their rows on the pool, so a thread waiting for them starts other
+# jobs; this used to run out of workspaces and crash. Lines that cannot run have to fail. Run with
+# cmake -DPROGRAM=<program> -DWORK_DIR=<dir> -P batch_test.cmake
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+set(manifest "")
+foreach(job RANGE 1 12)
+    string(APPEND manifest "2000 600 0 65535 1234 40000 ${WORK_DIR}/out${job}.raw --format raw\n")
+endforeach()
+file(WRITE ${WORK_DIR}/manifest.txt "${manifest}")
+
+foreach(threads 1 2 3)
+    execute_process(COMMAND ${PROGRAM} --batch ${WORK_DIR}/manifest.txt --threads ${threads}
+                    RESULT_VARIABLE result OUTPUT_QUIET)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "--batch with ${threads} threads failed: ${result}")
+    endif()
+    foreach(job RANGE 1 12)
+        file(SIZE ${WORK_DIR}/out${job}.raw size)
+        if(NOT size EQUAL 2400000)
+            message(FATAL_ERROR "out${job}.raw has ${size} bytes after ${threads} threads, expected 2400000")
+        endif()
+    endforeach()
+endforeach()
+
+# Lines that cannot run fail on their own, without the options of a whole run taking effect
+file(WRITE ${WORK_DIR}/rejected.txt "--invalid-json\n16 16 1 2 3 4 ${WORK_DIR}/mmap.txt --mmap\n"
+                                    "16 16 1 2 3 4 ${WORK_DIR}/stats.txt --stats-json ${WORK_DIR}/stats.json\n")
+execute_process(COMMAND ${PROGRAM} --batch ${WORK_DIR}/rejected.txt RESULT_VARIABLE result OUTPUT_VARIABLE output)
+string(REGEX MATCHALL "\\[failed\\]" failures "${output}")
+list(LENGTH failures failed)
+if(result EQUAL 0 OR NOT failed EQUAL 3 OR EXISTS ${WORK_DIR}/stats.json)
+    message(FATAL_ERROR "Jobs with invalid lines or whole-run options did not fail:\n${output}")
+endif()
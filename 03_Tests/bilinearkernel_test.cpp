@@ -0,0 +1,122 @@
+/**
+ * @file bilinearkernel_test.cpp
+ * @brief Pins the rounding rule of the bilinear kernel documented in bilinearkernel.hpp.
+ *
+ * The rule is evaluated directly in 64-bit arithmetic and compared with every pixel the kernel
+ * renders, and a few values the rule fixes (halves rounded up, exact corners) are checked literally.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "bilinearkernel.hpp"
+#include "check.hpp"
+#include "rgb565.hpp"
+
+namespace {
+    constexpr int64_t F = int64_t{1} << kernel::fractionBits;
+
+    /* rdiv(n, d) = floor((2n + d) / 2d) */
+    int64_t rdiv(const int64_t n, const int64_t d) {
+        const int64_t numerator = 2 * n + d;
+        const int64_t denominator = 2 * d;
+        return numerator >= 0 ? numerator / denominator : -((-numerator + denominator - 1) / denominator);
+    }
+
+    /* c(x, y) of one channel, straight from the documented rule */
+    uint32_t channel(const int64_t tl, const int64_t tr, const int64_t bl, const int64_t br, const int64_t maximum,
+                     const uint64_t width, const uint64_t height, const uint64_t x, const uint64_t y) {
+        const int64_t w1 = std::max<int64_t>(static_cast<int64_t>(width) - 1, 1);
+        const int64_t h1 = std::max<int64_t>(static_cast<int64_t>(height) - 1, 1);
+        const int64_t left = bl * F + rdiv((tl - bl) * F * static_cast<int64_t>(y), h1);
+        const int64_t right = br * F + rdiv((tr - br) * F * static_cast<int64_t>(y), h1);
+        const int64_t step = rdiv(right - left, w1);
+        const int64_t sum = left + static_cast<int64_t>(x) * step + F / 2;
+        const int64_t value = sum >= 0 ? sum / F : -((-sum + F - 1) / F);
+        return static_cast<uint32_t>(std::clamp<int64_t>(value, 0, maximum));
+    }
+
+    Pixel reference(const Pixel tl, const Pixel tr, const Pixel bl, const Pixel br,
+                    const uint64_t width, const uint64_t height, const uint64_t x, const uint64_t y) {
+        const auto a = rgb565::unpack(tl), b = rgb565::unpack(tr), c = rgb565::unpack(bl), d = rgb565::unpack(br);
+        return static_cast<Pixel>(channel(a.red, b.red, c.red, d.red, 31, width, height, x, y) << rgb565::redShift
+                                  | channel(a.green, b.green, c.green, d.green, 63, width, height, x, y) << rgb565::greenShift
+                                  | channel(a.blue, b.blue, c.blue, d.blue, 31, width, height, x, y));
+    }
+
+    std::string describe(const uint64_t width, const uint64_t height, const Pixel tl, const Pixel tr,
+                         const Pixel bl, const Pixel br) {
+        return std::to_string(width) + "x" + std::to_string(height) + " " + std::to_string(tl) + " "
+               + std::to_string(tr) + " " + std::to_string(bl) + " " + std::to_string(br);
+    }
+
+    /* Every pixel matches the rule and the corners are the input colors */
+    void checkImage(const uint64_t width, const uint64_t height, const Pixel tl, const Pixel tr, const Pixel bl, const Pixel br) {
+        const kernel::BilinearKernel kernel(width, height, tl, tr, bl, br);
+        std::vector<Pixel> row(width);
+        bool matches = true;
+        for (uint64_t y = 0; y < height && matches; y++) {
+            kernel.renderRow(y, row.data());
+            for (uint64_t x = 0; x < width && matches; x++) {
+                matches = row[x] == reference(tl, tr, bl, br, width, height, x, y);
+            }
+        }
+        CHECK_MESSAGE(matches, describe(width, height, tl, tr, bl, br));
+
+        kernel.renderRow(0, row.data());
+        CHECK_MESSAGE(row.front() == bl, describe(width, height, tl, tr, bl, br));
+        if (width > 1) {
+            CHECK_MESSAGE(row.back() == br, describe(width, height, tl, tr, bl, br));
+        }
+        if (height > 1) {
+            kernel.renderRow(height - 1, row.data());
+            CHECK_MESSAGE(row.front() == tl, describe(width, height, tl, tr, bl, br));
+            if (width > 1) {
+                CHECK_MESSAGE(row.back() == tr, describe(width, height, tl, tr, bl, br));
+            }
+        }
+    }
+}
+
+int main() {
+    using kernel::detail::roundedDivide;
+
+    /* rdiv rounds halves up, towards positive infinity, also for negative numerators */
+    CHECK(roundedDivide(1, 2) == 1);
+    CHECK(roundedDivide(-1, 2) == 0);
+    CHECK(roundedDivide(3, 2) == 2);
+    CHECK(roundedDivide(-3, 2) == -1);
+    CHECK(roundedDivide(5, 4) == 1);
+    CHECK(roundedDivide(7, 4) == 2);
+    CHECK(roundedDivide(-5, 4) == -1);
+    CHECK(roundedDivide(-7, 4) == -2);
+    CHECK(roundedDivide(0, 9) == 0);
+
+    /* Literal pixels: blue 0 to 31 over three pixels puts 15.5 in the middle, which rounds up */
+    {
+        const kernel::BilinearKernel kernel(3, 1, 0, 0, 0x0000, 0x001f);
+        Pixel row[3];
+        kernel.renderRow(0, row);
+        CHECK(row[0] == 0x0000 && row[1] == 0x0010 && row[2] == 0x001f);
+    }
+    {
+        const kernel::BilinearKernel kernel(2, 2, 0xffff, 0x0000, 0xf800, 0x001f);
+        Pixel row[2];
+        kernel.renderRow(0, row);
+        CHECK(row[0] == 0xf800 && row[1] == 0x001f);
+        kernel.renderRow(1, row);
+        CHECK(row[0] == 0xffff && row[1] == 0x0000);
+    }
+
+    /* The sizes whose output changed with the kernel, degenerate sizes, and random ones */
+    const uint64_t sizes[][2] = {{1, 1}, {1, 7}, {7, 1}, {2, 2}, {16, 16}, {32, 32}, {37, 19}, {300, 5}, {5, 300}, {1000, 3}};
+    for (const auto& size : sizes) {
+        checkImage(size[0], size[1], 0x0000, 0xffff, 0xf800, 0x07e0);
+        checkImage(size[0], size[1], 0xffff, 0x0000, 0x001f, 0xf800);
+    }
+    for (int i = 0; i < 200; i++) {
+        const auto color = [] { return static_cast<Pixel>(check::between(0, 0xffff)); };
+        checkImage(check::between(1, 300), check::between(1, 300), color(), color(), color(), color());
+    }
+    return check::result();
+}
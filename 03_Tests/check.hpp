@@ -0,0 +1,51 @@
+/**
+ * @file check.hpp
+ * @brief Minimal assertions shared by the unit tests in 03_Tests.
+ *
+ * Every test is its own executable registered with ctest. A failed check prints its location
+ * and the test keeps going, so one run lists every failure; check::result() gives the exit code.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace check {
+    inline int failures = 0;
+
+    inline bool expect(const bool condition, const std::string& what, const char* file, const int line) {
+        if (!condition) {
+            failures++;
+            if (failures <= 20) {
+                std::cerr << file << ":" << line << ": check failed: " << what << "\n";
+            }
+        }
+        return condition;
+    }
+
+    /** @brief Exit code of the test: 0 when every check passed. */
+    inline int result() {
+        if (failures > 0) {
+            std::cerr << failures << " check(s) failed\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    /** @brief Random number source with a fixed seed, so failures reproduce. */
+    inline std::mt19937_64& random() {
+        static std::mt19937_64 generator(0x6752414449454e54ULL);
+        return generator;
+    }
+
+    /** @brief Uniform random integer in [low, high]. */
+    inline uint64_t between(const uint64_t low, const uint64_t high) {
+        return std::uniform_int_distribution<uint64_t>(low, high)(random());
+    }
+}
+
+#define CHECK(condition) check::expect((condition), #condition, __FILE__, __LINE__)
+#define CHECK_MESSAGE(condition, message) check::expect((condition), std::string(#condition) + " (" + (message) + ")", __FILE__, __LINE__)
@@ -0,0 +1,52 @@
+/**
+ * @file conickernel_test.cpp
+ * @brief Checks the seam of the conic kernel: pixels on the start angle take the first stop.
+ *
+ * The start angles are the multiples of 45 degrees, whose rays run through pixel centers of
+ * odd square images. The pixels just clockwise of a ray are the end of the turn and stay
+ * close to the last stop.
+ */
+
+#include <string>
+#include <vector>
+#include "check.hpp"
+#include "colorramp.hpp"
+#include "conickernel.hpp"
+
+namespace {
+    constexpr Pixel firstStop = 0x0000, lastStop = 0xffff;
+
+    void checkSeam(const ImageWidth size, const uint16_t angle) {
+        const kernel::ConicKernel kernel(size, size, kernel::ColorRamp({firstStop, lastStop}), angle);
+        std::vector<Pixel> image(size * size);
+        for (ImageHeight y = 0; y < size; y++) {
+            kernel.renderRow(y, image.data() + y * size);
+        }
+
+        /* Direction of the ray, counterclockwise from the positive x axis with y pointing up */
+        const int directions[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+        const int dx = directions[angle / 45][0], dy = directions[angle / 45][1];
+        const auto pixel = [&](const int64_t x, const int64_t y) { return image[static_cast<size_t>(y) * size + x]; };
+
+        const int64_t center = size / 2;
+        bool onSeam = true, beforeSeam = true;
+        for (int64_t step = 2; step < center; step++) {
+            const int64_t x = center + step * dx, y = center + step * dy;
+            onSeam = onSeam && pixel(x, y) == firstStop;
+            /* One pixel clockwise, (dy, -dx) off the ray, is at least 0.95 turns from the start from three steps on */
+            beforeSeam = beforeSeam && (step < 3 || pixel(x + dy, y - dx) >= 0xe000);
+        }
+        const std::string name = std::to_string(size) + "x" + std::to_string(size) + " at " + std::to_string(angle);
+        CHECK_MESSAGE(onSeam, name + ": pixel on the start angle is not the first stop");
+        CHECK_MESSAGE(beforeSeam, name + ": pixel before the start angle is not near the last stop");
+    }
+}
+
+int main() {
+    for (const ImageWidth size : {11u, 101u, 1001u}) {
+        for (uint16_t angle = 0; angle < 360; angle += 45) {
+            checkSeam(size, angle);
+        }
+    }
+    return check::result();
+}
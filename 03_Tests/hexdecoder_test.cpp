@@ -0,0 +1,118 @@
+/**
+ * @file hexdecoder_test.cpp
+ * @brief Checks that the AVX2 hex row decoder matches hexdecoder::decodeRowScalar.
+ *
+ * Rows of every width around the 4-pixel groups and the 5-pixel tail are encoded with
+ * hexencoder and decoded by both paths, then broken at every byte position with bytes on
+ * either side of the valid ranges, upper-case digits included. Both paths have to report the
+ * same first malformed pixel. Without AVX2 only the scalar path is checked.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "check.hpp"
+#include "hexdecoder.hpp"
+#include "hexencoder.hpp"
+
+namespace {
+    /* Just outside or at the edge of the ranges of digits, letters and the template bytes */
+    const char brokenBytes[] = {'/', ':', '`', 'g', 'A', 'F', 'X', '0', 'x', ' ', '\n', '\0', static_cast<char>(0xb0)};
+
+    /* Whether a byte may stand at an offset of a pixel; the separator of the last pixel is a newline */
+    bool validAt(const size_t offset, const bool last, const char byte) {
+        switch (offset) {
+        case 0:
+            return byte == '0';
+        case 1:
+            return byte == 'x';
+        case hexencoder::bytesPerPixel - 1:
+            return byte == (last ? '\n' : ' ');
+        default:
+            return (byte >= '0' && byte <= '9') || (byte >= 'a' && byte <= 'f');
+        }
+    }
+
+    std::vector<char> encode(const std::vector<Pixel>& pixels) {
+        const auto width = static_cast<ImageWidth>(pixels.size());
+        std::vector<char> text(hexencoder::rowBytes(width));
+        hexencoder::encodeRow(pixels.data(), width, text.data());
+        return text;
+    }
+
+    /* Decodes the row with both paths and compares the result and the pixels before the first malformed one */
+    void checkRow(const std::vector<char>& text, const ImageWidth width, const ImageWidth malformed, const std::string& name) {
+        std::vector<Pixel> expected(width), actual(width);
+        const ImageWidth scalar = hexdecoder::decodeRowScalar(text.data(), width, expected.data());
+        CHECK_MESSAGE(scalar == malformed, "scalar " + name + ": " + std::to_string(scalar));
+        if (!hexdecoder::isAvx2Supported()) {
+            return;
+        }
+        const ImageWidth avx2 = hexdecoder::decodeRowAvx2(text.data(), width, actual.data());
+        CHECK_MESSAGE(avx2 == scalar, "avx2 " + name + ": " + std::to_string(avx2) + " instead of " + std::to_string(scalar));
+        bool matches = true;
+        for (ImageWidth x = 0; x < std::min(scalar, width) && matches; x++) {
+            matches = actual[x] == expected[x];
+        }
+        CHECK_MESSAGE(matches, "avx2 pixels " + name);
+    }
+}
+
+int main() {
+    if (!hexdecoder::isAvx2Supported()) {
+        std::cout << "skipped avx2: not supported by this CPU\n";
+    }
+    const auto color = [] { return static_cast<Pixel>(check::between(0, 0xffff)); };
+
+    /* Valid rows, including digits next to the ends of their ranges */
+    for (ImageWidth width = 0; width <= 40; width++) {
+        for (int i = 0; i < 20; i++) {
+            std::vector<Pixel> pixels(width);
+            for (Pixel& pixel : pixels) {
+                pixel = i == 0 ? 0x09af : i == 1 ? 0xfa90 : color();
+            }
+            const std::vector<char> text = encode(pixels);
+            std::vector<Pixel> decoded(width);
+            CHECK(hexdecoder::decodeRowScalar(text.data(), width, decoded.data()) == width && decoded == pixels);
+            checkRow(text, width, width, "width " + std::to_string(width));
+        }
+    }
+
+    /* Every byte of rows up to 13 pixels replaced by every broken byte */
+    for (ImageWidth width = 1; width <= 13; width++) {
+        std::vector<Pixel> pixels(width);
+        for (Pixel& pixel : pixels) {
+            pixel = color();
+        }
+        const std::vector<char> valid = encode(pixels);
+        for (size_t position = 0; position < valid.size(); position++) {
+            for (const char broken : brokenBytes) {
+                const size_t offset = position % hexencoder::bytesPerPixel;
+                if (validAt(offset, position / hexencoder::bytesPerPixel + 1 == width, broken)) {
+                    continue;
+                }
+                std::vector<char> text = valid;
+                text[position] = broken;
+                checkRow(text, width, static_cast<ImageWidth>(position / hexencoder::bytesPerPixel),
+                         "width " + std::to_string(width) + " byte " + std::to_string(position) + " = "
+                             + std::to_string(static_cast<int>(broken)));
+            }
+        }
+    }
+
+    /* Long rows broken at a random pixel */
+    for (int i = 0; i < 2000; i++) {
+        std::vector<Pixel> pixels(check::between(1, 3000));
+        for (Pixel& pixel : pixels) {
+            pixel = color();
+        }
+        const auto width = static_cast<ImageWidth>(pixels.size());
+        std::vector<char> text = encode(pixels);
+        const size_t position = check::between(0, text.size() - 1);
+        text[position] = text[position] == 'g' ? 'G' : 'g';
+        checkRow(text, width, static_cast<ImageWidth>(position / hexencoder::bytesPerPixel),
+                 "width " + std::to_string(width) + " byte " + std::to_string(position));
+    }
+    return check::result();
+}
@@ -0,0 +1,92 @@
+/**
+ * @file region_test.cpp
+ * @brief Checks that a --region render equals the same rectangle of the full render.
+ *
+ * Every gradient type is rendered with random sizes, colors, stops and angles, once in full
+ * and once for random rectangles, including single pixels, single rows and columns and the
+ * whole image. Both the generated pixels and the encoded text and raw images are compared.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "check.hpp"
+#include "gradienttype.hpp"
+#include "interpolation.hpp"
+#include "rowformat.hpp"
+
+namespace {
+    /* Encodes the rectangle of a full framebuffer the way the writers do, top row first */
+    std::vector<char> encodeCrop(const ResultGradient& full, const Region& region, const OutputFormat format) {
+        std::vector<char> encoded(rowformat::imageBytes(format, region.width, region.height));
+        char* out = encoded.data();
+        for (ImageHeight top = 0; top < region.height; top++) {
+            const Pixel* row = full.row(full.height() - 1 - region.y - top) + region.x;
+            out = rowformat::encodeRow(format, row, region.width, out);
+        }
+        return encoded;
+    }
+
+    void checkRegion(ThreadPool& pool, gradient::Parameters parameters, const ResultGradient& full, const Region& region) {
+        parameters.region = region;
+        const auto interpolator = InterpolationFactory::get(parameters);
+        const ResultGradient crop = interpolator->generate(pool);
+        const std::string name = std::string(gradienttype::toString(parameters.type)) + " "
+                                 + std::to_string(parameters.width) + "x" + std::to_string(parameters.height) + " region "
+                                 + std::to_string(region.x) + "," + std::to_string(region.y) + ","
+                                 + std::to_string(region.width) + "," + std::to_string(region.height);
+
+        bool matches = crop.width() == region.width && crop.height() == region.height;
+        for (ImageHeight y = 0; y < region.height && matches; y++) {
+            const Pixel* expected = full.row(full.height() - region.y - region.height + y) + region.x;
+            matches = std::equal(expected, expected + region.width, crop.row(y));
+        }
+        CHECK_MESSAGE(matches, name);
+
+        for (const OutputFormat format : {OutputFormat::TEXT, OutputFormat::RAW}) {
+            std::vector<char> encoded(rowformat::imageBytes(format, region.width, region.height));
+            interpolator->encodeImage(pool, format, encoded.data());
+            CHECK_MESSAGE(encoded == encodeCrop(full, region, format), name + " " + rowformat::toString(format));
+        }
+    }
+}
+
+int main() {
+    ThreadPool pool(3);
+    const auto color = [] { return static_cast<Pixel>(check::between(0, 0xffff)); };
+
+    for (int i = 0; i < 120; i++) {
+        gradient::Parameters parameters;
+        parameters.type = static_cast<InterpolationType>(i % 4);
+        parameters.width = check::between(1, 400);
+        parameters.height = check::between(1, 400);
+        parameters.tl = color();
+        parameters.tr = color();
+        parameters.bl = color();
+        parameters.br = color();
+        for (int stop = check::between(0, 5); stop > 0; stop--) {
+            parameters.stops.push_back(color());
+        }
+        if (parameters.stops.size() == 1) {
+            parameters.stops.clear();
+        }
+        parameters.angle = static_cast<uint16_t>(check::between(0, 359));
+        const ResultGradient full = InterpolationFactory::get(parameters)->generate(pool);
+
+        const ImageWidth w = parameters.width;
+        const ImageHeight h = parameters.height;
+        checkRegion(pool, parameters, full, Region{0, 0, w, h});
+        checkRegion(pool, parameters, full, Region{w - 1, h - 1, 1, 1});
+        checkRegion(pool, parameters, full, Region{0, check::between(0, h - 1), w, 1});
+        checkRegion(pool, parameters, full, Region{check::between(0, w - 1), 0, 1, h});
+        for (int j = 0; j < 4; j++) {
+            Region region;
+            region.x = check::between(0, w - 1);
+            region.y = check::between(0, h - 1);
+            region.width = check::between(1, w - region.x);
+            region.height = check::between(1, h - region.y);
+            checkRegion(pool, parameters, full, region);
+        }
+    }
+    return check::result();
+}
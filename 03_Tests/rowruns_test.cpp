@@ -0,0 +1,63 @@
+/**
+ * @file rowruns_test.cpp
+ * @brief Checks that kernel::renderRowRuns matches the per-pixel kernel::renderRowScalar.
+ *
+ * Rows come from random images from one pixel to very wide, started at random columns, so
+ * runs of every length occur, including single pixels and channels clamped at either end.
+ * BilinearKernel::renderSpan, which chooses between the two, is checked the same way.
+ */
+
+#include <string>
+#include <vector>
+#include "bilinearkernel.hpp"
+#include "check.hpp"
+
+namespace {
+    constexpr Pixel guard = 0xbeef;
+
+    std::string describe(const ImageWidth width, const ImageHeight height, const ImageHeight y, const ImageWidth first,
+                         const ImageWidth count) {
+        return std::to_string(width) + "x" + std::to_string(height) + " row " + std::to_string(y) + " span "
+               + std::to_string(first) + "+" + std::to_string(count);
+    }
+
+    /* Renders a span of one row run by run, through renderSpan and per pixel, including the pixel after it */
+    void checkSpan(const kernel::BilinearKernel& kernel, const ImageHeight y, const ImageWidth first, const ImageWidth count) {
+        const kernel::RowSetup setup = kernel::advance(kernel.setupRow(y), first);
+        std::vector<Pixel> expected(count + 1, guard), runs(count + 1, guard), span(count + 1, guard);
+        kernel::renderRowScalar(setup, expected.data(), count);
+        kernel::renderRowRuns(setup, runs.data(), count);
+        kernel.renderSpan(y, first, count, span.data());
+
+        const std::string name = describe(kernel.width(), kernel.height(), y, first, count);
+        CHECK_MESSAGE(kernel::detail::accumulatorsInRange(setup, count), name);
+        CHECK_MESSAGE(runs == expected, "renderRowRuns " + name);
+        CHECK_MESSAGE(span == expected, "renderSpan " + name);
+    }
+}
+
+int main() {
+    const auto color = [] { return static_cast<Pixel>(check::between(0, 0xffff)); };
+
+    /* Extreme corners: every channel sweeps its full range, once per row and once per column */
+    for (const ImageWidth width : {1u, 2u, 3u, 31u, 32u, 33u, 63u, 64u, 65u, 1000u, 65536u, 100003u}) {
+        const kernel::BilinearKernel kernel(width, 3, 0x0000, 0xffff, 0xffff, 0x0000);
+        for (ImageHeight y = 0; y < 3; y++) {
+            checkSpan(kernel, y, 0, width);
+        }
+    }
+
+    /* Random images, narrow ones with short runs and wide ones with long runs */
+    for (int i = 0; i < 300; i++) {
+        const ImageWidth width = i % 3 == 0 ? check::between(1, 100) : check::between(1, 200000);
+        const ImageHeight height = check::between(1, 5000);
+        const kernel::BilinearKernel kernel(width, height, color(), color(), color(), color());
+        for (int row = 0; row < 2; row++) {
+            const ImageHeight y = check::between(0, height - 1);
+            checkSpan(kernel, y, 0, width);
+            const ImageWidth first = check::between(0, width - 1);
+            checkSpan(kernel, y, first, check::between(0, width - first));
+        }
+    }
+    return check::result();
+}
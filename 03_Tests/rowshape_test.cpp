@@ -0,0 +1,137 @@
+/**
+ * @file rowshape_test.cpp
+ * @brief Checks the fast paths of solid, horizontal and vertical bilinear images against the general path.
+ *
+ * Random corners of each shape are rendered through Interpolation::generate(), which copies
+ * identical rows, through encodeImage(), which encodes a band's row once, and through
+ * FileHandler::writeRows() with the shape, which replicates rows per buffer fill. The result
+ * of each has to equal every pixel rendered with kernel::renderRowScalar and encoded row by
+ * row, as for a general image. Regions of the images take the same paths.
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "check.hpp"
+#include "filehandler.hpp"
+#include "gradienttype.hpp"
+#include "interpolation.hpp"
+#include "rowformat.hpp"
+
+namespace {
+    /* Every pixel of the region rendered per pixel from the row setups, bottom row first */
+    ResultGradient reference(const gradient::Parameters& parameters) {
+        const kernel::BilinearKernel kernel(parameters.width, parameters.height, parameters.tl, parameters.tr,
+                                            parameters.bl, parameters.br);
+        const Region region = parameters.output();
+        ResultGradient pixels(region.width, region.height);
+        for (ImageHeight y = 0; y < region.height; y++) {
+            const ImageHeight row = parameters.height - region.y - region.height + y;
+            kernel::renderRowScalar(kernel::advance(kernel.setupRow(row), region.x), pixels.row(y), region.width);
+        }
+        return pixels;
+    }
+
+    std::vector<char> encode(const ResultGradient& pixels, const OutputFormat format) {
+        std::vector<char> encoded(rowformat::imageBytes(format, pixels.width(), pixels.height()));
+        char* out = encoded.data();
+        for (ImageHeight y = pixels.height(); y > 0; y--) {
+            out = rowformat::encodeRow(format, pixels.row(y - 1), pixels.width(), out);
+        }
+        return encoded;
+    }
+
+    std::vector<char> readFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    }
+
+    void checkImage(ThreadPool& pool, const gradient::Parameters& parameters, const RowShape shape,
+                    const std::filesystem::path& path) {
+        const Region region = parameters.output();
+        const std::string name = std::string(gradienttype::toString(shape)) + " " + std::to_string(parameters.width) + "x"
+                                 + std::to_string(parameters.height) + " region " + std::to_string(region.x) + ","
+                                 + std::to_string(region.y) + "," + std::to_string(region.width) + ","
+                                 + std::to_string(region.height);
+        const auto interpolator = InterpolationFactory::get(parameters);
+        CHECK_MESSAGE(interpolator->shape() == shape, name);
+
+        const ResultGradient expected = reference(parameters);
+        const ResultGradient generated = interpolator->generate(pool);
+        bool matches = true;
+        for (ImageHeight y = 0; y < region.height && matches; y++) {
+            matches = std::equal(expected.row(y), expected.row(y) + region.width, generated.row(y));
+        }
+        CHECK_MESSAGE(matches, "generate " + name);
+
+        for (const OutputFormat format : {OutputFormat::TEXT, OutputFormat::RAW}) {
+            const std::vector<char> bytes = encode(expected, format);
+            std::vector<char> encoded(bytes.size());
+            interpolator->encodeImage(pool, format, encoded.data());
+            CHECK_MESSAGE(encoded == bytes, std::string("encodeImage ") + rowformat::toString(format) + " " + name);
+
+            /* Small buffers, so the replicated rows cross many buffer fills */
+            FileHandler fileHandler(path.string(), format, {}, IoBackend::WRITE, output::Backend::minimumBufferBytes);
+            fileHandler.writeResults(expected, shape);
+            CHECK_MESSAGE(readFile(path) == bytes, std::string("FileHandler ") + rowformat::toString(format) + " " + name);
+        }
+    }
+}
+
+int main() {
+    ThreadPool pool(3);
+    const std::filesystem::path path = std::filesystem::temp_directory_path()
+                                       / ("rowshape_test_" + std::to_string(check::between(0, 1 << 30)) + ".out");
+    const auto color = [] { return static_cast<Pixel>(check::between(0, 0xffff)); };
+
+    for (int i = 0; i < 240; i++) {
+        gradient::Parameters parameters;
+        parameters.width = check::between(1, i % 2 == 0 ? 64 : 3000);
+        parameters.height = check::between(1, 300);
+        const Pixel a = color(), b = color(), c = color(), d = color();
+        RowShape shape;
+        switch (i % 4) {
+        case 0:
+            shape = RowShape::SOLID;
+            parameters.tl = parameters.tr = parameters.bl = parameters.br = a;
+            break;
+        case 1:
+            shape = RowShape::HORIZONTAL;
+            parameters.tl = parameters.bl = a;
+            parameters.tr = parameters.br = b;
+            break;
+        case 2:
+            shape = RowShape::VERTICAL;
+            parameters.tl = parameters.tr = a;
+            parameters.bl = parameters.br = b;
+            break;
+        default:
+            shape = RowShape::GENERAL;
+            parameters.tl = a;
+            parameters.tr = b;
+            parameters.bl = c;
+            parameters.br = d;
+            break;
+        }
+        /* Random corners may happen to meet a condition of a more special shape */
+        if ((shape == RowShape::HORIZONTAL || shape == RowShape::VERTICAL) && a == b) {
+            shape = RowShape::SOLID;
+        } else if (shape == RowShape::GENERAL && ((a == c && b == d) || (a == b && c == d))) {
+            continue;
+        }
+
+        checkImage(pool, parameters, shape, path);
+        Region region;
+        region.x = check::between(0, parameters.width - 1);
+        region.y = check::between(0, parameters.height - 1);
+        region.width = check::between(1, parameters.width - region.x);
+        region.height = check::between(1, parameters.height - region.y);
+        parameters.region = region;
+        checkImage(pool, parameters, shape, path);
+    }
+    std::filesystem::remove(path);
+    return check::result();
+}
@@ -0,0 +1,68 @@
+/**
+ * @file simdkernel_test.cpp
+ * @brief Checks that every SIMD row renderer the CPU supports matches kernel::renderRowScalar.
+ *
+ * Rows come from real kernel setups of random images, started at random columns, and cover
+ * every tail length of the 8, 16 and 32 pixel paths. Paths the CPU lacks are reported as skipped.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bilinearkernel.hpp"
+#include "check.hpp"
+#include "simdkernel.hpp"
+
+namespace {
+    /* Renders count pixels of the row with both renderers and compares them, including the pixel after the row */
+    bool sameRow(const kernel::RowRenderer renderer, const kernel::RowSetup& setup, const ImageWidth count) {
+        constexpr Pixel guard = 0xbeef;
+        std::vector<Pixel> expected(count + 1, guard), actual(count + 1, guard);
+        kernel::renderRowScalar(setup, expected.data(), count);
+        renderer(setup, actual.data(), count);
+        return expected == actual;
+    }
+
+    void checkPath(const kernel::SimdPath path) {
+        const kernel::RowRenderer renderer = kernel::rowRenderer(path);
+        const std::string name = kernel::toString(path);
+        const auto color = [] { return static_cast<Pixel>(check::between(0, 0xffff)); };
+
+        /* Every length up to 100 covers each tail of the 8, 16 and 32 pixel loops */
+        for (ImageWidth count = 0; count <= 100; count++) {
+            const kernel::BilinearKernel kernel(count + 1, 7, color(), color(), color(), color());
+            for (ImageHeight y = 0; y < 7; y++) {
+                CHECK_MESSAGE(sameRow(renderer, kernel.setupRow(y), count), name + " width " + std::to_string(count));
+            }
+        }
+
+        /* Random images, spans starting at any column */
+        for (int i = 0; i < 2000; i++) {
+            const ImageWidth width = check::between(1, 5000);
+            const ImageHeight height = check::between(1, 5000);
+            const kernel::BilinearKernel kernel(width, height, color(), color(), color(), color());
+            const ImageWidth first = check::between(0, width - 1);
+            const ImageWidth count = check::between(0, width - first);
+            const kernel::RowSetup setup = kernel::advance(kernel.setupRow(check::between(0, height - 1)), first);
+            CHECK_MESSAGE(sameRow(renderer, setup, count), name + " " + std::to_string(width) + "x" + std::to_string(height)
+                                                           + " span " + std::to_string(first) + "+" + std::to_string(count));
+        }
+    }
+}
+
+int main() {
+    /* GRADIENT_SIMD forces a supported path for the whole process */
+    setenv("GRADIENT_SIMD", "scalar", 1);
+    CHECK(kernel::activeSimdPath() == kernel::SimdPath::SCALAR);
+
+    for (const kernel::SimdPath path : {kernel::SimdPath::SSE2, kernel::SimdPath::AVX2, kernel::SimdPath::AVX512}) {
+        if (!kernel::isSupported(path)) {
+            std::cout << "skipped " << kernel::toString(path) << ": not supported by this CPU\n";
+            continue;
+        }
+        CHECK(kernel::parseSimdPath(kernel::toString(path)) == path);
+        checkPath(path);
+    }
+    return check::result();
+}
@@ -0,0 +1,96 @@
+/**
+ * @file client.cpp
+ * @brief Minimal client of the --serve mode, mainly for testing.
+ *
+ * Sends its arguments as one request line and prints the response: image bytes go to
+ * stdout, a written file path is printed, errors go to stderr.
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    int usage() {
+        std::cerr << "Usage: program_client <socket_path> <image_width> <image_height> <tl> <tr> <bl> <br> <output_path> [--format F]\n"
+                  << "       program_client <socket_path> quit\n"
+                  << "Use - as <output_path> to receive the image on the standard output.\n";
+        return -1;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        return usage();
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (std::strlen(argv[1]) >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path is too long: " << argv[1] << std::endl;
+        return -1;
+    }
+    std::strcpy(address.sun_path, argv[1]);
+
+    const int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection < 0 || connect(connection, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "Could not connect to " << argv[1] << ": " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+
+    std::string request;
+    for (int i = 2; i < argc; i++) {
+        request += (i > 2 ? " " : "") + std::string(argv[i]);
+    }
+    request += '\n';
+    if (send(connection, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size())) {
+        std::cerr << "Could not send the request" << std::endl;
+        return -1;
+    }
+
+    /* The header line is followed by the image bytes for DATA responses */
+    std::string header;
+    char buffer[64 * 1024];
+    ssize_t received = 0;
+    while ((received = recv(connection, buffer, sizeof(buffer), 0)) > 0) {
+        header.append(buffer, static_cast<size_t>(received));
+        if (header.find('\n') != std::string::npos) {
+            break;
+        }
+    }
+    const size_t end = header.find('\n');
+    if (end == std::string::npos) {
+        std::cerr << "Connection closed without a response" << std::endl;
+        return -1;
+    }
+
+    const std::string status = header.substr(0, end);
+    if (status.starts_with("DATA ")) {
+        const unsigned long long expected = std::stoull(status.substr(5));
+        unsigned long long written = header.size() - end - 1;
+        std::fwrite(header.data() + end + 1, 1, header.size() - end - 1, stdout);
+        while (written < expected && (received = recv(connection, buffer, sizeof(buffer), 0)) > 0) {
+            std::fwrite(buffer, 1, static_cast<size_t>(received), stdout);
+            written += static_cast<unsigned long long>(received);
+        }
+        close(connection);
+        if (std::fflush(stdout) != 0 || written != expected) {
+            std::cerr << "Incomplete image: received " << written << " of " << expected << " bytes" << std::endl;
+            return -1;
+        }
+        return 0;
+    }
+
+    close(connection);
+    if (status.starts_with("ERROR ")) {
+        std::cerr << status.substr(6) << std::endl;
+        return -1;
+    }
+    std::cout << (status.starts_with("FILE ") ? status.substr(5) : status) << std::endl;
+    return 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file decode.cpp
+ * @brief Converts a compact (--format rle) or tiled (--format tiled) file back to the text or raw format.
+ *
+ * Decodes one block of rows at a time with compact::Decoder or tiled::Reader, so memory stays
+ * constant whatever the image size. The output is byte-identical to generating the same image
+ * directly in the target format. Tiled files can also be cut to a rectangle with --region,
+ * which only reads the tiles it overlaps.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "compactformat.hpp"
+#include "filehandler.hpp"
+#include "framebuffer.hpp"
+#include "rowformat.hpp"
+#include "tiledformat.hpp"
+
+namespace {
+    constexpr size_t blockBytes = 4 * 1024 * 1024;   /* Decoded pixels handed to FileHandler at once */
+
+    int usage() {
+        std::cerr << "Usage: program_decode <input_path> <output_path> [--format text|raw] [--region X,Y,W,H]\n"
+                  << "Use - as <input_path> or <output_path> for the standard input or output.\n"
+                  << "--region reads the W x H rectangle at column X, row Y (from the top-left) of a tiled file.\n";
+        return -1;
+    }
+
+    Region parseRegion(const std::string& text) {
+        Region region;
+        char end = 0;
+        unsigned long long values[4] = {};
+        if (std::sscanf(text.c_str(), "%llu,%llu,%llu,%llu%c", &values[0], &values[1], &values[2], &values[3], &end) != 4
+            || text.find('-') != std::string::npos) {
+            throw std::invalid_argument("Region must be X,Y,W,H: " + text);
+        }
+        region.x = values[0];
+        region.y = values[1];
+        region.width = values[2];
+        region.height = values[3];
+        return region;
+    }
+
+    /**
+     * @brief Writes a rectangle of a tiled file, one band of tile rows at a time.
+     */
+    void decodeTiled(const std::string& inputPath, const std::string& outputPath, const OutputFormat format,
+                     const Region* requested) {
+        const tiled::Reader reader(inputPath);
+        const tiled::Header& header = reader.header();
+        const Region region = requested != nullptr ? *requested : Region{0, 0, header.width, header.height};
+        if (region.x > header.width || region.width > header.width - region.x
+            || region.y > header.height || region.height > header.height - region.y) {
+            throw std::invalid_argument("Region exceeds the " + std::to_string(header.width) + " x "
+                                        + std::to_string(header.height) + " image");
+        }
+
+        /* Whole rows of tiles per block, so every tile is decoded once */
+        const size_t rowBytes = std::max<size_t>(1, region.width * sizeof(Pixel));
+        const size_t tileRows = std::max<size_t>(blockBytes / rowBytes / header.tileHeight, 1) * header.tileHeight;
+        const auto blockRows = static_cast<ImageHeight>(std::min<size_t>(tileRows, std::max<ImageHeight>(region.height, 1)));
+        std::vector<Pixel> band(region.width * blockRows);
+        Framebuffer block(region.width, blockRows);
+        FileHandler output(outputPath, format);
+        for (ImageHeight done = 0; done < region.height;) {
+            const ImageHeight rows = std::min<ImageHeight>({region.height - done, blockRows,
+                                                            tileRows - (region.y + done) % header.tileHeight});
+            reader.readRegion(Region{region.x, region.y + done, region.width, rows}, band.data(), region.width);
+            for (ImageHeight row = 0; row < rows; row++) {
+                std::copy_n(band.data() + row * region.width, region.width, block.row(rows - 1 - row));
+            }
+            output.writeRows(block, rows);
+            done += rows;
+        }
+        output.finish();
+    }
+
+    /**
+     * @brief Tells whether the file at path starts like a tiled file; the standard input never does.
+     */
+    bool isTiledFile(const std::string& path) {
+        char start[sizeof(tiled::magic)] = {};
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        return path != "-" && file.read(start, sizeof(start)) && tiled::isTiled(start, sizeof(start));
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3 || argc % 2 == 0) {
+        return usage();
+    }
+    OutputFormat format = OutputFormat::TEXT;
+    try {
+        Region region;
+        bool hasRegion = false;
+        for (int index = 3; index < argc; index += 2) {
+            const std::string option = argv[index];
+            if (option == "--format") {
+                format = rowformat::parse(argv[index + 1]);
+                if (format != OutputFormat::TEXT && format != OutputFormat::RAW) {
+                    throw std::invalid_argument("The output format must be text or raw");
+                }
+            } else if (option == "--region") {
+                region = parseRegion(argv[index + 1]);
+                hasRegion = true;
+            } else {
+                return usage();
+            }
+        }
+
+        const std::string inputPath = argv[1];
+        if (isTiledFile(inputPath)) {
+            decodeTiled(inputPath, argv[2], format, hasRegion ? &region : nullptr);
+            return 0;
+        }
+        if (hasRegion) {
+            throw std::invalid_argument("--region needs a tiled input file");
+        }
+        std::ifstream file;
+        if (inputPath != "-") {
+            file.open(inputPath, std::ios::in | std::ios::binary);
+            if (!file.is_open()) {
+                throw std::ios_base::failure("Could not open file with following path: " + inputPath);
+            }
+        }
+        compact::Decoder decoder(inputPath == "-" ? std::cin : file);
+        const compact::Header& header = decoder.header();
+
+        /* Blocks hold rows bottom-up like the generator's, so the first decoded (top) row goes last */
+        const size_t rowBytes = std::max<size_t>(1, header.width * sizeof(Pixel));
+        const auto blockRows = static_cast<ImageHeight>(std::clamp<size_t>(blockBytes / rowBytes, 1, std::max<ImageHeight>(header.height, 1)));
+        Framebuffer block(header.width, blockRows);
+        FileHandler output(argv[2], format);
+        for (ImageHeight remaining = header.height; remaining > 0;) {
+            const ImageHeight rows = std::min(remaining, blockRows);
+            for (ImageHeight row = rows; row > 0; row--) {
+                if (!decoder.readRow(block.row(row - 1))) {
+                    throw std::runtime_error("The compact file ends before its last row");
+                }
+            }
+            output.writeRows(block, rows);
+            remaining -= rows;
+        }
+        if (!decoder.atEnd()) {
+            throw std::runtime_error("The compact file continues after its last row");
+        }
+        output.finish();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -2,13 +2,14 @@
 #include <memory>
 #include "display.hpp"
 #include "generator.hpp"
-#include "types.hpp"
 
 
 int main(int argc, char *argv[]) {
     try {
-        Generator generator(argc, argv, InterpolationType::BILINEAR);
-        generator.run();
+        Generator generator(argc, argv);
+        if (!generator.run()) {
+            return -1;
+        }
     }
     catch(const std::exception& e) {
         display::error(e.what());